@@ -37,6 +37,10 @@ parted -s misra.hdd mkpart ESP fat32 2048s 100%
 # set ESP flag "on" for partition 1 on misra.hdd
 parted -s misra.hdd set 1 esp on
 
+# Create a 256MB swap disk if there isn't one already.
+# This is attached to qemu as a virtio disk and is used by kernel for swap.
+[ -f swap.img ] || dd if=/dev/zero bs=1M count=0 seek=256 of=swap.img
+
 # Build limine-install.
 # make -C limine
 
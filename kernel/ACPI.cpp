@@ -102,3 +102,36 @@ uint64_t RSDPDescriptor::GetSDTAddress(){
         return v2.xsdtAddress + MEM_PHYS_OFFSET;
     }
 }
+
+// go through rsdt/xsdt and find table
+SDTHeader* FindSDT(const char* signature){
+    if(BootInfo::GetRSDPAddress() == 0){
+        return nullptr;
+    }
+
+    RSDPDescriptorV2* rsdp = reinterpret_cast<RSDPDescriptorV2*>(BootInfo::GetRSDPAddress());
+    uint64_t sdtAddress = (rsdp->revision == 0) ? uint64_t(rsdp->rsdtAddress) : rsdp->xsdtAddress;
+    SDTHeader* sdtHeader = reinterpret_cast<SDTHeader*>(sdtAddress + MEM_PHYS_OFFSET);
+
+    // if rev == 0 then rsdt is used which has 4 bytes for each address
+    // if rev != 0 then xsdt is used which has 8 bytes for each address
+    uint64_t addrsize = (rsdp->revision == 0) ? 4 : 8;
+    uint64_t entries = (sdtHeader->length - sizeof(SDTHeader)) / addrsize;
+    uint64_t tableAddr = reinterpret_cast<uint64_t>(sdtHeader + 1);
+
+    for(uint64_t i = 0; i < entries; i++){
+        uint64_t sdtaddr;
+        if(addrsize == 4){
+            sdtaddr = reinterpret_cast<uint32_t*>(tableAddr)[i] + MEM_PHYS_OFFSET;
+        }else{
+            sdtaddr = reinterpret_cast<uint64_t*>(tableAddr)[i] + MEM_PHYS_OFFSET;
+        }
+
+        SDTHeader* sdt = reinterpret_cast<SDTHeader*>(sdtaddr);
+        if(memcmp(sdt->signature, signature, 4) == 0){
+            return sdt;
+        }
+    }
+
+    return nullptr;
+}
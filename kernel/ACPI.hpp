@@ -94,4 +94,191 @@ struct MCFGHeader : public SDTHeader{
     uint64_t reserved;
 } PACKED_STRUCT;
 
+// Multiple APIC Description Table (signature "APIC")
+// header is followed by variable length entries
+struct MADTHeader : public SDTHeader{
+    uint32_t localAPICAddress;
+    uint32_t flags;
+} PACKED_STRUCT;
+
+// madt flags
+#define MADT_FLAG_PCAT_COMPAT (1 << 0) // dual 8259 pic is also installed
+
+// madt entry types
+enum MADTEntryType : uint8_t {
+    MADT_ENTRY_LOCAL_APIC = 0,
+    MADT_ENTRY_IO_APIC = 1,
+    MADT_ENTRY_INTERRUPT_SOURCE_OVERRIDE = 2,
+    MADT_ENTRY_LOCAL_APIC_ADDRESS_OVERRIDE = 5,
+    MADT_ENTRY_LOCAL_X2APIC = 9
+};
+
+// every madt entry starts with this
+struct MADTEntryHeader {
+    uint8_t type;
+    uint8_t length;
+} PACKED_STRUCT;
+
+// one for each processor
+struct MADTLocalAPIC : public MADTEntryHeader {
+    uint8_t processorID;
+    uint8_t apicID;
+    uint32_t flags;
+} PACKED_STRUCT;
+
+// local apic flags
+#define MADT_LOCAL_APIC_ENABLED (1 << 0)
+#define MADT_LOCAL_APIC_ONLINE_CAPABLE (1 << 1)
+
+// one for each io apic
+struct MADTIOAPIC : public MADTEntryHeader {
+    uint8_t ioAPICID;
+    uint8_t reserved;
+    uint32_t ioAPICAddress;
+    uint32_t globalSystemInterruptBase;
+} PACKED_STRUCT;
+
+// tells how an isa irq is connected to io apic
+struct MADTInterruptSourceOverride : public MADTEntryHeader {
+    uint8_t busSource;
+    uint8_t irqSource;
+    uint32_t globalSystemInterrupt;
+    uint16_t flags;
+} PACKED_STRUCT;
+
+// interrupt source override flags
+#define MADT_ISO_POLARITY_MASK 0b11
+#define MADT_ISO_POLARITY_ACTIVE_LOW 0b11
+#define MADT_ISO_TRIGGER_MASK 0b1100
+#define MADT_ISO_TRIGGER_LEVEL 0b1100
+
+// 64 bit address of local apic
+struct MADTLocalAPICAddressOverride : public MADTEntryHeader {
+    uint16_t reserved;
+    uint64_t localAPICAddress;
+} PACKED_STRUCT;
+
+// processors with apic id >= 255
+struct MADTLocalX2APIC : public MADTEntryHeader {
+    uint16_t reserved;
+    uint32_t x2APICID;
+    uint32_t flags;
+    uint32_t processorUID;
+} PACKED_STRUCT;
+
+// System Resource Affinity Table (signature "SRAT")
+// tells which numa node (proximity domain) each processor and memory range belongs to
+struct SRATHeader : public SDTHeader{
+    uint32_t reserved1;
+    uint64_t reserved2;
+} PACKED_STRUCT;
+
+// srat entry types
+enum SRATEntryType : uint8_t {
+    SRAT_ENTRY_PROCESSOR_AFFINITY = 0,
+    SRAT_ENTRY_MEMORY_AFFINITY = 1,
+    SRAT_ENTRY_X2APIC_AFFINITY = 2
+};
+
+// every srat entry starts with this
+struct SRATEntryHeader {
+    uint8_t type;
+    uint8_t length;
+} PACKED_STRUCT;
+
+// processor with apic id < 255
+struct SRATProcessorAffinity : public SRATEntryHeader {
+    uint8_t proximityDomainLow; // bits 0-7
+    uint8_t apicID;
+    uint32_t flags;
+    uint8_t localSAPICEID;
+    uint8_t proximityDomainHigh[3]; // bits 8-31
+    uint32_t clockDomain;
+} PACKED_STRUCT;
+
+// processor with any apic id
+struct SRATX2APICAffinity : public SRATEntryHeader {
+    uint16_t reserved1;
+    uint32_t proximityDomain;
+    uint32_t x2APICID;
+    uint32_t flags;
+    uint32_t clockDomain;
+    uint32_t reserved2;
+} PACKED_STRUCT;
+
+// processor affinity flags
+#define SRAT_AFFINITY_ENABLED (1 << 0)
+
+// register location used by newer tables
+struct GenericAddress {
+    uint8_t addressSpaceID; // 0 = memory, 1 = i/o port
+    uint8_t registerBitWidth;
+    uint8_t registerBitOffset;
+    uint8_t accessSize;
+    uint64_t address;
+} PACKED_STRUCT;
+
+// generic address space ids
+#define ACPI_ADDRESS_SPACE_MEMORY 0
+#define ACPI_ADDRESS_SPACE_IO 1
+
+// Fixed ACPI Description Table (signature "FACP")
+// only fields up to flags are here, that's all we use
+struct FADTHeader : public SDTHeader {
+    uint32_t firmwareControl;
+    uint32_t dsdt;
+    uint8_t reserved1;
+    uint8_t preferredPowerManagementProfile;
+    uint16_t sciInterrupt;
+    uint32_t smiCommandPort;
+    uint8_t acpiEnable;
+    uint8_t acpiDisable;
+    uint8_t s4BIOSRequest;
+    uint8_t pStateControl;
+    uint32_t pm1aEventBlock;
+    uint32_t pm1bEventBlock;
+    uint32_t pm1aControlBlock;
+    uint32_t pm1bControlBlock;
+    uint32_t pm2ControlBlock;
+    uint32_t pmTimerBlock; // i/o port of pm timer
+    uint32_t gpe0Block;
+    uint32_t gpe1Block;
+    uint8_t pm1EventLength;
+    uint8_t pm1ControlLength;
+    uint8_t pm2ControlLength;
+    uint8_t pmTimerLength; // 4 if pm timer is present
+    uint8_t gpe0Length;
+    uint8_t gpe1Length;
+    uint8_t gpe1Base;
+    uint8_t cStateControl;
+    uint16_t worstC2Latency;
+    uint16_t worstC3Latency;
+    uint16_t flushSize;
+    uint16_t flushStride;
+    uint8_t dutyOffset;
+    uint8_t dutyWidth;
+    uint8_t dayAlarm;
+    uint8_t monthAlarm;
+    uint8_t century;
+    uint16_t bootArchitectureFlags;
+    uint8_t reserved2;
+    uint32_t flags;
+} PACKED_STRUCT;
+
+// fadt flags
+#define FADT_FLAG_TIMER_32BIT (1 << 8) // pm timer counter is 32 bits wide, otherwise 24
+
+// High Precision Event Timer table (signature "HPET")
+struct HPETHeader : public SDTHeader {
+    uint32_t eventTimerBlockID;
+    GenericAddress address;
+    uint8_t hpetNumber;
+    uint16_t minimumTick;
+    uint8_t pageProtection;
+} PACKED_STRUCT;
+
+// find system description table with given 4 character signature
+// returns nullptr if table is not present
+SDTHeader* FindSDT(const char* signature);
+
 #endif // RSDP_HPP
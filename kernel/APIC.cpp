@@ -0,0 +1,428 @@
+/**
+ *@file APIC.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Local APIC and I/O APIC setup using ACPI MADT
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "APIC.hpp"
+#include "ACPI.hpp"
+#include "CPU.hpp"
+#include "Printf.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "IRQ.hpp"
+
+// read local apic register
+uint32_t APIC::ReadLocalAPIC(uint32_t reg){
+    if(isX2APICEnabled){
+        return uint32_t(ReadMSR(X2APIC_MSR_BASE + (reg >> 4)));
+    }
+
+    return *reinterpret_cast<volatile uint32_t*>(localAPICBase + reg);
+}
+
+// write local apic register
+void APIC::WriteLocalAPIC(uint32_t reg, uint32_t value){
+    if(isX2APICEnabled){
+        WriteMSR(X2APIC_MSR_BASE + (reg >> 4), value);
+        return;
+    }
+
+    *reinterpret_cast<volatile uint32_t*>(localAPICBase + reg) = value;
+}
+
+// io apic registers are accessed indirectly through select and window registers
+uint32_t APIC::ReadIOAPIC(const IOAPICInfo& ioapic, uint32_t reg){
+    *reinterpret_cast<volatile uint32_t*>(ioapic.base + IOAPIC_REG_SELECT) = reg;
+    return *reinterpret_cast<volatile uint32_t*>(ioapic.base + IOAPIC_REG_WINDOW);
+}
+
+void APIC::WriteIOAPIC(const IOAPICInfo& ioapic, uint32_t reg, uint32_t value){
+    *reinterpret_cast<volatile uint32_t*>(ioapic.base + IOAPIC_REG_SELECT) = reg;
+    *reinterpret_cast<volatile uint32_t*>(ioapic.base + IOAPIC_REG_WINDOW) = value;
+}
+
+// go through all madt entries
+bool APIC::ParseMADT(){
+    MADTHeader* madt = reinterpret_cast<MADTHeader*>(FindSDT("APIC"));
+    if(madt == nullptr){
+        Printf("[!] MADT not found\n");
+        return false;
+    }
+
+    uint64_t localAPICPhysical = madt->localAPICAddress;
+
+    // legacy irqs are identity mapped unless overriden
+    for(uint8_t i = 0; i < APIC_NUM_ISA_IRQS; i++){
+        isaIRQToGSI[i] = i;
+        isaIRQFlags[i] = 0;
+    }
+
+    uint64_t entry = reinterpret_cast<uint64_t>(madt + 1);
+    uint64_t end = reinterpret_cast<uint64_t>(madt) + madt->length;
+    while(entry < end){
+        MADTEntryHeader* header = reinterpret_cast<MADTEntryHeader*>(entry);
+        if(header->length == 0) break;
+
+        switch(header->type){
+        case MADT_ENTRY_LOCAL_APIC: {
+            MADTLocalAPIC* lapic = reinterpret_cast<MADTLocalAPIC*>(header);
+            if((lapic->flags & (MADT_LOCAL_APIC_ENABLED | MADT_LOCAL_APIC_ONLINE_CAPABLE)) &&
+               (numLocalAPICs < APIC_MAX_LOCAL_APICS)){
+                localAPICIDs[numLocalAPICs++] = lapic->apicID;
+            }
+            break;
+        }
+        case MADT_ENTRY_LOCAL_X2APIC: {
+            MADTLocalX2APIC* x2apic = reinterpret_cast<MADTLocalX2APIC*>(header);
+            if((x2apic->flags & (MADT_LOCAL_APIC_ENABLED | MADT_LOCAL_APIC_ONLINE_CAPABLE)) &&
+               (numLocalAPICs < APIC_MAX_LOCAL_APICS)){
+                localAPICIDs[numLocalAPICs++] = x2apic->x2APICID;
+            }
+            break;
+        }
+        case MADT_ENTRY_IO_APIC: {
+            MADTIOAPIC* ioapic = reinterpret_cast<MADTIOAPIC*>(header);
+            if(numIOAPICs < APIC_MAX_IO_APICS){
+                IOAPICInfo& info = ioAPICs[numIOAPICs++];
+                info.id = ioapic->ioAPICID;
+                info.gsiBase = ioapic->globalSystemInterruptBase;
+                info.base = GetDefaultVirtualMemoryManager().MapDeviceMemory(ioapic->ioAPICAddress, PAGE_SIZE);
+                info.numEntries = ((ReadIOAPIC(info, IOAPIC_REG_VERSION) >> 16) & 0xff) + 1;
+            }
+            break;
+        }
+        case MADT_ENTRY_INTERRUPT_SOURCE_OVERRIDE: {
+            MADTInterruptSourceOverride* iso = reinterpret_cast<MADTInterruptSourceOverride*>(header);
+            if(iso->irqSource < APIC_NUM_ISA_IRQS){
+                isaIRQToGSI[iso->irqSource] = iso->globalSystemInterrupt;
+                isaIRQFlags[iso->irqSource] = iso->flags;
+            }
+            break;
+        }
+        case MADT_ENTRY_LOCAL_APIC_ADDRESS_OVERRIDE: {
+            localAPICPhysical = reinterpret_cast<MADTLocalAPICAddressOverride*>(header)->localAPICAddress;
+            break;
+        }
+        default:
+            break;
+        }
+
+        entry += header->length;
+    }
+
+    if(numIOAPICs == 0){
+        Printf("[!] MADT doesn't have any I/O APIC\n");
+        return false;
+    }
+
+    localAPICBase = GetDefaultVirtualMemoryManager().MapDeviceMemory(localAPICPhysical, PAGE_SIZE);
+
+    Printf("[+] MADT : %lu processors, %lu I/O APICs, Local APIC at %lx\n",
+           numLocalAPICs, numIOAPICs, localAPICPhysical);
+
+    return true;
+}
+
+// bring up apic
+bool APIC::Initialize(){
+    if(!ParseMADT()){
+        return false;
+    }
+
+    // mask all redirection entries before enabling anything
+    for(size_t i = 0; i < numIOAPICs; i++){
+        for(uint32_t e = 0; e < ioAPICs[i].numEntries; e++){
+            SetRedirectionEntry(ioAPICs[i].gsiBase + e, IOAPIC_REDIRECTION_MASKED);
+        }
+    }
+
+    EnableLocalAPIC();
+
+    isEnabled = true;
+    Printf("[+] Local APIC %u enabled\n", GetLocalAPICID());
+
+    return true;
+}
+
+// enable local apic of current cpu
+void APIC::EnableLocalAPIC(){
+    // firmware usually has this set already
+    WriteMSR(MSR_APIC_BASE, ReadMSR(MSR_APIC_BASE) | APIC_BASE_GLOBAL_ENABLE);
+
+    // x2apic can only be entered from enabled xapic mode
+    if(isX2APICEnabled){
+        WriteMSR(MSR_APIC_BASE, ReadMSR(MSR_APIC_BASE) | APIC_BASE_X2APIC_ENABLE);
+    }
+
+    // accept all interrupts and enable local apic
+    WriteLocalAPIC(LAPIC_REG_TASK_PRIORITY, 0);
+    WriteLocalAPIC(LAPIC_REG_SPURIOUS, LAPIC_SPURIOUS_ENABLE | APIC_SPURIOUS_VECTOR);
+}
+
+// application processor
+bool APIC::InitializeCpu(){
+    if(!isEnabled){
+        return false;
+    }
+
+    EnableLocalAPIC();
+    return true;
+}
+
+// timer mode
+void APIC::SetupTimer(uint32_t lvt){
+    WriteLocalAPIC(LAPIC_REG_TIMER_INITIAL_COUNT, 0);
+    WriteLocalAPIC(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    WriteLocalAPIC(LAPIC_REG_LVT_TIMER, lvt);
+
+    // in x2apic mode lvt write isn't serializing, deadline msr
+    // must not be written before new mode takes effect
+    if(lvt & LAPIC_TIMER_TSC_DEADLINE){
+        asm volatile("mfence" ::: "memory");
+    }
+}
+
+// writing initial count starts the timer
+void APIC::ArmTimer(uint32_t count){
+    WriteLocalAPIC(LAPIC_REG_TIMER_INITIAL_COUNT, count);
+}
+
+// current count
+uint32_t APIC::GetTimerCount(){
+    return ReadLocalAPIC(LAPIC_REG_TIMER_CURRENT_COUNT);
+}
+
+// switch to x2apic
+bool APIC::EnableX2APIC(){
+    if(!isEnabled){
+        return false;
+    }
+
+    if(isX2APICEnabled){
+        return true;
+    }
+
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(1, 0, eax, ebx, ecx, edx);
+    if(!(ecx & CPUID_1_ECX_X2APIC)){
+        return false;
+    }
+
+    // nothing must touch local apic while mode is changing
+    uint64_t rflags = SaveAndDisableInterrupts();
+    WriteMSR(MSR_APIC_BASE, ReadMSR(MSR_APIC_BASE) | APIC_BASE_GLOBAL_ENABLE | APIC_BASE_X2APIC_ENABLE);
+    isX2APICEnabled = true;
+    RestoreInterrupts(rflags);
+
+    Printf("[+] Local APIC %u switched to x2APIC mode\n", GetLocalAPICID());
+    return true;
+}
+
+// apic id is in top 8 bits of id register in xapic mode
+// and whole register in x2apic mode
+uint32_t APIC::GetLocalAPICID(){
+    if(isX2APICEnabled){
+        return ReadLocalAPIC(LAPIC_REG_ID);
+    }
+
+    return ReadLocalAPIC(LAPIC_REG_ID) >> 24;
+}
+
+// icr is a single 64 bit msr in x2apic mode, two registers in xapic mode
+void APIC::WriteICR(uint32_t destination, uint32_t command){
+    if(isX2APICEnabled){
+        WriteMSR(X2APIC_MSR_BASE + (LAPIC_REG_ICR_LOW >> 4), (uint64_t(destination) << 32) | command);
+        return;
+    }
+
+    // writing low half sends the ipi, so high half goes first
+    // an interrupt handler sending it's own ipi in between would overwrite high half
+    uint64_t rflags = SaveAndDisableInterrupts();
+    WriteLocalAPIC(LAPIC_REG_ICR_HIGH, destination << 24);
+    WriteLocalAPIC(LAPIC_REG_ICR_LOW, command);
+    while(ReadLocalAPIC(LAPIC_REG_ICR_LOW) & LAPIC_ICR_DELIVERY_PENDING){
+        asm volatile("pause");
+    }
+    RestoreInterrupts(rflags);
+}
+
+// fixed delivery mode, physical destination
+void APIC::SendIPI(uint32_t apicID, uint8_t vector){
+    WriteICR(apicID, LAPIC_ICR_LEVEL_ASSERT | vector);
+}
+
+// x2apic has a dedicated register for this
+void APIC::SendSelfIPI(uint8_t vector){
+    if(isX2APICEnabled){
+        WriteMSR(X2APIC_MSR_SELF_IPI, vector);
+        return;
+    }
+
+    WriteICR(0, LAPIC_ICR_LEVEL_ASSERT | LAPIC_ICR_DESTINATION_SELF | vector);
+}
+
+// number of self ipis received, incremented by benchmark handler
+static volatile uint64_t benchmarkIPICount = 0;
+
+// receives self ipis sent by benchmark
+static bool BenchmarkInterruptHandler(InterruptContext* frame, void* context){
+    (void)frame;
+    (void)context;
+    benchmarkIPICount = benchmarkIPICount + 1;
+    return true;
+}
+
+// measure current mode
+void APIC::RunBenchmark(){
+    const char* mode = isX2APICEnabled ? "x2APIC" : "xAPIC";
+
+    // eoi cost, writing eoi with nothing in service is harmless
+    uint64_t start = ReadTSC();
+    for(uint64_t i = 0; i < APIC_BENCHMARK_ITERATIONS; i++){
+        EndOfInterrupt();
+    }
+    uint64_t eoiCycles = (ReadTSC() - start) / APIC_BENCHMARK_ITERATIONS;
+
+    // self ipi round trip : send, go through dispatcher, eoi and return
+    uint64_t total = 0, minCycles = ~uint64_t(0), maxCycles = 0;
+    for(uint64_t i = 0; i < APIC_BENCHMARK_ITERATIONS; i++){
+        uint64_t expected = benchmarkIPICount + 1;
+        uint64_t t0 = ReadTSC();
+        SendSelfIPI(APIC_BENCHMARK_VECTOR);
+        while(benchmarkIPICount != expected){
+            asm volatile("pause");
+        }
+        uint64_t cycles = ReadTSC() - t0;
+
+        total += cycles;
+        if(cycles < minCycles) minCycles = cycles;
+        if(cycles > maxCycles) maxCycles = cycles;
+    }
+
+    Printf("[+] %s : EOI %lu cycles, self IPI round trip avg %lu min %lu max %lu cycles\n",
+           mode, eoiCycles, total / APIC_BENCHMARK_ITERATIONS, minCycles, maxCycles);
+}
+
+// benchmark both modes
+void APIC::Benchmark(){
+    if(!isEnabled){
+        return;
+    }
+
+    RegisterIrqHandler(APIC_BENCHMARK_VECTOR, BenchmarkInterruptHandler, nullptr);
+
+    // round trip needs interrupts
+    asm volatile("sti");
+
+    RunBenchmark();
+    if(!isX2APICEnabled && EnableX2APIC()){
+        RunBenchmark();
+    }
+
+    UnregisterIrqHandler(APIC_BENCHMARK_VECTOR, BenchmarkInterruptHandler, nullptr);
+}
+
+// write redirection entry in io apic handling this gsi
+void APIC::SetRedirectionEntry(uint32_t gsi, uint64_t entry){
+    for(size_t i = 0; i < numIOAPICs; i++){
+        IOAPICInfo& ioapic = ioAPICs[i];
+        if((gsi >= ioapic.gsiBase) && (gsi < ioapic.gsiBase + ioapic.numEntries)){
+            uint32_t reg = IOAPIC_REG_REDIRECTION_TABLE + 2 * (gsi - ioapic.gsiBase);
+            // keep it masked while it's half written
+            WriteIOAPIC(ioapic, reg, IOAPIC_REDIRECTION_MASKED);
+            WriteIOAPIC(ioapic, reg + 1, uint32_t(entry >> 32));
+            WriteIOAPIC(ioapic, reg, uint32_t(entry));
+            return;
+        }
+    }
+
+    Printf("[!] No I/O APIC handles GSI %u\n", gsi);
+}
+
+// toggle mask bit only
+void APIC::SetRedirectionMask(uint32_t gsi, bool mask){
+    for(size_t i = 0; i < numIOAPICs; i++){
+        IOAPICInfo& ioapic = ioAPICs[i];
+        if((gsi >= ioapic.gsiBase) && (gsi < ioapic.gsiBase + ioapic.numEntries)){
+            uint32_t reg = IOAPIC_REG_REDIRECTION_TABLE + 2 * (gsi - ioapic.gsiBase);
+            uint32_t low = ReadIOAPIC(ioapic, reg);
+            if(mask){
+                low |= IOAPIC_REDIRECTION_MASKED;
+            }else{
+                low &= ~uint32_t(IOAPIC_REDIRECTION_MASKED);
+            }
+            WriteIOAPIC(ioapic, reg, low);
+            return;
+        }
+    }
+}
+
+// isa irq to gsi
+uint32_t APIC::GetGSI(uint8_t irq, uint64_t& flags){
+    flags = 0;
+    if(irq >= APIC_NUM_ISA_IRQS){
+        return irq;
+    }
+
+    // isa interrupts are active high and edge triggered unless told otherwise
+    if((isaIRQFlags[irq] & MADT_ISO_POLARITY_MASK) == MADT_ISO_POLARITY_ACTIVE_LOW){
+        flags |= IOAPIC_REDIRECTION_ACTIVE_LOW;
+    }
+    if((isaIRQFlags[irq] & MADT_ISO_TRIGGER_MASK) == MADT_ISO_TRIGGER_LEVEL){
+        flags |= IOAPIC_REDIRECTION_LEVEL_TRIGGERED;
+    }
+
+    return isaIRQToGSI[irq];
+}
+
+// fixed delivery, physical destination
+void APIC::RouteIRQ(uint8_t irq, uint8_t vector){
+    uint64_t flags;
+    uint32_t gsi = GetGSI(irq, flags);
+
+    uint64_t entry = vector | flags | (uint64_t(GetLocalAPICID()) << 56);
+    SetRedirectionEntry(gsi, entry);
+}
+
+// mask irq
+void APIC::MaskIRQ(uint8_t irq, bool mask){
+    uint64_t flags;
+    uint32_t gsi = GetGSI(irq, flags);
+    SetRedirectionMask(gsi, mask);
+}
+
+// writing anything to eoi register completes the interrupt
+void APIC::EndOfInterrupt(){
+    WriteLocalAPIC(LAPIC_REG_EOI, 0);
+}
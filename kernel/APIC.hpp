@@ -0,0 +1,232 @@
+/**
+ *@file APIC.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Local APIC and I/O APIC setup using ACPI MADT
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef APIC_HPP
+#define APIC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Common.hpp"
+
+// isa irqs are delivered at these vectors, same as remapped pic
+#define IRQ_VECTOR_BASE 0x20
+// vector used by local apic for spurious interrupts
+#define APIC_SPURIOUS_VECTOR 0xff
+// vector used by self ipi benchmark
+#define APIC_BENCHMARK_VECTOR 0xf0
+// vector used by local apic timer
+#define APIC_TIMER_VECTOR 0xf1
+// vector used to wake up an idle cpu when there's work for it
+#define APIC_RESCHEDULE_VECTOR 0xf2
+// vector used to flush stale tlb entries on other cpus (see Tlb.hpp)
+#define APIC_TLB_SHOOTDOWN_VECTOR 0xf3
+// number of iterations in each benchmark
+#define APIC_BENCHMARK_ITERATIONS 1000
+
+// limits on what we keep from madt
+#define APIC_MAX_IO_APICS 16
+#define APIC_MAX_LOCAL_APICS 256
+#define APIC_NUM_ISA_IRQS 16
+
+// local apic registers (offsets from base)
+#define LAPIC_REG_ID 0x20
+#define LAPIC_REG_VERSION 0x30
+#define LAPIC_REG_TASK_PRIORITY 0x80
+#define LAPIC_REG_EOI 0xb0
+#define LAPIC_REG_SPURIOUS 0xf0
+#define LAPIC_REG_ICR_LOW 0x300
+#define LAPIC_REG_ICR_HIGH 0x310
+#define LAPIC_REG_LVT_TIMER 0x320
+#define LAPIC_REG_TIMER_INITIAL_COUNT 0x380
+#define LAPIC_REG_TIMER_CURRENT_COUNT 0x390
+#define LAPIC_REG_TIMER_DIVIDE 0x3e0
+
+// in x2apic mode registers are msrs starting from here
+// msr = base + (mmio offset >> 4)
+#define X2APIC_MSR_BASE 0x800
+// x2apic only register, sends ipi to self with single write
+#define X2APIC_MSR_SELF_IPI 0x83f
+
+// spurious interrupt vector register bits
+#define LAPIC_SPURIOUS_ENABLE (1 << 8)
+
+// timer lvt bits
+#define LAPIC_TIMER_MASKED (1 << 16)
+#define LAPIC_TIMER_ONE_SHOT (0b00 << 17)
+#define LAPIC_TIMER_TSC_DEADLINE (0b10 << 17) // fires when tsc reaches value in MSR_TSC_DEADLINE
+
+// timer divide configuration, counter runs at bus clock / 16
+#define LAPIC_TIMER_DIVIDE_BY_16 0x3
+
+// interrupt command register bits
+#define LAPIC_ICR_DELIVERY_PENDING (1 << 12)
+#define LAPIC_ICR_LEVEL_ASSERT (1 << 14)
+#define LAPIC_ICR_DESTINATION_SELF (0b01 << 18)
+
+// io apic registers
+#define IOAPIC_REG_SELECT 0x00
+#define IOAPIC_REG_WINDOW 0x10
+#define IOAPIC_REG_VERSION 0x01
+#define IOAPIC_REG_REDIRECTION_TABLE 0x10
+
+// redirection entry bits
+#define IOAPIC_REDIRECTION_ACTIVE_LOW (1 << 13)
+#define IOAPIC_REDIRECTION_LEVEL_TRIGGERED (1 << 15)
+#define IOAPIC_REDIRECTION_MASKED (1 << 16)
+
+// an io apic found in madt
+struct IOAPICInfo {
+    uint8_t id;
+    uint64_t base; // virtual address of registers
+    uint32_t gsiBase; // first global system interrupt handled by this
+    uint32_t numEntries; // number of redirection entries
+};
+
+// Local APIC receives interrupts for a cpu and I/O APIC routes device
+// interrupts to local apics. Both are described by ACPI MADT.
+// Once enabled, all isa interrupts go through io apic and 8259 pic is masked.
+// End of interrupt is a single mmio write to local apic.
+//
+// If cpu supports x2apic, local apic can be switched to it. Registers are then
+// accessed through msrs instead of mmio and interrupt command register is a single
+// 64 bit msr, so ipis don't need two writes anymore.
+struct APIC {
+    // parse madt, enable local apic of this cpu and setup io apics
+    // returns false if there's no apic, in which case pic should be used
+    static bool Initialize();
+
+    // is apic in use
+    static bool IsEnabled(){ return isEnabled; }
+
+    // enable local apic of an application processor in same mode as boot cpu
+    static bool InitializeCpu();
+
+    // switch local apic of this cpu to x2apic mode if supported
+    // returns true if x2apic is in use after this call
+    static bool EnableX2APIC();
+
+    // is local apic in x2apic mode
+    static bool IsX2APICEnabled(){ return isX2APICEnabled; }
+
+    // route an isa irq to given vector on this cpu
+    // interrupt source overrides from madt are taken into account
+    static void RouteIRQ(uint8_t irq, uint8_t vector);
+
+    // mask/unmask an isa irq, vector and destination are kept
+    // only low half of redirection entry is touched, so this is cheap enough to do per interrupt
+    static void MaskIRQ(uint8_t irq, bool mask);
+
+    // signal end of interrupt to local apic
+    static void EndOfInterrupt();
+
+    // id of local apic of the cpu executing this
+    static uint32_t GetLocalAPICID();
+
+    // processors found in madt
+    static size_t GetNumLocalAPICs(){ return numLocalAPICs; }
+    static uint32_t GetLocalAPICIDAt(size_t idx){ return localAPICIDs[idx]; }
+
+    // read/write a local apic register
+    // reg is always mmio offset, it's converted to msr in x2apic mode
+    static uint32_t ReadLocalAPIC(uint32_t reg);
+    static void WriteLocalAPIC(uint32_t reg, uint32_t value);
+
+    // send fixed interrupt to cpu with given apic id
+    static void SendIPI(uint32_t apicID, uint8_t vector);
+
+    // send fixed interrupt to this cpu
+    static void SendSelfIPI(uint8_t vector);
+
+    // set mode and vector of local apic timer of this cpu (lvt timer register)
+    // counter is always divided by 16, timer stays idle until it's armed
+    static void SetupTimer(uint32_t lvt);
+
+    // one shot mode : fire after count timer ticks, 0 stops timer
+    static void ArmTimer(uint32_t count);
+
+    // ticks left before timer fires
+    static uint32_t GetTimerCount();
+
+    // measure eoi and self ipi round trip cost in current mode
+    // if x2apic is supported but not enabled yet, it's enabled and measured too
+    static void Benchmark();
+
+private:
+    // enable local apic of current cpu
+    static void EnableLocalAPIC();
+
+    // parse madt entries
+    static bool ParseMADT();
+
+    // io apic register access
+    static uint32_t ReadIOAPIC(const IOAPICInfo& ioapic, uint32_t reg);
+    static void WriteIOAPIC(const IOAPICInfo& ioapic, uint32_t reg, uint32_t value);
+
+    // write a redirection entry for given global system interrupt
+    static void SetRedirectionEntry(uint32_t gsi, uint64_t entry);
+
+    // set/clear mask bit of redirection entry for given global system interrupt
+    static void SetRedirectionMask(uint32_t gsi, bool mask);
+
+    // translate isa irq to gsi and redirection flags
+    static uint32_t GetGSI(uint8_t irq, uint64_t& flags);
+
+    // write interrupt command register
+    static void WriteICR(uint32_t destination, uint32_t command);
+
+    // measure current mode
+    static void RunBenchmark();
+
+    static inline bool isEnabled = false;
+    static inline bool isX2APICEnabled = false;
+
+    // local apic registers (virtual address)
+    static inline uint64_t localAPICBase = 0;
+
+    // io apics
+    static inline IOAPICInfo ioAPICs[APIC_MAX_IO_APICS] = {};
+    static inline size_t numIOAPICs = 0;
+
+    // isa irq to gsi mapping, identity unless overriden
+    static inline uint32_t isaIRQToGSI[APIC_NUM_ISA_IRQS] = {};
+    static inline uint16_t isaIRQFlags[APIC_NUM_ISA_IRQS] = {};
+
+    // cpus
+    static inline uint32_t localAPICIDs[APIC_MAX_LOCAL_APICS] = {};
+    static inline size_t numLocalAPICs = 0;
+};
+
+#endif // APIC_HPP
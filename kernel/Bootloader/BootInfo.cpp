@@ -36,6 +36,7 @@
 
 #include "BootInfo.hpp"
 #include "Util.hpp"
+#include "../Common.hpp"
 
 static BootInfo bootInfo = {};
 
@@ -44,7 +45,7 @@ BootInfo::BootInfo(stivale2_struct* stivaleTagList){
     stivale2_struct_tag_framebuffer *fb_tag = reinterpret_cast<stivale2_struct_tag_framebuffer*>(GetStivaleTag(stivaleTagList, STIVALE2_STRUCT_TAG_FRAMEBUFFER_ID));
     // stivale 2 spec states that bootloader will boot even if the framebuffer wasn't found!
     if (fb_tag == nullptr) {
-        while(true)asm("hlt");
+        EternalHalt();
     }
 
 
@@ -64,6 +65,15 @@ BootInfo::BootInfo(stivale2_struct* stivaleTagList){
 
     // get rsdp
     rsdp_addr = reinterpret_cast<stivale2_struct_tag_rsdp*>(GetStivaleTag(stivaleTagList, STIVALE2_STRUCT_TAG_RSDP_ID))->rsdp;
+
+    // get higher half direct map base, default is the 4 level paging one
+    stivale2_struct_tag_hhdm *hhdm_tag = reinterpret_cast<stivale2_struct_tag_hhdm*>(GetStivaleTag(stivaleTagList, STIVALE2_STRUCT_TAG_HHDM_ID));
+    if(hhdm_tag != nullptr){
+        higherHalfOffset = hhdm_tag->addr;
+    }
+
+    // application processors
+    smp_tag = reinterpret_cast<stivale2_struct_tag_smp*>(GetStivaleTag(stivaleTagList, STIVALE2_STRUCT_TAG_SMP_ID));
 }
 
 uint64_t BootInfo::GetFramebufferAddress(){ return fbAddr; }
@@ -78,3 +88,5 @@ uint64_t BootInfo::GetMemmapCount(){ return memmap_tag->entries; }
 MemMapEntry* BootInfo::GetMemmap(){ return memmap_tag->memmap; }
 
 uint64_t BootInfo::GetRSDPAddress(){ return rsdp_addr; }
+
+stivale2_struct_tag_smp* BootInfo::GetSMPInfo(){ return smp_tag; }
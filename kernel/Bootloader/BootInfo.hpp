@@ -60,6 +60,14 @@ struct BootInfo {
     static MemMapEntry* GetMemmap();
 
     static uint64_t GetRSDPAddress();
+
+    // base of higher half direct map of physical memory, set while tags are parsed
+    // this moves when bootloader enables 5 level paging
+    // MEM_PHYS_OFFSET reads it directly, so direct map translations don't pay for a call
+    static inline uint64_t higherHalfOffset = 0xffff800000000000;
+
+    // processors started by bootloader, nullptr if bootloader didn't give smp info
+    static stivale2_struct_tag_smp* GetSMPInfo();
 private:
     // framebuffer information
     static inline uint64_t fbAddr = 0;
@@ -74,6 +82,9 @@ private:
     // store memory region related data
     static inline stivale2_struct_tag_memmap* memmap_tag = nullptr;
 
+    // smp information
+    static inline stivale2_struct_tag_smp* smp_tag = nullptr;
+
     // store rsdp addr
     static inline uint64_t rsdp_addr;
 };
@@ -38,6 +38,8 @@
 #include "Util.hpp"
 
 #include "../Renderer/FontRenderer.hpp"
+#include "../PerCpu.hpp"
+#include "../SMP.hpp"
 
 // declare kenrel entry here and define it in KernelEntry.cpp
 void KernelEntry();
@@ -48,6 +50,10 @@ void KernelEntry();
 // this is just an approach to not make this bootloader a viral component of this kernel
 // we can remove this anytime approach
 extern "C" [[noreturn]] void Entry(stivale2_struct* tagList){
+    // boot cpu's per cpu data, even string formatting depends on this
+    // apic id is filled in later (see SMP.cpp)
+    InitializeCpuData(0, 0);
+
     // initialize this variable just to init boot info
     // this will load all things required by kernel to this struct
     // and then kernel can access parts from this
@@ -59,8 +65,6 @@ extern "C" [[noreturn]] void Entry(stivale2_struct* tagList){
     // handover control to kernel
     KernelEntry();
 
-    // hang if the kernel returns
-    while(true){
-        asm volatile("hlt");
-    }
+    // kernel shouldn't return, if it does this cpu just idles and serves interrupts
+    CpuIdleLoop();
 }
@@ -43,6 +43,30 @@
 #define STACK_SIZE (32*KB)
 static uint8_t stack[STACK_SIZE];
 
+#ifdef ENABLE_5_LEVEL_PAGING
+// ask bootloader to enable 5 level paging, this is only done
+// if cpu supports it, so kernel must check what it got (see VirtualMemoryManager)
+static struct stivale2_tag la57_hdr_tag = {
+    .identifier = STIVALE2_HEADER_TAG_5LV_PAGING_ID,
+    .next = NULLADDR
+};
+#define SMP_HDR_TAG_NEXT (uintptr_t)&la57_hdr_tag
+#else
+#define SMP_HDR_TAG_NEXT NULLADDR
+#endif
+
+// ask bootloader to start application processors, they wait in bootloader
+// until we give them a stack and an address to jump to (see SMP.cpp)
+// flags = 0 : don't enable x2apic, kernel switches all cpus itself
+static struct stivale2_header_tag_smp smp_hdr_tag = {
+    .tag = {
+        .identifier = STIVALE2_HEADER_TAG_SMP_ID,
+        .next = SMP_HDR_TAG_NEXT
+    },
+    .flags = 0
+};
+#define FRAMEBUFFER_HDR_TAG_NEXT (uintptr_t)&smp_hdr_tag
+
 // we need a framebuffer from stivale on bootup so we
 // need to tell stivale that we need a framebuffer instead of
 // CGA-compatible text mode.
@@ -50,8 +74,8 @@ static struct stivale2_header_tag_framebuffer framebuffer_hdr_tag = {
     .tag = {
         // which type of tag is this
         .identifier = STIVALE2_HEADER_TAG_FRAMEBUFFER_ID,
-        // this must be a pointer address, NULL in this case
-        .next = NULLADDR
+        // this must be a pointer address, NULL if this is the last tag
+        .next = FRAMEBUFFER_HDR_TAG_NEXT
     },
     // set all framebuffer specifics to 0 and let bootloader decide
     .framebuffer_width = 0,
@@ -0,0 +1,202 @@
+/**
+ *@file CPU.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Small wrappers around cpu instructions used all over the kernel
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CPU_HPP
+#define CPU_HPP
+
+#include <cstdint>
+
+// these are kept inline because most of them are used in hot paths
+// (fault handlers, interrupt handlers etc...) and are just a single instruction
+
+// cr0 bits
+#define CR0_WRITE_PROTECT (uint64_t(1) << 16) // supervisor can't write to read only pages
+
+// cr4 bits
+#define CR4_LA57 (uint64_t(1) << 12) // 5 level paging is active
+
+// model specific registers
+#define MSR_EFER uint32_t(0xc0000080)
+#define MSR_APIC_BASE uint32_t(0x1b)
+#define MSR_GS_BASE uint32_t(0xc0000101)
+#define MSR_KERNEL_GS_BASE uint32_t(0xc0000102)
+#define MSR_TSC_DEADLINE uint32_t(0x6e0)
+
+// apic base msr bits
+#define APIC_BASE_X2APIC_ENABLE (uint64_t(1) << 10)
+#define APIC_BASE_GLOBAL_ENABLE (uint64_t(1) << 11)
+
+// rflags bits
+#define RFLAGS_INTERRUPT_ENABLE (uint64_t(1) << 9)
+
+// efer bits
+#define EFER_NO_EXECUTE_ENABLE (uint64_t(1) << 11) // allow setting nx bit in pages
+
+// cpuid feature bits
+#define CPUID_EXT_EDX_NO_EXECUTE (uint32_t(1) << 20) // leaf 0x80000001
+#define CPUID_7_ECX_LA57 (uint32_t(1) << 16) // leaf 7, 5 level paging
+#define CPUID_1_ECX_MONITOR (uint32_t(1) << 3) // leaf 1, monitor/mwait
+#define CPUID_1_ECX_X2APIC (uint32_t(1) << 21) // leaf 1
+#define CPUID_5_ECX_EXTENSIONS (uint32_t(1) << 0) // leaf 5, edx lists mwait c-states
+#define CPUID_6_EAX_ARAT (uint32_t(1) << 2) // leaf 6, apic timer keeps running in deep c-states
+#define CPUID_1_ECX_TSC_DEADLINE (uint32_t(1) << 24) // leaf 1, local apic timer has tsc deadline mode
+#define CPUID_80000007_EDX_INVARIANT_TSC (uint32_t(1) << 8) // tsc rate doesn't change with p/c states
+
+// execute cpuid for given leaf and subleaf
+inline void CPUID(uint32_t leaf, uint32_t subleaf, uint32_t& eax, uint32_t& ebx, uint32_t& ecx, uint32_t& edx){
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(leaf), "c"(subleaf));
+}
+
+// read model specific register
+inline uint64_t ReadMSR(uint32_t msr){
+    uint32_t low, high;
+    asm volatile("rdmsr"
+                 : "=a"(low), "=d"(high)
+                 : "c"(msr));
+    return (uint64_t(high) << 32) | low;
+}
+
+// write model specific register
+inline void WriteMSR(uint32_t msr, uint64_t value){
+    asm volatile("wrmsr"
+                 :
+                 : "c"(msr), "a"(uint32_t(value)), "d"(uint32_t(value >> 32))
+                 : "memory");
+}
+
+// read cr0 register
+inline uint64_t ReadCR0(){
+    uint64_t cr0;
+    asm volatile("mov %%cr0, %0"
+                 : "=r"(cr0));
+    return cr0;
+}
+
+// write cr0 register
+inline void WriteCR0(uint64_t cr0){
+    asm volatile("mov %0, %%cr0"
+                 :
+                 : "r"(cr0)
+                 : "memory");
+}
+
+// read cr4 register
+inline uint64_t ReadCR4(){
+    uint64_t cr4;
+    asm volatile("mov %%cr4, %0"
+                 : "=r"(cr4));
+    return cr4;
+}
+
+// disable interrupts and return previous rflags
+inline uint64_t SaveAndDisableInterrupts(){
+    uint64_t rflags;
+    asm volatile("pushfq\n"
+                 "pop %0\n"
+                 "cli"
+                 : "=r"(rflags)
+                 :
+                 : "memory");
+    return rflags;
+}
+
+// enable interrupts again if they were enabled when rflags was saved
+inline void RestoreInterrupts(uint64_t rflags){
+    if(rflags & RFLAGS_INTERRUPT_ENABLE){
+        asm volatile("sti" ::: "memory");
+    }
+}
+
+// watch cache line containing address, a write to it ends next mwait
+inline void Monitor(const volatile void* address){
+    asm volatile("monitor"
+                 :
+                 : "a"(address), "c"(0), "d"(0)
+                 : "memory");
+}
+
+// enable interrupts and wait in c-state given by hint until an interrupt or a write to
+// monitored line, sti delays interrupts by one instruction so none is missed before mwait
+inline void StiMwait(uint32_t hint){
+    asm volatile("sti; mwait"
+                 :
+                 : "a"(hint), "c"(0)
+                 : "memory");
+}
+
+// same with interrupts left disabled, only a write to monitored line (or nmi) ends it
+inline void Mwait(uint32_t hint){
+    asm volatile("mwait"
+                 :
+                 : "a"(hint), "c"(0)
+                 : "memory");
+}
+
+// read time stamp counter
+inline uint64_t ReadTSC(){
+    uint32_t low, high;
+    asm volatile("rdtsc"
+                 : "=a"(low), "=d"(high));
+    return (uint64_t(high) << 32) | low;
+}
+
+// read the address that caused last page fault
+inline uint64_t ReadCR2(){
+    uint64_t cr2;
+    asm volatile("mov %%cr2, %0"
+                 : "=r"(cr2));
+    return cr2;
+}
+
+// read physical address of current page map root
+inline uint64_t ReadCR3(){
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0"
+                 : "=r"(cr3));
+    return cr3;
+}
+
+// flush tlb entry for page containing given virtual address
+inline void InvalidatePage(uint64_t vaddr){
+    asm volatile("invlpg (%0)"
+                 :
+                 : "r"(vaddr)
+                 : "memory");
+}
+
+#endif // CPU_HPP
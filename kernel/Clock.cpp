@@ -0,0 +1,180 @@
+/**
+ *@file Clock.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief TSC based monotonic clock calibrated against HPET, PM timer or PIT
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Clock.hpp"
+#include "ACPI.hpp"
+#include "IO.hpp"
+#include "Printf.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "PhysicalMemoryManager.hpp"
+
+// main counter
+uint64_t Clock::ReadHPET(){
+    return *reinterpret_cast<volatile uint64_t*>(hpetBase + HPET_REG_MAIN_COUNTER);
+}
+
+// 24 or 32 bit counter
+uint64_t Clock::ReadPMTimer(){
+    return PortReadDword(pmTimerPort);
+}
+
+// pit counts down, flip it so that it looks like it's counting up
+uint64_t Clock::ReadPIT(){
+    PortWriteByte(PIT_COMMAND, PIT_COMMAND_CHANNEL2_LATCH);
+    uint8_t low = PortReadByte(PIT_CHANNEL2_DATA);
+    uint8_t high = PortReadByte(PIT_CHANNEL2_DATA);
+    return 0xffff - ((uint64_t(high) << 8) | low);
+}
+
+// find hpet in acpi, enable it's main counter if firmware didn't
+bool Clock::SetupHPET(uint64_t& frequency, uint64_t& mask){
+    HPETHeader* hpet = reinterpret_cast<HPETHeader*>(FindSDT("HPET"));
+    if((hpet == nullptr) || (hpet->address.addressSpaceID != ACPI_ADDRESS_SPACE_MEMORY)){
+        return false;
+    }
+
+    hpetBase = GetDefaultVirtualMemoryManager().MapDeviceMemory(hpet->address.address, PAGE_SIZE);
+
+    volatile uint64_t* registers = reinterpret_cast<volatile uint64_t*>(hpetBase);
+    uint64_t capabilities = registers[HPET_REG_CAPABILITIES / 8];
+    uint64_t period = capabilities >> 32; // femtoseconds per tick
+    if(period == 0){
+        return false;
+    }
+
+    registers[HPET_REG_CONFIG / 8] = registers[HPET_REG_CONFIG / 8] | HPET_CONFIG_ENABLE;
+
+    frequency = HPET_FEMTOSECONDS_PER_SECOND / period;
+    mask = (capabilities & HPET_CAPABILITIES_64BIT) ? ~uint64_t(0) : 0xffffffff;
+    return true;
+}
+
+// pm timer port is in fadt
+bool Clock::SetupPMTimer(uint64_t& frequency, uint64_t& mask){
+    FADTHeader* fadt = reinterpret_cast<FADTHeader*>(FindSDT("FACP"));
+    if((fadt == nullptr) || (fadt->pmTimerBlock == 0) || (fadt->pmTimerLength < 4)){
+        return false;
+    }
+
+    pmTimerPort = uint16_t(fadt->pmTimerBlock);
+    frequency = PM_TIMER_FREQUENCY;
+    mask = (fadt->flags & FADT_FLAG_TIMER_32BIT) ? 0xffffffff : 0xffffff;
+    return true;
+}
+
+// channel 2 as a free running 16 bit counter, speaker stays off
+// wraps every ~55ms which is enough for calibration
+void Clock::SetupPIT(uint64_t& frequency, uint64_t& mask){
+    uint8_t gate = PortReadByte(PIT_CHANNEL2_GATE_PORT);
+    PortWriteByte(PIT_CHANNEL2_GATE_PORT, (gate & ~PIT_SPEAKER_ENABLE) | PIT_CHANNEL2_GATE);
+
+    PortWriteByte(PIT_COMMAND, PIT_COMMAND_CHANNEL2_RATE_GENERATOR);
+    // reload value of 0 means 65536
+    PortWriteByte(PIT_CHANNEL2_DATA, 0);
+    PortWriteByte(PIT_CHANNEL2_DATA, 0);
+
+    frequency = PIT_FREQUENCY;
+    mask = 0xffff;
+}
+
+// count tsc cycles while reference timer runs for CLOCK_CALIBRATION_MS
+uint64_t Clock::Calibrate(CounterReader read, uint64_t frequency, uint64_t mask){
+    uint64_t target = frequency * CLOCK_CALIBRATION_MS / 1000;
+
+    uint64_t start = read();
+    uint64_t tscStart = ReadTSC();
+
+    uint64_t elapsed = 0;
+    while(elapsed < target){
+        elapsed = (read() - start) & mask;
+    }
+    uint64_t cycles = ReadTSC() - tscStart;
+
+    return cycles * frequency / elapsed;
+}
+
+// pick reference and measure
+void Clock::Initialize(){
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(0x80000000, 0, eax, ebx, ecx, edx);
+    if(eax >= 0x80000007){
+        CPUID(0x80000007, 0, eax, ebx, ecx, edx);
+        isTSCInvariant = edx & CPUID_80000007_EDX_INVARIANT_TSC;
+    }
+
+    uint64_t frequency = 0, mask = 0;
+    CounterReader read = nullptr;
+    if(SetupHPET(frequency, mask)){
+        reference = CLOCK_REFERENCE_HPET;
+        read = ReadHPET;
+    }else if(SetupPMTimer(frequency, mask)){
+        reference = CLOCK_REFERENCE_PM_TIMER;
+        read = ReadPMTimer;
+    }else{
+        SetupPIT(frequency, mask);
+        reference = CLOCK_REFERENCE_PIT;
+        read = ReadPIT;
+    }
+
+    // interrupts would stretch the tsc side of a run
+    uint64_t rflags = SaveAndDisableInterrupts();
+    uint64_t runs[CLOCK_CALIBRATION_RUNS];
+    for(size_t i = 0; i < CLOCK_CALIBRATION_RUNS; i++){
+        runs[i] = Calibrate(read, frequency, mask);
+    }
+    RestoreInterrupts(rflags);
+
+    // median, so that one disturbed run (smi, hypervisor) doesn't matter
+    for(size_t i = 1; i < CLOCK_CALIBRATION_RUNS; i++){
+        for(size_t j = i; (j > 0) && (runs[j - 1] > runs[j]); j--){
+            uint64_t tmp = runs[j];
+            runs[j] = runs[j - 1];
+            runs[j - 1] = tmp;
+        }
+    }
+    tscFrequency = runs[CLOCK_CALIBRATION_RUNS / 2];
+
+    // only divisions, done once
+    nsMultiplier = (NS_PER_SECOND << CLOCK_NS_SHIFT) / tscFrequency;
+    cyclesMultiplier = (tscFrequency << CLOCK_CYCLES_SHIFT) / NS_PER_SECOND;
+    baseTSC = ReadTSC();
+
+    static const char* referenceNames[] = {"none", "HPET", "ACPI PM timer", "PIT"};
+    Printf("[+] TSC runs at %lu kHz, calibrated against %s\n", tscFrequency / 1000, referenceNames[reference]);
+    if(!isTSCInvariant){
+        Printf("[!] TSC is not invariant, time may drift with power states\n");
+    }
+}
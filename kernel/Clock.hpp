@@ -0,0 +1,151 @@
+/**
+ *@file Clock.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief TSC based monotonic clock calibrated against HPET, PM timer or PIT
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "CPU.hpp"
+
+// how long each calibration run measures tsc against reference timer
+#define CLOCK_CALIBRATION_MS 10
+// number of runs, median is used
+#define CLOCK_CALIBRATION_RUNS 3
+
+// ns = (cycles * nsMultiplier) >> CLOCK_NS_SHIFT
+#define CLOCK_NS_SHIFT 32
+// cycles = (ns * cyclesMultiplier) >> CLOCK_CYCLES_SHIFT
+#define CLOCK_CYCLES_SHIFT 24
+
+#define NS_PER_SECOND uint64_t(1000000000)
+
+// hpet registers (offsets from base)
+#define HPET_REG_CAPABILITIES 0x00
+#define HPET_REG_CONFIG 0x10
+#define HPET_REG_MAIN_COUNTER 0xf0
+
+// hpet bits
+#define HPET_CAPABILITIES_64BIT (uint64_t(1) << 13)
+#define HPET_CONFIG_ENABLE (uint64_t(1) << 0)
+#define HPET_FEMTOSECONDS_PER_SECOND uint64_t(1000000000000000)
+
+// acpi pm timer runs at fixed frequency
+#define PM_TIMER_FREQUENCY 3579545
+
+// pit channel 2 is the only one whose gate can be controlled (through port 0x61)
+#define PIT_FREQUENCY 1193182
+#define PIT_CHANNEL2_DATA 0x42
+#define PIT_COMMAND 0x43
+#define PIT_CHANNEL2_GATE_PORT 0x61
+#define PIT_CHANNEL2_GATE (1 << 0)
+#define PIT_SPEAKER_ENABLE (1 << 1)
+#define PIT_COMMAND_CHANNEL2_RATE_GENERATOR 0b10110100 // lobyte/hibyte access, mode 2
+#define PIT_COMMAND_CHANNEL2_LATCH 0b10000000
+
+// what tsc was calibrated against
+enum ClockReference : uint8_t {
+    CLOCK_REFERENCE_NONE = 0,
+    CLOCK_REFERENCE_HPET,
+    CLOCK_REFERENCE_PM_TIMER,
+    CLOCK_REFERENCE_PIT
+};
+
+// Monotonic time from tsc. Tsc frequency is measured once at boot against the first
+// reference timer available (HPET, ACPI PM timer, PIT) and turned into fixed point
+// multipliers, so converting is a multiply and a shift (no division).
+// Reading time is a rdtsc and that conversion, so it can be used from anywhere,
+// including interrupt handlers. Tsc is assumed to be in sync across cpus, which is
+// true for cpus with invariant tsc.
+struct Clock {
+    // calibrate tsc, time starts at 0 here
+    static void Initialize();
+
+    // nanoseconds since Initialize, 0 before that
+    static uint64_t NowNs(){
+        return CyclesToNs(ReadTSC() - baseTSC);
+    }
+
+    // convert between tsc cycles and nanoseconds
+    static uint64_t CyclesToNs(uint64_t cycles){
+        return uint64_t((unsigned __int128)cycles * nsMultiplier >> CLOCK_NS_SHIFT);
+    }
+
+    static uint64_t NsToCycles(uint64_t ns){
+        return uint64_t((unsigned __int128)ns * cyclesMultiplier >> CLOCK_CYCLES_SHIFT);
+    }
+
+    // tsc value at given time (as returned by NowNs)
+    static uint64_t NsToTSC(uint64_t ns){
+        return baseTSC + NsToCycles(ns);
+    }
+
+    // tsc frequency in hz, 0 if not calibrated
+    static uint64_t GetTSCFrequency(){ return tscFrequency; }
+
+    // is tsc rate constant across p-states and c-states
+    static bool IsTSCInvariant(){ return isTSCInvariant; }
+
+private:
+    // reads a free running counter that counts up
+    typedef uint64_t (*CounterReader)();
+
+    // measure tsc frequency against counter with given frequency
+    // mask tells width of counter, it must not wrap more than once during calibration
+    static uint64_t Calibrate(CounterReader read, uint64_t frequency, uint64_t mask);
+
+    // find and setup reference timers, false if not present
+    static bool SetupHPET(uint64_t& frequency, uint64_t& mask);
+    static bool SetupPMTimer(uint64_t& frequency, uint64_t& mask);
+    static void SetupPIT(uint64_t& frequency, uint64_t& mask);
+
+    static uint64_t ReadHPET();
+    static uint64_t ReadPMTimer();
+    static uint64_t ReadPIT();
+
+    static inline uint64_t baseTSC = 0;
+    static inline uint64_t nsMultiplier = 0;
+    static inline uint64_t cyclesMultiplier = 0;
+    static inline uint64_t tscFrequency = 0;
+    static inline bool isTSCInvariant = false;
+    static inline ClockReference reference = CLOCK_REFERENCE_NONE;
+
+    // reference timers
+    static inline uint64_t hpetBase = 0;
+    static inline uint16_t pmTimerPort = 0;
+};
+
+#endif // CLOCK_HPP
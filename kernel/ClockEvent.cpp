@@ -0,0 +1,122 @@
+/**
+ *@file ClockEvent.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief One shot per cpu timer interrupts using local APIC timer
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ClockEvent.hpp"
+#include "Clock.hpp"
+#include "APIC.hpp"
+#include "CPU.hpp"
+#include "Printf.hpp"
+
+// count timer down from max while tsc measures elapsed time
+void ClockEvent::Calibrate(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+
+    APIC::SetupTimer(LAPIC_TIMER_MASKED | LAPIC_TIMER_ONE_SHOT | APIC_TIMER_VECTOR);
+    APIC::ArmTimer(0xffffffff);
+
+    uint64_t start = Clock::NowNs();
+    uint64_t elapsed = 0;
+    while(elapsed < CLOCK_EVENT_CALIBRATION_MS * 1000000){
+        elapsed = Clock::NowNs() - start;
+    }
+    uint64_t counts = 0xffffffff - APIC::GetTimerCount();
+
+    APIC::ArmTimer(0);
+    RestoreInterrupts(rflags);
+
+    countMultiplier = (counts << CLOCK_EVENT_COUNT_SHIFT) / elapsed;
+    Printf("[+] Local APIC timer runs at %lu kHz (after divide by 16)\n", counts * 1000000 / elapsed);
+}
+
+// boot cpu
+void ClockEvent::Initialize(){
+    if(!APIC::IsEnabled()){
+        Printf("[!] No local APIC timer, no timer interrupts\n");
+        return;
+    }
+
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(1, 0, eax, ebx, ecx, edx);
+    useTSCDeadline = ecx & CPUID_1_ECX_TSC_DEADLINE;
+
+    if(useTSCDeadline){
+        Printf("[+] Using TSC deadline mode for timer interrupts\n");
+    }else{
+        Calibrate();
+        Printf("[+] Using one shot mode for timer interrupts\n");
+    }
+
+    isAvailable = true;
+}
+
+// every cpu
+void ClockEvent::InitializeCpu(){
+    if(!isAvailable){
+        return;
+    }
+
+    APIC::SetupTimer((useTSCDeadline ? LAPIC_TIMER_TSC_DEADLINE : LAPIC_TIMER_ONE_SHOT) | APIC_TIMER_VECTOR);
+}
+
+// arm
+void ClockEvent::SetDeadline(uint64_t ns){
+    if(useTSCDeadline){
+        WriteMSR(MSR_TSC_DEADLINE, Clock::NsToTSC(ns));
+        return;
+    }
+
+    uint64_t now = Clock::NowNs();
+    uint64_t delta = (ns > now) ? (ns - now) : 0;
+    uint64_t count = uint64_t((unsigned __int128)delta * countMultiplier >> CLOCK_EVENT_COUNT_SHIFT);
+
+    // 0 would stop the timer
+    if(count == 0){
+        count = 1;
+    }else if(count > 0xffffffff){
+        count = 0xffffffff; // fires early, whoever armed it will arm again
+    }
+
+    APIC::ArmTimer(uint32_t(count));
+}
+
+// disarm
+void ClockEvent::Stop(){
+    if(useTSCDeadline){
+        WriteMSR(MSR_TSC_DEADLINE, 0);
+    }else{
+        APIC::ArmTimer(0);
+    }
+}
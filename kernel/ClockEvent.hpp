@@ -0,0 +1,83 @@
+/**
+ *@file ClockEvent.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief One shot per cpu timer interrupts using local APIC timer
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLOCKEVENT_HPP
+#define CLOCKEVENT_HPP
+
+#include <cstdint>
+
+// how long local apic timer is measured against tsc in one shot mode
+#define CLOCK_EVENT_CALIBRATION_MS 10
+// count = (ns * countMultiplier) >> CLOCK_EVENT_COUNT_SHIFT
+#define CLOCK_EVENT_COUNT_SHIFT 32
+
+// Local apic timer used as a one shot event source : it's armed for the next thing
+// that needs to happen on this cpu and nothing else, so a cpu with nothing to do
+// gets no timer interrupts at all.
+// TSC deadline mode is used when cpu has it, timer then fires when tsc reaches
+// an absolute value, so arming is a single msr write with no conversion error.
+// Otherwise one shot mode is used and it's rate is measured against tsc once at boot.
+// Timer interrupt comes at APIC_TIMER_VECTOR, whoever arms the timer handles it.
+struct ClockEvent {
+    // pick mode and calibrate, Clock must be initialized before this
+    static void Initialize();
+
+    // setup local apic timer of this cpu in mode picked above
+    static void InitializeCpu();
+
+    // is there a timer to arm (needs apic)
+    static bool IsAvailable(){ return isAvailable; }
+
+    // is tsc deadline mode in use
+    static bool UsesTSCDeadline(){ return useTSCDeadline; }
+
+    // fire timer interrupt on this cpu at given time (see Clock::NowNs)
+    // replaces previous deadline, time in past fires right away
+    static void SetDeadline(uint64_t ns);
+
+    // disarm timer of this cpu
+    static void Stop();
+
+private:
+    // measure local apic timer ticks per ns against tsc
+    static void Calibrate();
+
+    static inline bool isAvailable = false;
+    static inline bool useTSCDeadline = false;
+    static inline uint64_t countMultiplier = 0;
+};
+
+#endif // CLOCKEVENT_HPP
@@ -37,19 +37,16 @@
 #ifndef COMMON_HPP
 #define COMMON_HPP
 
+#include "Idle.hpp"
+
 // attribute for all printf type functions
 #define PRINTF_API(x, y) __attribute__((format(printf, x, y)))
 
-// attribute of all interrupt handlers
-#define INTERRUPT_API __attribute__((interrupt))
-
-// attribute of all functions that will be called in a interrupt handler
-#define INTERRUPT_CALLEE_API __attribute__((no_caller_saved_registers))
-
 #define PACKED_STRUCT __attribute__((packed))
 
-inline void EternalHalt(){
-    while(true) asm("hlt");
+// stop this cpu for good
+[[noreturn]] inline void EternalHalt(){
+    Idle::HaltForever();
 }
 
 #endif // COMMON_HPP
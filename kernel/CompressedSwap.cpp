@@ -0,0 +1,151 @@
+/**
+ *@file CompressedSwap.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Compressed in memory store for swapped out pages
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "CompressedSwap.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "Printf.hpp"
+#include "Utils/LZ.hpp"
+
+// objects are 64 byte aligned, so we can drop lower 6 bits of address
+#define OBJECT_OFFSET_SHIFT 6
+
+// size of header of each object
+#define OBJECT_HEADER_SIZE sizeof(uint16_t)
+
+// compressor writes here before data is copied to an object
+static uint8_t compressionBuffer[COMPRESSED_SWAP_MAX_OBJECT_SIZE];
+
+// get size class that can hold given number of bytes
+static inline size_t GetSizeClass(size_t size){
+    return (size + COMPRESSED_SWAP_CLASS_SIZE - 1) / COMPRESSED_SWAP_CLASS_SIZE - 1;
+}
+
+// get object size of given size class
+static inline size_t GetObjectSize(size_t sizeClass){
+    return (sizeClass + 1) * COMPRESSED_SWAP_CLASS_SIZE;
+}
+
+// get an object from free list of given size class
+uint64_t CompressedSwap::AllocateObject(size_t sizeClass){
+    // refill free list from a new page
+    if(freeLists[sizeClass] == NULLADDR){
+        uint64_t page = PhysicalMemoryManager::AllocatePage();
+        size_t objectSize = GetObjectSize(sizeClass);
+
+        // push in reverse so that objects are handed out in increasing address order
+        for(size_t i = PAGE_SIZE / objectSize; i > 0; i--){
+            uint64_t object = page + (i - 1) * objectSize;
+            *reinterpret_cast<uint64_t*>(object) = freeLists[sizeClass];
+            freeLists[sizeClass] = object;
+        }
+
+        numPoolPages++;
+    }
+
+    uint64_t object = freeLists[sizeClass];
+    freeLists[sizeClass] = *reinterpret_cast<uint64_t*>(object);
+    return object;
+}
+
+// compress and store page
+bool CompressedSwap::Store(uint64_t page, uint64_t& offset){
+    if(numPoolPages * PAGE_SIZE >= COMPRESSED_SWAP_MAX_POOL_SIZE){
+        return false;
+    }
+
+    // compressor fails if data doesn't fit in buffer
+    // this takes care of pages that don't compress well
+    size_t size = LZCompress(reinterpret_cast<const uint8_t*>(page), PAGE_SIZE,
+                             compressionBuffer, COMPRESSED_SWAP_MAX_OBJECT_SIZE - OBJECT_HEADER_SIZE);
+    if(size == 0){
+        numRejectedPages++;
+        return false;
+    }
+
+    // store size followed by compressed data
+    uint64_t object = AllocateObject(GetSizeClass(size + OBJECT_HEADER_SIZE));
+    *reinterpret_cast<uint16_t*>(object) = uint16_t(size);
+    uint8_t* data = reinterpret_cast<uint8_t*>(object + OBJECT_HEADER_SIZE);
+    for(size_t i = 0; i < size; i++){
+        data[i] = compressionBuffer[i];
+    }
+
+    offset = (object - MEM_PHYS_OFFSET) >> OBJECT_OFFSET_SHIFT;
+
+    numStoredPages++;
+    compressedBytes += size;
+
+    return true;
+}
+
+// decompress page
+bool CompressedSwap::Load(uint64_t offset, uint64_t page){
+    uint64_t object = (offset << OBJECT_OFFSET_SHIFT) + MEM_PHYS_OFFSET;
+    size_t size = *reinterpret_cast<uint16_t*>(object);
+
+    size_t decompressed = LZDecompress(reinterpret_cast<const uint8_t*>(object + OBJECT_HEADER_SIZE), size,
+                                       reinterpret_cast<uint8_t*>(page), PAGE_SIZE);
+    return decompressed == PAGE_SIZE;
+}
+
+// return object back to it's size class
+void CompressedSwap::Free(uint64_t offset){
+    uint64_t object = (offset << OBJECT_OFFSET_SHIFT) + MEM_PHYS_OFFSET;
+    size_t size = *reinterpret_cast<uint16_t*>(object);
+
+    numStoredPages--;
+    compressedBytes -= size;
+
+    size_t sizeClass = GetSizeClass(size + OBJECT_HEADER_SIZE);
+    *reinterpret_cast<uint64_t*>(object) = freeLists[sizeClass];
+    freeLists[sizeClass] = object;
+}
+
+// print statistics
+void CompressedSwap::ShowStatistics(){
+    Printf("[+] Compressed Swap Stats : \n");
+    Printf("\tStored Pages : %lu pages\n", numStoredPages);
+    Printf("\tRejected Pages : %lu pages\n", numRejectedPages);
+    Printf("\tPool Memory : %lu KB\n", (numPoolPages * PAGE_SIZE) / KB);
+
+    if(compressedBytes){
+        // no floating point in kernel, so print ratio with 2 decimal places manually
+        uint64_t ratio = (numStoredPages * PAGE_SIZE * 100) / compressedBytes;
+        Printf("\tCompression Ratio : %lu.%lu%lu\n", ratio / 100, (ratio / 10) % 10, ratio % 10);
+        Printf("\tCompressed Size : %lu KB\n", compressedBytes / KB);
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ *@file CompressedSwap.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Compressed in memory store for swapped out pages
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef COMPRESSEDSWAP_HPP
+#define COMPRESSEDSWAP_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Constants.hpp"
+
+// Compressed pages are stored in a pool of size classes.
+// Each size class is a multiple of 64 bytes and has it's own free list
+// of objects. When a size class runs out of objects, a new page is
+// allocated and divided into objects of that size class.
+// This way a page compressed to 1 KB only uses 1 KB of memory.
+//
+// Each object starts with a 2 byte header that contains size of compressed data.
+
+// granularity of size classes
+#define COMPRESSED_SWAP_CLASS_SIZE uint64_t(64)
+// pages that don't compress to atleast 3/4th of their size aren't worth storing
+#define COMPRESSED_SWAP_MAX_OBJECT_SIZE uint64_t(3*KB)
+// max memory used by pool, rest of the pages go to swap device
+#define COMPRESSED_SWAP_MAX_POOL_SIZE uint64_t(64*MB)
+// total number of size classes
+#define COMPRESSED_SWAP_NUM_CLASSES (COMPRESSED_SWAP_MAX_OBJECT_SIZE / COMPRESSED_SWAP_CLASS_SIZE)
+
+struct CompressedSwap{
+    // compress and store given page
+    // offset is set to where the page is stored and must be used to load it back
+    // returns false if page didn't compress well enough or pool is full
+    static bool Store(uint64_t page, uint64_t& offset);
+
+    // decompress page stored at offset into given page
+    static bool Load(uint64_t offset, uint64_t page);
+
+    // release memory used by page stored at given offset
+    static void Free(uint64_t offset);
+
+    // print compression ratio, pool usage etc...
+    static void ShowStatistics();
+private:
+    // get an object from given size class
+    static uint64_t AllocateObject(size_t sizeClass);
+
+    // free objects of each size class are linked using their first 8 bytes
+    static inline uint64_t freeLists[COMPRESSED_SWAP_NUM_CLASSES] = {};
+
+    // statistics
+    static inline uint64_t numStoredPages = 0;
+    static inline uint64_t numRejectedPages = 0;
+    static inline uint64_t compressedBytes = 0;
+    static inline uint64_t numPoolPages = 0;
+};
+
+#endif // COMPRESSEDSWAP_HPP
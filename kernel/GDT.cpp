@@ -35,14 +35,18 @@
 */
 
 #include "GDT.hpp"
+#include "PerCpu.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "Utils/String.hpp"
+#include "Printf.hpp"
 
-// create default gdt
-static GDT __attribute__((aligned(0x1000))) default_gdt;
-// pointer to global_descriptor table
-static GDTR gdtr;
+// per cpu descriptor tables, gdt takes a whole page so it's allocated
+static GDT* cpuGDT[MAX_CPUS];
+static TaskStateSegment cpuTSS[MAX_CPUS];
 
 // load gdt address in gdtr register
-void LoadGDTR(){
+void LoadGDTR(const GDTR& gdtr){
     // load gdtr
     asm volatile("lgdt %0"
                  :
@@ -62,9 +66,9 @@ void LoadGDTR(){
     // }
 
     // point to data segment
+    // gs is left alone, loading it would clear gs base which points to per cpu data
     asm volatile("mov %0, %%ds\n"
                  "mov %0, %%es\n"
-                 "mov %0, %%gs\n"
                  "mov %0, %%fs\n"
                  "mov %0, %%ss\n"
                  :
@@ -86,23 +90,69 @@ GDTEntry CreateGDTEntry(uint8_t access, uint8_t attributes){
     return gdtEntry;
 }
 
+// create tss descriptor pointing to given tss
+TSSDescriptor CreateTSSDescriptor(TaskStateSegment* tss){
+    uint64_t base = reinterpret_cast<uint64_t>(tss);
+    uint32_t limit = sizeof(TaskStateSegment) - 1;
+
+    TSSDescriptor desc;
+    desc.low.segment_limit_low = uint16_t(limit & 0xffff);
+    desc.low.base_address_low = uint16_t(base & 0xffff);
+    desc.low.base_address_middle = uint8_t((base >> 16) & 0xff);
+    desc.low.access_flags = TSS_ACCESS_FLAGS;
+    desc.low.attributes = uint8_t((limit >> 16) & 0xf);
+    desc.low.base_address_high = uint8_t((base >> 24) & 0xff);
+    desc.base_address_upper = uint32_t(base >> 32);
+    desc.reserved = 0;
+
+    return desc;
+}
+
+// give exceptions that can't trust current stack their own stacks
+static void SetupInterruptStacks(TaskStateSegment* tss){
+    VirtualMemoryManager& vmm = GetDefaultVirtualMemoryManager();
+    tss->ist[IST_DOUBLE_FAULT - 1] = vmm.AllocateKernelStack(IST_STACK_SIZE);
+    tss->ist[IST_NMI - 1] = vmm.AllocateKernelStack(IST_STACK_SIZE);
+    tss->ist[IST_MACHINE_CHECK - 1] = vmm.AllocateKernelStack(IST_STACK_SIZE);
+
+    // no io permission bitmap
+    tss->iopbOffset = sizeof(TaskStateSegment);
+}
+
 
 // initializes global descriptor table
 void InstallGDT(){
+    size_t cpu = GetCurrentCpuIndex();
+
+    // first time on this cpu
+    if(cpuGDT[cpu] == nullptr){
+        cpuGDT[cpu] = reinterpret_cast<GDT*>(PhysicalMemoryManager::AllocatePage());
+        memset(cpuGDT[cpu], 0, sizeof(GDT));
+        memset(&cpuTSS[cpu], 0, sizeof(TaskStateSegment));
+        SetupInterruptStacks(&cpuTSS[cpu]);
+    }
+
+    GDT* gdt = cpuGDT[cpu];
+
     // prepare pointer to gdt
     // minus 1 to get the last valid byte address in gdt
+    GDTR gdtr;
     gdtr.table_limit = sizeof(GDT) - 1;
-    gdtr.table_base_address = (uint64_t)&default_gdt;
+    gdtr.table_base_address = (uint64_t)gdt;
 
     // fill gdt:
     // createGDTEntry(access_flags, attributes/granularity)
     // null descriptor has all fields set to 0 (null)
-    default_gdt.null = CreateGDTEntry(0x00, 0x00);
-    default_gdt.kernelCode = CreateGDTEntry(0x9b, 0x20);
-    default_gdt.kernelData = CreateGDTEntry(0x92, 0x00);
-    default_gdt.userCode = CreateGDTEntry(0xfb, 0x20);
-    default_gdt.userData = CreateGDTEntry(0xf2, 0x00);
+    gdt->null = CreateGDTEntry(0x00, 0x00);
+    gdt->kernelCode = CreateGDTEntry(0x9b, 0x20);
+    gdt->kernelData = CreateGDTEntry(0x92, 0x00);
+    gdt->userCode = CreateGDTEntry(0xfb, 0x20);
+    gdt->userData = CreateGDTEntry(0xf2, 0x00);
+    gdt->tss = CreateTSSDescriptor(&cpuTSS[cpu]);
 
     // reload gdt address in gdtr
-    LoadGDTR();
+    LoadGDTR(gdtr);
+
+    // load task register
+    asm volatile("ltr %0" : : "r"(uint16_t(GDT_TSS_SELECTOR)));
 }
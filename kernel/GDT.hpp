@@ -39,6 +39,22 @@
 
 #include <cstdint>
 #include "Common.hpp"
+#include "Constants.hpp"
+
+// segment selectors (offset in gdt)
+#define GDT_KERNEL_CODE_SELECTOR 0x08
+#define GDT_KERNEL_DATA_SELECTOR 0x10
+#define GDT_TSS_SELECTOR 0x28
+
+// interrupt stack table indices, 0 means no stack switch
+// exceptions that can happen when current stack is unusable get their own stack
+#define IST_DOUBLE_FAULT 1
+#define IST_NMI 2
+#define IST_MACHINE_CHECK 3
+#define IST_STACK_SIZE (16*KB)
+
+// tss access flags : present, 64-bit available tss
+#define TSS_ACCESS_FLAGS 0x89
 
 // struct to represent gdtr
 struct GDTR{
@@ -77,15 +93,37 @@ struct GDTEntry {
     uint8_t base_address_high;
 } PACKED_STRUCT;
 
+// In long mode tss is only used to hold stack pointers,
+// cpu switches to ist[n - 1] when an idt entry has ist = n.
+struct TaskStateSegment {
+    uint32_t reserved0;
+    uint64_t rsp[3]; // stack for privilege level change
+    uint64_t reserved1;
+    uint64_t ist[7];
+    uint64_t reserved2;
+    uint16_t reserved3;
+    uint16_t iopbOffset;
+} PACKED_STRUCT;
+
+// system segment descriptors are 16 bytes in long mode
+struct TSSDescriptor {
+    GDTEntry low;
+    uint32_t base_address_upper;
+    uint32_t reserved;
+} PACKED_STRUCT;
+
 struct GDT{
     GDTEntry null;
     GDTEntry kernelCode;
     GDTEntry kernelData;
     GDTEntry userCode;
     GDTEntry userData;
+    TSSDescriptor tss;
 } PACKED_STRUCT __attribute__((aligned(0x1000)));
 
-// install kernel's global descriptor table in gdtr
+// install global descriptor table and task state segment for current cpu
+// each cpu needs it's own tss (and so gdt) because loading a tss marks it busy
+// also allocates interrupt stacks for this cpu
 void InstallGDT();
 
 #endif // GDT_HPP
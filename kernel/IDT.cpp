@@ -36,8 +36,9 @@
 #include "IDT.hpp"
 #include "PhysicalMemoryManager.hpp"
 #include "VirtualMemoryManager.hpp"
-#include "Interrupts.hpp"
 #include "Printf.hpp"
+#include "IRQ.hpp"
+#include "GDT.hpp"
 
 #define IDT_ENTRY_OFFSET_LOW_MASK uint64_t(0xffff)
 #define IDT_ENTRY_OFFSET_MIDDLE_MASK uint64_t(0xffff0000)
@@ -68,7 +69,15 @@ void SetInterruptDescriptor(uint8_t entry, uint64_t isr, uint8_t flags){
     IDTEntry* gatedesc = reinterpret_cast<IDTEntry*>(idtr.offset + entry * sizeof(IDTEntry));
     gatedesc->SetOffset(isr);
     gatedesc->typeAttr = flags;
-    gatedesc->selector = 0x08; // offset of kernelCode in GDT
+    gatedesc->selector = GDT_KERNEL_CODE_SELECTOR;
+    gatedesc->ist = 0;
+    gatedesc->reserved = 0;
+}
+
+// set ist index for a descriptor
+void SetInterruptStack(uint8_t entry, uint8_t ist){
+    IDTEntry* gatedesc = reinterpret_cast<IDTEntry*>(idtr.offset + entry * sizeof(IDTEntry));
+    gatedesc->ist = ist;
 }
 
 void InstallIDT(){
@@ -77,61 +86,23 @@ void InstallIDT(){
     // and if paging is enabled then offset must be the virtual address
     idtr.offset = PhysicalMemoryManager::AllocatePage();
 
-    // divide by zero
-    SetInterruptDescriptor(0x00, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // debug
-    SetInterruptDescriptor(0x01, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // NMI
-    SetInterruptDescriptor(0x02, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // breakpoint
-    SetInterruptDescriptor(0x03, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // overflow
-    SetInterruptDescriptor(0x04, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // bound range exceeded
-    SetInterruptDescriptor(0x05, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // invalid opcode
-    SetInterruptDescriptor(0x06, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // device not avaiable
-    SetInterruptDescriptor(0x07, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-
-    // create double fault handler
-    SetInterruptDescriptor(0x08, reinterpret_cast<uint64_t>(DoubleFaultHandler), IDT_TYPE_ATTR_INTERRUPT_GATE);
-
-    // co-processor segment overrun
-    SetInterruptDescriptor(0x09, reinterpret_cast<uint64_t>(DefaultInterruptHandlerWithError), IDT_TYPE_ATTR_TRAP_GATE);
-    // invalid tss
-    SetInterruptDescriptor(0x0a, reinterpret_cast<uint64_t>(DefaultInterruptHandlerWithError), IDT_TYPE_ATTR_TRAP_GATE);
-    // segment not present
-    SetInterruptDescriptor(0x0b, reinterpret_cast<uint64_t>(DefaultInterruptHandlerWithError), IDT_TYPE_ATTR_TRAP_GATE);
-    // stack segment fault
-    SetInterruptDescriptor(0x0c, reinterpret_cast<uint64_t>(DefaultInterruptHandlerWithError), IDT_TYPE_ATTR_TRAP_GATE);
-
-    // create general protection fault handler
-    SetInterruptDescriptor(0x0d, reinterpret_cast<uint64_t>(GeneralProtectionFaultHandler), IDT_TYPE_ATTR_INTERRUPT_GATE);
-    // create page fault handler
-    SetInterruptDescriptor(0x0e, reinterpret_cast<uint64_t>(PageFaultHandler), IDT_TYPE_ATTR_INTERRUPT_GATE);
-
-    // 0x0f is reserved
-
-    // floating point error
-    SetInterruptDescriptor(0x10, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // alignment cehck
-    SetInterruptDescriptor(0x11, reinterpret_cast<uint64_t>(DefaultInterruptHandlerWithError), IDT_TYPE_ATTR_TRAP_GATE);
-    // machine check
-    SetInterruptDescriptor(0x12, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // simd floating point exception
-    SetInterruptDescriptor(0x13, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // virtualization exception
-    SetInterruptDescriptor(0x14, reinterpret_cast<uint64_t>(DefaultInterruptHandlerNoError), IDT_TYPE_ATTR_TRAP_GATE);
-    // control protection exception
-    SetInterruptDescriptor(0x15, reinterpret_cast<uint64_t>(DefaultInterruptHandlerWithError), IDT_TYPE_ATTR_TRAP_GATE);
-    // rest up until 0x1f is reserved
-
-    // first interrupt is mapped to 0x20
-    // and keyboard interrupt is the second one
-    // so offset = 0x21
-    SetInterruptDescriptor(0x21, reinterpret_cast<uint64_t>(KeyboardInterruptHandler), IDT_TYPE_ATTR_INTERRUPT_GATE);
+    // every vector goes through common entry and dispatcher (see IRQ.cpp)
+    // handlers are registered with RegisterIrqHandler
+    for(size_t vector = 0; vector < IRQ_NUM_VECTORS; vector++){
+        SetInterruptDescriptor(uint8_t(vector), GetIrqStub(uint8_t(vector)), IDT_TYPE_ATTR_INTERRUPT_GATE);
+    }
+
+    // these can happen on a broken stack (or in middle of a stack switch),
+    // so they always run on known good stacks
+    SetInterruptStack(0x08, IST_DOUBLE_FAULT);
+    SetInterruptStack(0x02, IST_NMI);
+    SetInterruptStack(0x12, IST_MACHINE_CHECK);
+
+    LoadIDT();
+}
 
+// all cpus share the same idt
+void LoadIDT(){
     // load the idtr strucg in idtr register
     asm volatile ("lidt %0"
                   :
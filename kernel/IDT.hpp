@@ -86,9 +86,15 @@ struct IDTR{
 // entry must be the id of interrupt to be handled
 // isr must be pointer to function that will handle the interrupt
 // flags must be a valid flag to define the type of interrupt descriptor
-void SetInterruptDescriptor(uint8_t entry, void* isr, uint8_t flags);
+void SetInterruptDescriptor(uint8_t entry, uint64_t isr, uint8_t flags);
+
+// make cpu switch to given interrupt stack table entry (see GDT.hpp) for this vector
+void SetInterruptStack(uint8_t entry, uint8_t ist);
 
 // you know what this does!
 void InstallIDT();
 
+// load already installed idt on current cpu (for application processors)
+void LoadIDT();
+
 #endif // IDT_HPP
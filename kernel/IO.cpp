@@ -36,13 +36,13 @@
 
 #include "IO.hpp"
 
-INTERRUPT_CALLEE_API void PortWriteByte(uint16_t port, uint8_t value){
+void PortWriteByte(uint16_t port, uint8_t value){
     asm volatile ("outb %0, %1"
                   :
                   : "a"(value), "Nd"(port));
 }
 
-INTERRUPT_CALLEE_API uint8_t PortReadByte(uint16_t port){
+uint8_t PortReadByte(uint16_t port){
     uint8_t ret;
     asm volatile ("inb %1, %0"
                   : "=a"(ret)
@@ -51,7 +51,37 @@ INTERRUPT_CALLEE_API uint8_t PortReadByte(uint16_t port){
     return ret;
 }
 
-INTERRUPT_CALLEE_API void PortIOWait(){
+void PortWriteWord(uint16_t port, uint16_t value){
+    asm volatile ("outw %0, %1"
+                  :
+                  : "a"(value), "Nd"(port));
+}
+
+uint16_t PortReadWord(uint16_t port){
+    uint16_t ret;
+    asm volatile ("inw %1, %0"
+                  : "=a"(ret)
+                  : "Nd"(port));
+
+    return ret;
+}
+
+void PortWriteDword(uint16_t port, uint32_t value){
+    asm volatile ("outl %0, %1"
+                  :
+                  : "a"(value), "Nd"(port));
+}
+
+uint32_t PortReadDword(uint16_t port){
+    uint32_t ret;
+    asm volatile ("inl %1, %0"
+                  : "=a"(ret)
+                  : "Nd"(port));
+
+    return ret;
+}
+
+void PortIOWait(){
     // write something into an unused port so that
     // other ports get time to catch up
     // this will waste a single IO cycle
@@ -39,20 +39,28 @@
 
 #include <cstdint>
 
-// all functions that are going to be called within any interrupt handler
-// must have this attribute
-#define INTERRUPT_CALLEE_API __attribute__((no_caller_saved_registers))
-
 // put a byte on to a I/O bus
 // port selects the device on the I/O bus to talk to
 // value is the value that we want to give to the device
-INTERRUPT_CALLEE_API void PortWriteByte(uint16_t port, uint8_t value);
+void PortWriteByte(uint16_t port, uint8_t value);
 
 // get byte from port
-INTERRUPT_CALLEE_API uint8_t PortReadByte(uint16_t port);
+uint8_t PortReadByte(uint16_t port);
+
+// put a word (2 bytes) on to a I/O bus
+void PortWriteWord(uint16_t port, uint16_t value);
+
+// get word (2 bytes) from port
+uint16_t PortReadWord(uint16_t port);
+
+// put a double word (4 bytes) on to a I/O bus
+void PortWriteDword(uint16_t port, uint32_t value);
+
+// get double word (4 bytes) from port
+uint32_t PortReadDword(uint16_t port);
 
 // wait for small time
 // on older machines, i/o ports are slow
-INTERRUPT_CALLEE_API void PortIOWait();
+void PortIOWait();
 
 #endif // IO_HPP
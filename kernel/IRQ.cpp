@@ -0,0 +1,491 @@
+/**
+ *@file IRQ.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Common interrupt entry and handler registration
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "IRQ.hpp"
+#include "APIC.hpp"
+#include "CPU.hpp"
+#include "Interrupts.hpp"
+#include "Panic.hpp"
+#include "Printf.hpp"
+#include "Common.hpp"
+#include "SoftIRQ.hpp"
+#include "PerCpu.hpp"
+#include "Scheduler.hpp"
+#include "Rcu.hpp"
+#include "SpinLock.hpp"
+#include "Clock.hpp"
+#include "Utils/String.hpp"
+#include "VirtualMemoryManager.hpp"
+
+// Entry stubs, one for each vector, each IRQ_STUB_SIZE bytes long.
+// Cpu pushes error code only for some exceptions, others push a 0
+// so that stack layout is always the same.
+// Common entry saves general purpose registers in the order of InterruptContext,
+// so rsp can be passed directly as context to the dispatcher.
+// Stack is 16 byte aligned at call, cpu aligns it before pushing the frame
+// and 17 more qwords are pushed after that.
+// Device interrupts (vector >= 32) run on a per cpu irq stack, nested ones stay
+// on it. Exceptions stay on current stack (or the one given by ist).
+// Old stack pointer is kept in rbx which is preserved across calls.
+// Once back on interrupted stack, InterruptExit gets a chance to switch threads.
+asm(R"(
+.pushsection .text
+.balign 16
+.global IrqStubs
+IrqStubs:
+.set vector, 0
+.rept 256
+    .balign 16
+    .if (vector == 8) || ((vector >= 10) && (vector <= 14)) || (vector == 17) || (vector == 21) || (vector == 29) || (vector == 30)
+    .else
+    pushq $0
+    .endif
+    pushq $vector
+    jmp InterruptCommonEntry
+    .set vector, vector + 1
+.endr
+
+InterruptCommonEntry:
+    pushq %rax
+    pushq %rbx
+    pushq %rcx
+    pushq %rdx
+    pushq %rsi
+    pushq %rdi
+    pushq %rbp
+    pushq %r8
+    pushq %r9
+    pushq %r10
+    pushq %r11
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+
+    cld
+    movq %rsp, %rbx
+    cmpq $32, 120(%rsp)
+    jb 1f
+    call IrqStackEnter
+    testq %rax, %rax
+    jz 1f
+    movq %rax, %rsp
+1:
+    movq %rbx, %rdi
+    call InterruptDispatch
+
+    movq %rbx, %rsp
+    cmpq $32, 120(%rsp)
+    jb 2f
+    call IrqStackLeave
+    movq %rbx, %rdi
+    call InterruptExit
+2:
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %r11
+    popq %r10
+    popq %r9
+    popq %r8
+    popq %rbp
+    popq %rdi
+    popq %rsi
+    popq %rdx
+    popq %rcx
+    popq %rbx
+    popq %rax
+
+    // vector and error code
+    addq $16, %rsp
+    iretq
+.popsection
+)");
+
+// defined in asm above
+extern "C" uint8_t IrqStubs[];
+
+// called from common entry with interrupts disabled
+// returns stack to switch to, 0 if already on irq stack (or there's none)
+extern "C" uint64_t IrqStackEnter(){
+    uint64_t depth = PER_CPU(irqStackDepth)::Read();
+    PER_CPU(irqStackDepth)::Write(depth + 1);
+    if(depth == 0){
+        return PER_CPU(irqStackTop)::Read();
+    }
+
+    return 0;
+}
+
+// called from common entry after dispatch with interrupts disabled
+extern "C" void IrqStackLeave(){
+    PER_CPU(irqStackDepth)::Write(PER_CPU(irqStackDepth)::Read() - 1);
+}
+
+// called from common entry for device interrupts, after leaving irq stack
+// interrupts are disabled, thread switched away here continues from this point
+extern "C" void InterruptExit(InterruptContext* frame){
+    // only outermost interrupt of code that could've been preempted anyway
+    if((PER_CPU(irqStackDepth)::Read() == 0) && (frame->rflags & RFLAGS_INTERRUPT_ENABLE)){
+        Scheduler::PreemptIfNeeded();
+    }
+}
+
+// allocate irq stack for current cpu
+void InitializeIrqStack(){
+    if(PER_CPU(irqStackTop)::Read() == 0){
+        PER_CPU(irqStackTop)::Write(GetDefaultVirtualMemoryManager().AllocateKernelStack(IRQ_STACK_SIZE));
+    }
+}
+
+// a registered handler
+struct IrqAction {
+    IrqHandler handler;
+    void* context;
+    IrqAction* next;
+    bool inUse;
+    RcuHead rcu; // slot is reused only after a grace period, dispatch may still be looking at it
+};
+
+// handlers are allocated from here since there's no heap
+static IrqAction irqActionPool[IRQ_MAX_HANDLERS];
+// first handler for each vector
+// dispatch walks chains without locks (see Rcu.hpp), registration changes them under irqActionLock
+static IrqAction* irqActions[IRQ_NUM_VECTORS];
+static SpinLock irqActionLock = {};
+
+// vectors given to devices
+static bool irqVectorAllocated[IRQ_NUM_VECTORS];
+
+// latency and rate of one vector on one cpu
+struct IrqVectorStats {
+    uint64_t count;
+    uint64_t totalCycles;
+    uint64_t minCycles;
+    uint64_t maxCycles;
+    uint64_t firstTimestamp; // tsc at entry of first interrupt
+    uint64_t lastTimestamp; // tsc at entry of latest interrupt
+    // bucket n counts interrupts that took [2^n, 2^(n+1)) cycles, last one takes everything above
+    uint32_t buckets[IRQ_LATENCY_BUCKETS];
+};
+
+// per cpu so that counting doesn't bounce cache lines between cpus
+static IrqVectorStats irqStats[MAX_CPUS][IRQ_NUM_VECTORS];
+
+// names of cpu exceptions
+static const char* exceptionNames[IRQ_NUM_EXCEPTIONS] = {
+    "DIVIDE_ERROR", "DEBUG", "NMI", "BREAKPOINT", "OVERFLOW", "BOUND_RANGE_EXCEEDED",
+    "INVALID_OPCODE", "DEVICE_NOT_AVAILABLE", "DOUBLE_FAULT", "COPROCESSOR_SEGMENT_OVERRUN",
+    "INVALID_TSS", "SEGMENT_NOT_PRESENT", "STACK_SEGMENT_FAULT", "GENERAL_PROTECTION_FAULT",
+    "PAGE_FAULT", "RESERVED", "FLOATING_POINT_ERROR", "ALIGNMENT_CHECK", "MACHINE_CHECK",
+    "SIMD_FLOATING_POINT", "VIRTUALIZATION", "CONTROL_PROTECTION", "RESERVED", "RESERVED",
+    "RESERVED", "RESERVED", "RESERVED", "RESERVED", "HYPERVISOR_INJECTION",
+    "VMM_COMMUNICATION", "SECURITY", "RESERVED"
+};
+
+// address of entry stub for vector
+uint64_t GetIrqStub(uint8_t vector){
+    return reinterpret_cast<uint64_t>(IrqStubs) + vector * IRQ_STUB_SIZE;
+}
+
+// add handler at end of chain
+bool RegisterIrqHandler(uint8_t vector, IrqHandler handler, void* context){
+    uint64_t rflags = irqActionLock.LockIrqSave();
+
+    IrqAction* action = nullptr;
+    for(size_t i = 0; i < IRQ_MAX_HANDLERS; i++){
+        if(!irqActionPool[i].inUse){
+            action = &irqActionPool[i];
+            break;
+        }
+    }
+
+    if(action == nullptr){
+        irqActionLock.UnlockIrqRestore(rflags);
+        Printf("[-] No space left to register handler for vector %u\n", vector);
+        return false;
+    }
+
+    action->handler = handler;
+    action->context = context;
+    action->next = nullptr;
+    action->inUse = true;
+
+    // action is filled before it's visible to dispatch
+    IrqAction** tail = &irqActions[vector];
+    while(*tail != nullptr){
+        tail = &(*tail)->next;
+    }
+    Rcu::Assign(*tail, action);
+
+    irqActionLock.UnlockIrqRestore(rflags);
+    return true;
+}
+
+// first fit search in dynamic range
+int AllocateIrqVectors(uint8_t count, uint8_t align){
+    if((count == 0) || (align == 0)){
+        return -1;
+    }
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+
+    // start from first aligned vector in range
+    size_t first = (IRQ_DYNAMIC_VECTOR_START + align - 1) / align * align;
+    for(size_t v = first; v + count - 1 <= IRQ_DYNAMIC_VECTOR_END; v += align){
+        bool free = true;
+        for(size_t i = 0; i < count; i++){
+            if(irqVectorAllocated[v + i]){
+                free = false;
+                break;
+            }
+        }
+
+        if(free){
+            for(size_t i = 0; i < count; i++){
+                irqVectorAllocated[v + i] = true;
+            }
+            RestoreInterrupts(rflags);
+            return int(v);
+        }
+    }
+
+    RestoreInterrupts(rflags);
+    Printf("[-] No free interrupt vectors (requested %u)\n", count);
+    return -1;
+}
+
+// release vectors
+void FreeIrqVectors(uint8_t vector, uint8_t count){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    for(size_t i = 0; i < count; i++){
+        irqVectorAllocated[vector + i] = false;
+    }
+    RestoreInterrupts(rflags);
+}
+
+// slot goes back to pool once no cpu can be running through it
+static void FreeIrqAction(void* context){
+    __atomic_store_n(&static_cast<IrqAction*>(context)->inUse, false, __ATOMIC_RELEASE);
+}
+
+// unlink handler from chain, unlinked action still points to rest of chain
+// so a cpu that's currently on it finishes walking normally
+bool UnregisterIrqHandler(uint8_t vector, IrqHandler handler, void* context){
+    uint64_t rflags = irqActionLock.LockIrqSave();
+
+    for(IrqAction** link = &irqActions[vector]; *link != nullptr; link = &(*link)->next){
+        IrqAction* action = *link;
+        if((action->handler == handler) && (action->context == context)){
+            Rcu::Assign(*link, action->next);
+            Rcu::Call(&action->rcu, FreeIrqAction, action);
+            irqActionLock.UnlockIrqRestore(rflags);
+            return true;
+        }
+    }
+
+    irqActionLock.UnlockIrqRestore(rflags);
+    return false;
+}
+
+// nobody handled an exception, nothing else can be done
+[[noreturn]] static void PanicOnException(InterruptContext* frame){
+    PanicPrintf("Caught #%s (vector %lu)\n", exceptionNames[frame->vector], frame->vector);
+
+    if(frame->vector == 0x0e){
+        PanicPrintf("\tFAULTING ADDRESS (CR2) : 0x%lx\n", ReadCR2());
+    }
+
+    PanicPrintf("\tINSTRUCTION POINTER (RIP) : 0x%lx\n"
+          "\tCODE SEGMENT (CS) : 0x%lx\n"
+          "\tFLAGS REGISTER (RFLAGS) : 0x%lx\n"
+          "\tSTACK POINTER (RSP) : 0x%lx\n"
+          "\tSTACK SEGMENT (SS) : 0x%lx\n"
+          "\tERROR CODE : %lu\n",
+          frame->rip, frame->cs, frame->rflags, frame->rsp, frame->ss, frame->errorCode);
+
+    PanicPrintf("\tRAX : 0x%lx RBX : 0x%lx RCX : 0x%lx RDX : 0x%lx\n"
+          "\tRSI : 0x%lx RDI : 0x%lx RBP : 0x%lx\n",
+          frame->rax, frame->rbx, frame->rcx, frame->rdx, frame->rsi, frame->rdi, frame->rbp);
+
+    EternalHalt();
+    __builtin_unreachable();
+}
+
+// tell interrupt controller that we are done
+static void AcknowledgeInterrupt(uint8_t vector, bool handled){
+    // spurious interrupts are never in service
+    if(vector == APIC_SPURIOUS_VECTOR){
+        return;
+    }
+
+    if(APIC::IsEnabled()){
+        APIC::EndOfInterrupt();
+        return;
+    }
+
+    // pic only knows about it's 16 irqs
+    uint8_t irq = vector - IRQ_VECTOR_BASE;
+    if(irq >= 16){
+        return;
+    }
+
+    // unhandled irq 7 and 15 are spurious
+    if(!handled && ((irq == 7) || (irq == 15))){
+        return;
+    }
+
+    SendEndOfInterrupt(irq);
+}
+
+// account time spent in hard handlers of vector
+static void RecordIrqLatency(uint8_t vector, uint64_t entry, uint64_t exit){
+    IrqVectorStats& stats = irqStats[GetCurrentCpuIndex()][vector];
+    uint64_t cycles = exit - entry;
+
+    if((stats.count == 0) || (cycles < stats.minCycles)){
+        stats.minCycles = cycles;
+    }
+    if(cycles > stats.maxCycles){
+        stats.maxCycles = cycles;
+    }
+    if(stats.count == 0){
+        stats.firstTimestamp = entry;
+    }
+
+    stats.count++;
+    stats.totalCycles += cycles;
+    stats.lastTimestamp = entry;
+
+    size_t bucket = 63 - __builtin_clzll(cycles | 1);
+    if(bucket >= IRQ_LATENCY_BUCKETS){
+        bucket = IRQ_LATENCY_BUCKETS - 1;
+    }
+    stats.buckets[bucket]++;
+}
+
+// called from common entry for every interrupt
+// statistics only cover hard handlers, softirqs are accounted separately
+extern "C" void InterruptDispatch(InterruptContext* frame){
+    uint8_t vector = uint8_t(frame->vector);
+    uint64_t start = ReadTSC();
+
+    // shared irqs : every handler gets a chance
+    // interrupts are disabled, so this is a read side critical section already
+    bool handled = false;
+    for(IrqAction* action = Rcu::Dereference(irqActions[vector]); action != nullptr; action = Rcu::Dereference(action->next)){
+        handled |= action->handler(frame, action->context);
+    }
+
+    if(!handled && (vector < IRQ_NUM_EXCEPTIONS)){
+        PanicOnException(frame);
+    }
+
+    if(vector >= IRQ_VECTOR_BASE){
+        AcknowledgeInterrupt(vector, handled);
+    }
+
+    RecordIrqLatency(vector, start, ReadTSC());
+
+    // run deferred work raised by handlers, only if interrupted code
+    // had interrupts enabled, so that it's never run inside a critical section
+    if((vector >= IRQ_VECTOR_BASE) && (frame->rflags & RFLAGS_INTERRUPT_ENABLE)){
+        // handlers are done and interrupted code could've been preempted,
+        // so it holds no rcu references either
+        if((PER_CPU(preemptCount)::Read() == 0) && !PER_CPU(softirqRunning)::Read()){
+            Rcu::NoteQuiescentState();
+        }
+        SoftIRQ::Run();
+    }
+}
+
+// number of interrupts on vector, all cpus combined
+uint64_t GetIrqCount(uint8_t vector){
+    uint64_t count = 0;
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        count += irqStats[cpu][vector].count;
+    }
+    return count;
+}
+
+// print stats of all vectors that got at least one interrupt
+// rate is shown as average cycles between two interrupts
+void ShowIrqStatistics(){
+    Printf("[+] Interrupt Statistics (cycles) :\n");
+    for(size_t v = 0; v < IRQ_NUM_VECTORS; v++){
+        for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+            const IrqVectorStats& stats = irqStats[cpu][v];
+            if(stats.count == 0){
+                continue;
+            }
+
+            uint64_t interval = 0;
+            if(stats.count > 1){
+                interval = (stats.lastTimestamp - stats.firstTimestamp) / (stats.count - 1);
+            }
+
+            Printf("\tCPU %lu Vector 0x%lx : %lu interrupts, min %lu, avg %lu, max %lu, every %lu\n",
+                   cpu, v, stats.count, stats.minCycles, stats.totalCycles / stats.count,
+                   stats.maxCycles, interval);
+            Printf("\t\tavg %lu ns, max %lu ns, every %lu us\n",
+                   Clock::CyclesToNs(stats.totalCycles / stats.count), Clock::CyclesToNs(stats.maxCycles),
+                   Clock::CyclesToNs(interval) / 1000);
+
+            // only non empty buckets
+            Printf("\t\t");
+            for(size_t b = 0; b < IRQ_LATENCY_BUCKETS; b++){
+                if(stats.buckets[b] == 0){
+                    continue;
+                }
+
+                if(b == IRQ_LATENCY_BUCKETS - 1){
+                    Printf("[2^%lu+] %u  ", b, stats.buckets[b]);
+                }else{
+                    Printf("[2^%lu] %u  ", b, stats.buckets[b]);
+                }
+            }
+            Printf("\n");
+        }
+    }
+}
+
+// start a new measurement window
+void ResetIrqStatistics(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    memset(irqStats, 0, sizeof(irqStats));
+    RestoreInterrupts(rflags);
+}
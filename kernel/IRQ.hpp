@@ -0,0 +1,122 @@
+/**
+ *@file IRQ.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Common interrupt entry and handler registration
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRQ_HPP
+#define IRQ_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Constants.hpp"
+
+// total number of interrupt vectors
+#define IRQ_NUM_VECTORS 256
+// vectors below this are cpu exceptions
+#define IRQ_NUM_EXCEPTIONS 32
+// max number of handlers registered at once (all vectors combined)
+#define IRQ_MAX_HANDLERS 512
+// vectors handed out to devices (msi/msi-x) come from this range
+// below are exceptions and isa irqs, above are vectors used by apic itself
+#define IRQ_DYNAMIC_VECTOR_START 0x30
+#define IRQ_DYNAMIC_VECTOR_END 0xef
+// each entry stub is aligned to this size, stub for vector n is at IrqStubs + n * IRQ_STUB_SIZE
+#define IRQ_STUB_SIZE 16
+// number of log2 buckets in per vector latency histogram
+#define IRQ_LATENCY_BUCKETS 24
+// size of per cpu stack used by device interrupt handlers and softirqs run on their exit
+#define IRQ_STACK_SIZE (16*KB)
+
+// state saved by common interrupt entry
+// general purpose registers are pushed by entry code, vector and error code
+// by the stub (0 if cpu doesn't push one) and rest by the cpu itself
+struct InterruptContext {
+    uint64_t r15, r14, r13, r12, r11, r10, r9, r8;
+    uint64_t rbp, rdi, rsi, rdx, rcx, rbx, rax;
+    uint64_t vector;
+    uint64_t errorCode;
+    uint64_t rip;
+    uint64_t cs;
+    uint64_t rflags;
+    uint64_t rsp;
+    uint64_t ss;
+};
+
+// interrupt handler, context is what was passed during registration
+// must return true if interrupt was handled
+typedef bool (*IrqHandler)(InterruptContext* frame, void* context);
+
+// Every vector in idt points to a small stub that pushes vector number and
+// jumps to common entry code. Common entry saves registers and calls the dispatcher,
+// which runs all handlers registered for that vector (shared irqs are chained),
+// sends end of interrupt and keeps per vector counters and timings.
+// Unhandled exceptions end up in a panic with register dump.
+
+// allocate irq stack for current cpu, until this is called
+// device interrupts run on whatever stack was active
+void InitializeIrqStack();
+
+// get address of entry stub for given vector, this goes in idt
+uint64_t GetIrqStub(uint8_t vector);
+
+// add handler to given vector, more than one handler can be registered for a vector
+// handlers are called in order of registration
+// returns false if there's no space for more handlers
+bool RegisterIrqHandler(uint8_t vector, IrqHandler handler, void* context);
+
+// allocate count consecutive vectors from dynamic range, first one aligned to align
+// (msi with multiple messages needs this), returns first vector or -1 if none are free
+int AllocateIrqVectors(uint8_t count, uint8_t align = 1);
+
+// give vectors back, handlers must be unregistered before this
+void FreeIrqVectors(uint8_t vector, uint8_t count);
+
+// remove a previously registered handler, a cpu already in dispatch may still call it
+// once more, it's slot is reused only after an rcu grace period (see Rcu.hpp)
+bool UnregisterIrqHandler(uint8_t vector, IrqHandler handler, void* context);
+
+// Dispatcher takes a tsc timestamp before and after running handlers of a vector
+// and keeps per cpu counters : count, min/avg/max cycles, log2 histogram of
+// cycles and time between first and latest interrupt (gives the rate).
+
+// get number of times interrupt was received on given vector
+uint64_t GetIrqCount(uint8_t vector);
+
+// show count, latency histogram and rate of each vector on each cpu
+void ShowIrqStatistics();
+
+// clear all interrupt statistics
+void ResetIrqStatistics();
+
+#endif // IRQ_HPP
@@ -0,0 +1,239 @@
+/**
+ *@file Idle.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Idle driver, mwait c-states with hlt fallback
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Idle.hpp"
+#include "CPU.hpp"
+#include "APIC.hpp"
+#include "SMP.hpp"
+#include "Clock.hpp"
+#include "Scheduler.hpp"
+#include "Printf.hpp"
+
+// typical exit latency and target residency of mwait c-states in us, indexed by c-state
+// there are no acpi _CST tables to read real ones from, so these err on the deep side
+static const uint64_t mwaitExitLatencyUs[IDLE_MAX_STATES] = {0, 2, 70, 85, 124, 200, 480, 890};
+static const uint64_t mwaitTargetResidencyUs[IDLE_MAX_STATES] = {0, 2, 100, 200, 800, 800, 5000, 5000};
+static const char* mwaitStateNames[IDLE_MAX_STATES] = {
+    "C0", "C1", "C2", "C3", "C4", "C5", "C6", "C7"
+};
+
+// leaf 5 edx has number of sub states of c-state n in bits [4n, 4n+4)
+void Idle::Initialize(){
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(1, 0, eax, ebx, ecx, edx);
+
+    if(ecx & CPUID_1_ECX_MONITOR){
+        hasMwait = true;
+
+        // apic timer may stop below c1, we'd sleep through our own timer events
+        CPUID(6, 0, eax, ebx, ecx, edx);
+        bool timerRunsInDeepStates = eax & CPUID_6_EAX_ARAT;
+
+        CPUID(5, 0, eax, ebx, ecx, edx);
+
+        // without extensions only c1 is known to exist
+        uint32_t substates = (ecx & CPUID_5_ECX_EXTENSIONS) ? edx : (uint32_t(1) << 4);
+        if(!timerRunsInDeepStates){
+            substates &= uint32_t(0xf) << 4;
+        }
+        for(size_t cstate = 1; cstate < IDLE_MAX_STATES; cstate++){
+            if(((substates >> (4 * cstate)) & 0xf) == 0){
+                continue;
+            }
+
+            State& state = states[numStates++];
+            state.name = mwaitStateNames[cstate];
+            state.mwait = true;
+            state.hint = uint32_t(cstate - 1) << 4;
+            state.exitLatency = mwaitExitLatencyUs[cstate] * 1000;
+            state.targetResidency = mwaitTargetResidencyUs[cstate] * 1000;
+            deepestHint = state.hint;
+        }
+    }
+
+    // mwait present but no c-states listed, or no mwait at all
+    if(numStates == 0){
+        hasMwait = false;
+        State& state = states[numStates++];
+        state.name = "HLT";
+        state.mwait = false;
+        state.exitLatency = mwaitExitLatencyUs[1] * 1000;
+        state.targetResidency = mwaitTargetResidencyUs[1] * 1000;
+    }
+
+    if(hasMwait){
+        Printf("[+] Idle uses MWAIT, %lu C-states, deepest hint %x\n", numStates, deepestHint);
+    }else{
+        Printf("[!] MONITOR/MWAIT not available, idle uses HLT\n");
+    }
+}
+
+// armed timer is the only thing known for sure, history covers the rest
+uint64_t Idle::PredictIdleTime(const CpuState& cpu, uint64_t now){
+    uint64_t predicted = ~uint64_t(0);
+
+    uint64_t deadline = Scheduler::GetTimerDeadline();
+    if(deadline != 0){
+        predicted = (deadline > now) ? (deadline - now) : 0;
+    }
+
+    if((cpu.averageIdle != 0) && (cpu.averageIdle < predicted)){
+        predicted = cpu.averageIdle;
+    }
+
+    return predicted;
+}
+
+// states are sorted shallow to deep
+size_t Idle::SelectState(uint64_t predicted){
+    size_t selected = 0;
+    for(size_t i = 1; i < numStates; i++){
+        if((states[i].targetResidency > predicted) ||
+           (states[i].exitLatency > (predicted >> IDLE_EXIT_LATENCY_SHIFT))){
+            break;
+        }
+        selected = i;
+    }
+    return selected;
+}
+
+// state word is claimed with a compare exchange, so a wakeup requested
+// just before we got here is never lost, we just don't sleep
+void Idle::Enter(){
+    size_t index = GetCurrentCpuIndex();
+    CpuState& cpu = cpus[index];
+    uint32_t* wakeup = &GetCpuData(index)->idleWakeup;
+
+    uint64_t start = Clock::NowNs();
+    size_t selected = SelectState(PredictIdleTime(cpu, start));
+    const State& state = states[selected];
+
+    uint32_t expected = IDLE_RUNNING;
+    uint32_t mode = state.mwait ? IDLE_POLLING : IDLE_HALTED;
+    if(!__atomic_compare_exchange_n(wakeup, &expected, mode, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+        __atomic_store_n(wakeup, IDLE_RUNNING, __ATOMIC_RELEASE);
+        cpu.flagWakeups++;
+        asm volatile("sti" ::: "memory");
+        return;
+    }
+
+    if(state.mwait){
+        // a write between claiming the word and arming monitor isn't seen by mwait, check again
+        Monitor(wakeup);
+        if(__atomic_load_n(wakeup, __ATOMIC_ACQUIRE) == IDLE_POLLING){
+            StiMwait(state.hint);
+        }else{
+            asm volatile("sti" ::: "memory");
+        }
+    }else{
+        asm volatile("sti; hlt" ::: "memory");
+    }
+
+    // pending interrupt that woke us has been taken by now
+    asm volatile("cli" ::: "memory");
+    if(__atomic_exchange_n(wakeup, IDLE_RUNNING, __ATOMIC_ACQ_REL) == IDLE_WAKEUP_REQUESTED){
+        cpu.flagWakeups++;
+    }
+
+    uint64_t idle = Clock::NowNs() - start;
+    cpu.entries[selected]++;
+    cpu.residency[selected] += idle;
+    cpu.averageIdle = cpu.averageIdle - (cpu.averageIdle >> IDLE_HISTORY_SHIFT) + (idle >> IDLE_HISTORY_SHIFT);
+    asm volatile("sti" ::: "memory");
+}
+
+// Enter's own bookkeeping is skipped if that's where idle thread was preempted
+void Idle::Exit(){
+    __atomic_store_n(&GetCurrentCpuData()->idleWakeup, IDLE_RUNNING, __ATOMIC_RELEASE);
+}
+
+// a cpu in mwait wakes up from the write itself, only hlt needs an ipi
+bool Idle::WakeCpu(size_t cpu){
+    CpuState& self = cpus[GetCurrentCpuIndex()];
+    uint32_t previous = __atomic_exchange_n(&GetCpuData(cpu)->idleWakeup, IDLE_WAKEUP_REQUESTED, __ATOMIC_ACQ_REL);
+
+    switch(previous){
+    case IDLE_POLLING:
+        self.ipisAvoided++;
+        return true;
+    case IDLE_HALTED:
+        if(APIC::IsEnabled()){
+            APIC::SendIPI(GetCpuData(cpu)->apicID, APIC_RESCHEDULE_VECTOR);
+            self.ipisSent++;
+        }
+        return true;
+    case IDLE_WAKEUP_REQUESTED:
+        // someone else already woke it
+        return true;
+    default:
+        // running, it sees the request before it sleeps next time
+        return false;
+    }
+}
+
+// interrupts stay off, only a write to wakeup word or an nmi ends mwait
+void Idle::HaltForever(){
+    asm volatile("cli" ::: "memory");
+    while(true){
+        if(hasMwait){
+            Monitor(&GetCurrentCpuData()->idleWakeup);
+            Mwait(deepestHint);
+        }else{
+            asm volatile("hlt");
+        }
+    }
+}
+
+// per cpu counters
+void Idle::ShowStatistics(){
+    Printf("[+] Idle Statistics :\n");
+    for(size_t index = 0; index < MAX_CPUS; index++){
+        if(!IsCpuOnline(index)){
+            continue;
+        }
+
+        const CpuState& cpu = cpus[index];
+        Printf("\tCPU %lu : average idle %lu ns, %lu woken by write, %lu ipis sent, %lu ipis avoided\n",
+               index, cpu.averageIdle, cpu.flagWakeups, cpu.ipisSent, cpu.ipisAvoided);
+        for(size_t i = 0; i < numStates; i++){
+            if(cpu.entries[i] == 0){
+                continue;
+            }
+
+            Printf("\t\t%s : %lu entries, %lu us total\n", states[i].name, cpu.entries[i], cpu.residency[i] / 1000);
+        }
+    }
+}
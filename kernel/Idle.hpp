@@ -0,0 +1,120 @@
+/**
+ *@file Idle.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Idle driver, mwait c-states with hlt fallback
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IDLE_HPP
+#define IDLE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "PerCpu.hpp"
+
+// max number of idle states (mwait c1-c7, or just hlt)
+#define IDLE_MAX_STATES 8
+// weight of newest sample in average idle time is 1/2^this
+#define IDLE_HISTORY_SHIFT 3
+// exit latency of chosen state is at most 1/2^this of predicted idle time
+#define IDLE_EXIT_LATENCY_SHIFT 2
+
+// value of per cpu idleWakeup word (see PerCpu.hpp)
+enum IdleWakeup : uint32_t {
+    IDLE_RUNNING = 0, // not sleeping
+    IDLE_POLLING, // in mwait on idleWakeup, writing it is enough to wake cpu
+    IDLE_HALTED, // in hlt, needs an interrupt
+    IDLE_WAKEUP_REQUESTED // someone wants this cpu to go around idle loop again
+};
+
+// Idle cpus wait in mwait monitoring their own idleWakeup word, so another cpu
+// wakes them up with a plain write instead of an ipi. Cpus without monitor/mwait use hlt
+// and are woken with a reschedule ipi.
+// Depth of c-state is chosen from predicted idle time : until next armed timer event,
+// cut short by a running average of how long this cpu actually stayed idle before
+// (device interrupts and wakeups aren't known in advance). Deepest state whose target
+// residency fits and whose exit latency is a small part of that time is used, so waking
+// up doesn't delay whatever ends the idle period. C-states come from cpuid leaf 5, their latencies are typical
+// values since there's no acpi _CST parser.
+struct Idle {
+    // detect mwait and it's c-states
+    static void Initialize();
+
+    // sleep until an interrupt or WakeCpu, interrupts must be disabled and are enabled on return
+    static void Enter();
+
+    // idle thread is switched away from, possibly from an interrupt that ended Enter
+    // this cpu isn't sleeping anymore, so wakers must interrupt it again
+    static void Exit();
+
+    // make an idle cpu go around idle loop once more
+    // returns false if cpu isn't idle, it's not interrupted then
+    static bool WakeCpu(size_t cpu);
+
+    // stop this cpu for good, in deepest state available with interrupts disabled
+    [[noreturn]] static void HaltForever();
+
+    // show per cpu residency in each state and how wakeups were delivered
+    static void ShowStatistics();
+
+private:
+    struct State {
+        const char* name;
+        bool mwait; // hlt otherwise
+        uint32_t hint; // eax of mwait
+        uint64_t exitLatency; // ns
+        uint64_t targetResidency; // ns, shorter stays cost more than they save
+    };
+
+    struct CpuState {
+        uint64_t averageIdle; // ns, running average of idle periods
+        uint64_t entries[IDLE_MAX_STATES];
+        uint64_t residency[IDLE_MAX_STATES]; // ns
+        uint64_t flagWakeups; // woken by a write, no interrupt involved
+        uint64_t ipisSent; // to cpus in hlt
+        uint64_t ipisAvoided; // cpus in mwait woken with a write instead
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    // expected length of this idle period in ns, ~0 if nothing is known
+    static uint64_t PredictIdleTime(const CpuState& cpu, uint64_t now);
+
+    // deepest state that pays off for given idle time
+    static size_t SelectState(uint64_t predicted);
+
+    static inline State states[IDLE_MAX_STATES] = {};
+    static inline size_t numStates = 0;
+    static inline bool hasMwait = false;
+    static inline uint32_t deepestHint = 0;
+    static inline CpuState cpus[MAX_CPUS] = {};
+};
+
+#endif // IDLE_HPP
@@ -38,95 +38,129 @@
 
 #include "Interrupts.hpp"
 #include "Keyboard.hpp"
+#include "KeyCodes.hpp"
 #include "Panic.hpp"
 #include "IO.hpp"
+#include "CPU.hpp"
+#include "Swap.hpp"
+#include "SamePageMerging.hpp"
+#include "APIC.hpp"
+#include "IRQ.hpp"
+#include "IrqPoll.hpp"
+#include "SoftIRQ.hpp"
+#include "Scheduler.hpp"
+#include "TimerWheel.hpp"
+#include "LockStats.hpp"
+#include "Rcu.hpp"
+#include "Idle.hpp"
 
 
-// without errcode
-INTERRUPT_API void DefaultInterruptHandlerNoError(InterruptFrame* frame){
-    PanicPrintf("REACHED DEFAULT INTERRUPT HANDLER!\n");
-
-    // print information
-    PanicPrintf("\tINSTRUCTION POINTER (RIP) : 0x%lx\n"
-          "\tFLAGS REGISTER (RFLAGS) : 0x%lx\n"
-          "\tCODE SEGMENT (CS) : 0x%x\n",
-          frame->rip, frame->rflags, frame->cs);
+// 0x0e
+bool PageFaultHandler(InterruptContext* frame, void* context){
+    (void)context;
+    uint64_t faultAddress = ReadCR2();
+
+    // page might have been swapped out, bring it back transparently
+    if(Swap::HandlePageFault(faultAddress, frame->errorCode)){
+        return true;
+    }
+
+    // write to a shared page, give it a private copy
+    if(SamePageMerging::HandlePageFault(faultAddress, frame->errorCode)){
+        return true;
+    }
+
+    // dispatcher will panic
+    return false;
 }
 
-// with an errcode
-INTERRUPT_API void DefaultInterruptHandlerWithError(InterruptFrame* frame, uint64_t errcode){
-    PanicPrintf("REACHED DEFAULT INTERRUPT HANDLER!\n");
-
-    // print information
-    PanicPrintf("\tINSTRUCTION POINTER (RIP) : 0x%lx\n"
-          "\tCODE SEGMENT (CS) : 0x%x\n"
-          "\tFLAGS REGISTER (RFLAGS) : 0x%lx\n"
-          "\tSTACK POINTER (RSP) : 0x%lx\n"
-          "\tSTACK SEGMENT (SS) : 0x%x\n"
-          "\tERROR CODE : %lu\n",
-          frame->rip, frame->cs, frame->rflags, frame->rsp, frame->ss, errcode);
+static void EndMasterPIC(){
+    PortWriteByte(PICMASTER_COMMAND, PIC_EOI);
 }
 
-// 0x08
-INTERRUPT_API void DoubleFaultHandler(InterruptFrame* frame, uint64_t errorcode){
-    PanicPrintf("Caught #DOUBLE_FAULT\n");
-
-    PanicPrintf("\tINSTRUCTION POINTER (RIP) : 0x%lx\n"
-          "\tCODE SEGMENT (CS) : 0x%x\n"
-          "\tFLAGS REGISTER (RFLAGS) : 0x%lx\n"
-          "\tSTACK POINTER (RSP) : 0x%lx\n"
-          "\tSTACK SEGMENT (SS) : 0x%x\n"
-          "\tERROR CODE : %lu\n",
-          frame->rip, frame->cs, frame->rflags, frame->rsp, frame->ss, errorcode);
+static void EndSlavePIC(){
+    PortWriteByte(PICMASTER_COMMAND, PIC_EOI);
+    PortWriteByte(PICSLAVE_COMMAND, PIC_EOI);
+}
 
-    // double fault can't be recovered from
-    while(true) asm("hlt");
+// apic eoi is a single register write, pic needs port i/o
+void SendEndOfInterrupt(uint8_t irq){
+    if(APIC::IsEnabled()){
+        APIC::EndOfInterrupt();
+    }else if(irq >= 8){
+        EndSlavePIC();
+    }else{
+        EndMasterPIC();
+    }
 }
 
-// 0x0d
-INTERRUPT_API void GeneralProtectionFaultHandler(InterruptFrame* frame, uint64_t errorcode){
-    PanicPrintf("Caught #GENERAL_PROTECTION_FAULT\n");
+// mask/unmask isa irq on whichever interrupt controller is in use
+void SetIRQMask(uint8_t irq, bool mask){
+    if(APIC::IsEnabled()){
+        APIC::MaskIRQ(irq, mask);
+        return;
+    }
+
+    uint16_t port = irq < 8 ? PICMASTER_DATA : PICSLAVE_DATA;
+    uint8_t bit = uint8_t(1 << (irq & 7));
+    uint8_t value = PortReadByte(port);
+    PortWriteByte(port, mask ? (value | bit) : (value & ~bit));
+}
 
-    PanicPrintf("\tINSTRUCTION POINTER (RIP) : 0x%lx\n"
-          "\tCODE SEGMENT (CS) : 0x%x\n"
-          "\tFLAGS REGISTER (RFLAGS) : 0x%lx\n"
-          "\tSTACK POINTER (RSP) : 0x%lx\n"
-          "\tSTACK SEGMENT (SS) : 0x%x\n"
-          "\tERROR CODE : %lu\n",
-          frame->rip, frame->cs, frame->rflags, frame->rsp, frame->ss, errorcode);
+// keyboard is drained by poller, interrupt only kicks it off
+static IrqPoller keyboardPoller;
 
-    while(true) asm("hlt");
+static size_t PollKeyboard(void* context, size_t budget){
+    (void)context;
+    return ReadKeyboardController(budget);
 }
 
-// 0x0e
-INTERRUPT_API void PageFaultHandler(InterruptFrame* frame, uint64_t errorcode){
-    PanicPrintf("Caught #PAGE_FAULT\n");
-
-    PanicPrintf("\tINSTRUCTION POINTER (RIP) : 0x%lx\n"
-          "\tCODE SEGMENT (CS) : 0x%x\n"
-          "\tFLAGS REGISTER (RFLAGS) : 0x%lx\n"
-          "\tSTACK POINTER (RSP) : 0x%lx\n"
-          "\tSTACK SEGMENT (SS) : 0x%x\n"
-          "\tERROR CODE : %lu\n",
-          frame->rip, frame->cs, frame->rflags, frame->rsp, frame->ss, errorcode);
-
-    while(true) asm("hlt");
+static void MaskKeyboard(void* context, bool mask){
+    (void)context;
+    SetIRQMask(KEYBOARD_IRQ, mask);
 }
 
-INTERRUPT_CALLEE_API void EndMasterPIC(){
-    PortWriteByte(PICMASTER_COMMAND, PIC_EOI);
-}
+// end of interrupt is sent by dispatcher
+// scancodes are read later in softirq by keyboard poller
+bool KeyboardInterruptHandler(InterruptContext* frame, void* context){
+    (void)frame;
+    (void)context;
 
-INTERRUPT_CALLEE_API void EndSlavePIC(){
-    PortWriteByte(PICMASTER_COMMAND, PIC_EOI);
-    PortWriteByte(PICSLAVE_COMMAND, PIC_EOI);
+    IrqPoll::Schedule(&keyboardPoller);
+    return true;
 }
 
-INTERRUPT_API void KeyboardInterruptHandler(InterruptFrame* frame){
-    // 0x60 is the port at which ps2 keyboard is located
-    uint8_t scancode = PortReadByte(0x60);
-    HandleKeyboardEvent(scancode);
-    EndMasterPIC();
+// register handlers for exceptions and devices
+void InstallInterruptHandlers(){
+    InitializeKeyboard();
+
+    IrqPoll::Initialize();
+    IrqPoll::Register(&keyboardPoller, "keyboard", PollKeyboard, MaskKeyboard, nullptr);
+
+    RegisterIrqHandler(0x0e, PageFaultHandler, nullptr);
+    RegisterIrqHandler(IRQ_VECTOR_BASE + KEYBOARD_IRQ, KeyboardInterruptHandler, nullptr);
+
+    // F12 dumps interrupt statistics, F11 starts a new measurement
+    RegisterKeyboardHotkey(F12_PRESSED, ShowIrqStatistics);
+    RegisterKeyboardHotkey(F11_PRESSED, ResetIrqStatistics);
+    // F10 shows how many interrupts polling saved
+    RegisterKeyboardHotkey(F10_PRESSED, IrqPoll::ShowStatistics);
+    // F9 shows threads and context switch counters
+    RegisterKeyboardHotkey(F9_PRESSED, Scheduler::ShowStatistics);
+    // F8 shows timer wheel counters
+    RegisterKeyboardHotkey(F8_PRESSED, TimerWheel::ShowStatistics);
+    // F7 shows lock contention (needs ENABLE_LOCK_DEBUG)
+    RegisterKeyboardHotkey(F7_PRESSED, ShowLockStatistics);
+    // F6 shows grace periods and rcu callbacks
+    RegisterKeyboardHotkey(F6_PRESSED, Rcu::ShowStatistics);
+    // F5 shows time spent in each c-state and how idle cpus were woken
+    RegisterKeyboardHotkey(F5_PRESSED, Idle::ShowStatistics);
+    // F4 shows swapped pages, compression ratio and swap in latency
+    RegisterKeyboardHotkey(F4_PRESSED, Swap::ShowStatistics);
+    // F3 shows merged pages and copy on write breaks
+    RegisterKeyboardHotkey(F3_PRESSED, SamePageMerging::ShowStatistics);
+    // F2 shows softirq runs and how often work was deferred
+    RegisterKeyboardHotkey(F2_PRESSED, SoftIRQ::ShowStatistics);
 }
 
 // remap pic
@@ -173,3 +207,9 @@ void RemapPIC(){
     // sets the interrupt flag in rflags/eflags register
     asm volatile ("sti");
 }
+
+// mask everything
+void DisablePIC(){
+    PortWriteByte(PICMASTER_DATA, 0b11111111);
+    PortWriteByte(PICSLAVE_DATA, 0b11111111);
+}
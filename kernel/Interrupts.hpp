@@ -43,6 +43,9 @@
 #define PICSLAVE_DATA 0xa1
 #define PIC_EOI 0x20
 
+// isa irq numbers
+#define KEYBOARD_IRQ 1
+
 // reference : https://www.eeeguide.com/8259-programmable-interrupt-controller/
 // ICWs are Initialization Command Words
 // They are given to PIC (Programmable Interrupt Controller) during initialization
@@ -54,34 +57,37 @@
 
 #include <cstdint>
 #include "Common.hpp"
+#include "IRQ.hpp"
 
 // Reference : https://wiki.osdev.org/Exceptions
 
-// this is made as defined in intel architecture manual
-struct InterruptFrame {
-    uint64_t rip;
-    uint16_t cs;
-    uint64_t rflags;
-    uint64_t rsp;
-    uint16_t ss;
-} PACKED_STRUCT;
-
-// default exception handlers
-INTERRUPT_API void DefaultInterruptHandlerNoError(InterruptFrame* frame);
-INTERRUPT_API void DefaultInterruptHandlerWithError(InterruptFrame* frame, uint64_t errcode);
-
-// double fault = 0x08
-// the processor always pushes 0 as errorcode
-INTERRUPT_API void DoubleFaultHandler(InterruptFrame* frame, uint64_t errorcode);
-// general protection fault = 0x0d
-INTERRUPT_API void GeneralProtectionFaultHandler(InterruptFrame* frame, uint64_t errorcode);
-// page fault handler = 0x0e
-INTERRUPT_API void PageFaultHandler(InterruptFrame* frame, uint64_t errocode);
-// keyboard interrupt handler
-INTERRUPT_API void KeyboardInterruptHandler(InterruptFrame* frame);
+// page fault error code bits
+#define PAGE_FAULT_PRESENT (1 << 0) // page was present (protection violation)
+#define PAGE_FAULT_WRITE (1 << 1) // fault was caused by a write
+#define PAGE_FAULT_USER (1 << 2) // fault happened in user mode
+#define PAGE_FAULT_RESERVED_WRITE (1 << 3) // reserved bit was set in a paging structure
+#define PAGE_FAULT_INSTRUCTION_FETCH (1 << 4) // fault was caused by an instruction fetch
+
+// page fault = 0x0e
+// brings back swapped out pages and breaks copy on write sharing
+bool PageFaultHandler(InterruptContext* frame, void* context);
+// keyboard irq handler
+bool KeyboardInterruptHandler(InterruptContext* frame, void* context);
+
+// register exception and device handlers with dispatcher (see IRQ.hpp)
+void InstallInterruptHandlers();
 
 // remap pic chip so that our interrupts don't collide with
 // pic chip's interrupts
 void RemapPIC();
 
+// mask all pic interrupts, done when apic takes over
+void DisablePIC();
+
+// mask/unmask given isa irq on whichever interrupt controller is in use
+void SetIRQMask(uint8_t irq, bool mask);
+
+// acknowledge given isa irq to whichever interrupt controller is in use
+void SendEndOfInterrupt(uint8_t irq);
+
 #endif // INTERRUPTS_H_
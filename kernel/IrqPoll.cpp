@@ -0,0 +1,185 @@
+/**
+ *@file IrqPoll.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Interrupt mitigation by polling devices from softirq
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "IrqPoll.hpp"
+#include "SoftIRQ.hpp"
+#include "CPU.hpp"
+#include "Printf.hpp"
+
+// setup
+void IrqPoll::Initialize(){
+    SoftIRQ::Register(SOFTIRQ_POLL, RunPollers, nullptr);
+}
+
+// fill poller
+bool IrqPoll::Register(IrqPoller* poller, const char* name, IrqPollFunction poll,
+                       IrqMaskFunction setMask, void* context){
+    if(numPollers == IRQ_POLL_MAX_POLLERS){
+        Printf("[-] No space left to register poller %s\n", name);
+        return false;
+    }
+
+    poller->name = name;
+    poller->poll = poll;
+    poller->setMask = setMask;
+    poller->context = context;
+    poller->budget = IRQ_POLL_DEFAULT_BUDGET;
+    poller->linger = 0;
+    poller->emptyPolls = 0;
+    poller->eventsPerInterrupt = 1 << 4;
+    poller->roundEvents = 0;
+    poller->scheduled = false;
+    poller->next = nullptr;
+    poller->interrupts = 0;
+    poller->events = 0;
+    poller->polls = 0;
+
+    pollers[numPollers++] = poller;
+    return true;
+}
+
+// runs in hard interrupt context with interrupts disabled
+void IrqPoll::Schedule(IrqPoller* poller){
+    poller->interrupts++;
+
+    // events handled since last interrupt tell how busy device is
+    poller->eventsPerInterrupt = (poller->eventsPerInterrupt * 7 + (poller->roundEvents << 4)) / 8;
+    poller->roundEvents = 0;
+
+    // keep busy devices in polling mode for longer, go back to interrupts quickly otherwise
+    if(poller->eventsPerInterrupt >= IRQ_POLL_BUSY_THRESHOLD){
+        if(poller->linger < IRQ_POLL_MAX_LINGER) poller->linger++;
+    }else{
+        poller->linger = 0;
+    }
+
+    // already being polled
+    if(poller->scheduled){
+        return;
+    }
+
+    poller->setMask(poller->context, true);
+    poller->scheduled = true;
+    poller->emptyPolls = 0;
+
+    poller->next = PER_CPU(pollList)::Read();
+    PER_CPU(pollList)::Write(poller);
+
+    SoftIRQ::Raise(SOFTIRQ_POLL);
+}
+
+// one budgeted round
+bool IrqPoll::PollOnce(IrqPoller* poller){
+    size_t budget = poller->budget;
+    size_t n = poller->poll(poller->context, budget);
+    poller->polls++;
+    poller->events += n;
+    poller->roundEvents += n;
+
+    // budget follows load
+    if(n == budget){
+        if(budget < IRQ_POLL_MAX_BUDGET) poller->budget = budget * 2;
+    }else if((n < budget / 4) && (budget > IRQ_POLL_MIN_BUDGET)){
+        poller->budget = budget / 2;
+    }
+
+    if(n){
+        poller->emptyPolls = 0;
+        return true;
+    }
+
+    if(poller->emptyPolls < poller->linger){
+        poller->emptyPolls++;
+        return true;
+    }
+
+    // Device is idle, switch back to interrupts.
+    // Events that arrived while interrupt was masked may not raise one after unmask,
+    // so poll once more. Interrupts are off so that Schedule doesn't see a half done switch.
+    uint64_t rflags = SaveAndDisableInterrupts();
+    poller->setMask(poller->context, false);
+
+    n = poller->poll(poller->context, budget);
+    if(n){
+        poller->events += n;
+        poller->roundEvents += n;
+        poller->setMask(poller->context, true);
+        RestoreInterrupts(rflags);
+        return true;
+    }
+
+    poller->scheduled = false;
+    RestoreInterrupts(rflags);
+    return false;
+}
+
+// softirq handler, interrupts are enabled here
+void IrqPoll::RunPollers(void* context){
+    (void)context;
+
+    // take whole list, interrupt handlers add to it
+    IrqPoller* list = PER_CPU(pollList)::Exchange(nullptr);
+
+    bool busy = false;
+    while(list != nullptr){
+        IrqPoller* poller = list;
+        list = list->next;
+
+        if(PollOnce(poller)){
+            uint64_t rflags = SaveAndDisableInterrupts();
+            poller->next = PER_CPU(pollList)::Read();
+            PER_CPU(pollList)::Write(poller);
+            RestoreInterrupts(rflags);
+            busy = true;
+        }
+    }
+
+    // come back later, softirq restart limit keeps this from starving everything else
+    if(busy){
+        SoftIRQ::Raise(SOFTIRQ_POLL);
+    }
+}
+
+// statistics
+void IrqPoll::ShowStatistics(){
+    Printf("[+] Interrupt Polling Statistics :\n");
+    for(size_t i = 0; i < numPollers; i++){
+        IrqPoller* p = pollers[i];
+        uint64_t saved = p->events > p->interrupts ? p->events - p->interrupts : 0;
+        Printf("\t%s : %lu events, %lu interrupts, %lu interrupts saved, %lu polls, budget %lu\n",
+               p->name, p->events, p->interrupts, saved, p->polls, p->budget);
+    }
+}
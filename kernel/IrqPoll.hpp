@@ -0,0 +1,119 @@
+/**
+ *@file IrqPoll.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Interrupt mitigation by polling devices from softirq
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRQPOLL_HPP
+#define IRQPOLL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "PerCpu.hpp"
+
+// limits of adaptive poll budget (events processed in one poll call)
+#define IRQ_POLL_MIN_BUDGET 4
+#define IRQ_POLL_MAX_BUDGET 256
+#define IRQ_POLL_DEFAULT_BUDGET 16
+
+// max number of empty polls before interrupt is unmasked again
+#define IRQ_POLL_MAX_LINGER 8
+// events per interrupt (scaled by 16) above which device is considered busy
+// busy devices are polled a little longer before going back to interrupts
+#define IRQ_POLL_BUSY_THRESHOLD (4 << 4)
+
+// max number of pollers registered at once
+#define IRQ_POLL_MAX_POLLERS 16
+
+// process at most budget events, returns number of events processed
+typedef size_t (*IrqPollFunction)(void* context, size_t budget);
+// mask or unmask device interrupt
+typedef void (*IrqMaskFunction)(void* context, bool mask);
+
+// Under load, taking an interrupt for every event costs more than the event itself.
+// Interrupt handler of a polled device only calls Schedule, which masks the device
+// interrupt and queues the device for polling in softirq. Device is then polled in
+// budgeted rounds until it's idle, and only then is it's interrupt unmasked.
+// Budget and number of empty rounds before unmasking adapt to observed rate.
+struct IrqPoller {
+    const char* name;
+    IrqPollFunction poll;
+    IrqMaskFunction setMask;
+    void* context;
+
+    // adaptive state
+    size_t budget;
+    size_t linger; // empty polls allowed before unmasking
+    size_t emptyPolls; // consecutive empty polls in current round
+    uint64_t eventsPerInterrupt; // moving average, scaled by 16
+    uint64_t roundEvents; // events since last interrupt
+
+    bool scheduled;
+    IrqPoller* next;
+
+    // statistics
+    uint64_t interrupts;
+    uint64_t events;
+    uint64_t polls;
+};
+
+struct IrqPoll {
+    // register softirq
+    static void Initialize();
+
+    // setup poller for a device, poller must stay alive forever
+    static bool Register(IrqPoller* poller, const char* name, IrqPollFunction poll,
+                         IrqMaskFunction setMask, void* context);
+
+    // called from device interrupt handler, masks device interrupt and
+    // queues poller on this cpu
+    static void Schedule(IrqPoller* poller);
+
+    // show interrupts taken vs events processed for each poller
+    static void ShowStatistics();
+
+private:
+    // softirq handler
+    static void RunPollers(void* context);
+
+    // poll once, returns true if poller must stay scheduled
+    static bool PollOnce(IrqPoller* poller);
+
+    // pollers waiting to be polled are kept in per cpu data (see PerCpu.hpp)
+
+    // all registered pollers, for statistics
+    static inline IrqPoller* pollers[IRQ_POLL_MAX_POLLERS] = {};
+    static inline size_t numPollers = 0;
+};
+
+#endif // IRQPOLL_HPP
@@ -47,6 +47,21 @@
 #include "ACPI.hpp"
 #include "Puts.hpp"
 #include "Common.hpp"
+#include "SwapDevice.hpp"
+#include "APIC.hpp"
+#include "IRQ.hpp"
+#include "SoftIRQ.hpp"
+#include "SMP.hpp"
+#include "Scheduler.hpp"
+#include "Topology.hpp"
+#include "Clock.hpp"
+#include "ClockEvent.hpp"
+#include "TimerWheel.hpp"
+#include "Rcu.hpp"
+#include "Idle.hpp"
+#include "Tlb.hpp"
+#include "Swap.hpp"
+#include "SamePageMerging.hpp"
 
 // The following will be our kernel's entry point.
 // This function is called by Entry function in Entry.cpp in kernel/Bootloader
@@ -68,6 +83,7 @@ void KernelEntry() {
 
     // // create vmm
     VirtualMemoryManager vmm;
+    SetDefaultVirtualMemoryManager(vmm);
     Printf("[+] Created Virtual Memory Manager\n");
 
     // load gdt
@@ -77,10 +93,66 @@ void KernelEntry() {
     // install idt
     Printf("[+] Initializing Interrupt Descriptor Table\n");
     InstallIDT();
+    InstallInterruptHandlers();
+    InitializeIrqStack();
 
     // remap pic
     RemapPIC();
 
+    // switch to apic if there's one, pic stays as a fallback
+    // no interrupts while controllers are being switched
+    asm volatile("cli");
+    if(APIC::Initialize()){
+        DisablePIC();
+        APIC::RouteIRQ(KEYBOARD_IRQ, IRQ_VECTOR_BASE + KEYBOARD_IRQ);
+        Printf("[+] Using APIC for interrupt delivery\n");
+    }else{
+        Printf("[!] APIC not available, using PIC\n");
+    }
+    asm volatile("sti");
+
+    // everything that measures time needs calibrated tsc
+    Clock::Initialize();
+
+    // pick how idle cpus sleep, before any of them goes idle
+    Idle::Initialize();
+
+#ifdef ENABLE_APIC_BENCHMARK
+    // compares xapic and x2apic, leaves x2apic enabled if supported
+    APIC::Benchmark();
+#endif
+
+    // msr access is cheaper than mmio, use it when possible
+    APIC::EnableX2APIC();
+
+    // package and numa node of each cpu, used to pick where to steal work from
+    Topology::Initialize();
+
+    // one shot timer interrupts, in same apic mode on all cpus
+    ClockEvent::Initialize();
+
+    // timeouts, run from timer interrupt that scheduler arms
+    TimerWheel::Initialize();
+
+    // deferred freeing for lock free readers, grace periods need quiescent states
+    // which come from context switches, idle loop and interrupts
+    Rcu::Initialize();
+
+    // cpus share kernel page tables, unmapping on one must flush tlb of all
+    Tlb::Initialize();
+
+    // from here on this is init thread, timer uses apic in mode chosen above
+    Scheduler::Initialize();
+
+    // work that interrupt exits can't keep up with runs in a thread
+    SoftIRQ::InitializeCpu();
+
+    // other cpus are started in same apic mode
+    StartApplicationProcessors();
+
+    // look for a disk to swap to
+    SwapDevice::Initialize();
+
     RSDPDescriptor rsdp;
 
     SDTHeader* sdtHeader = reinterpret_cast<SDTHeader*>(rsdp.GetSDTAddress());
@@ -107,4 +179,17 @@ void KernelEntry() {
         }
         PutChar('\n');
     }
+
+#ifdef ENABLE_SCHED_BENCHMARK
+    Scheduler::Benchmark();
+#endif
+
+    // merge duplicate anonymous pages in background
+    SamePageMerging::Start();
+
+    // dirty some anonymous memory, swap it out and check it when it comes back
+    Scheduler::CreateThread("swaptest", Swap::SelfTest, nullptr);
+
+    // idle thread takes over, this stack is never reused so pmm and vmm above stay valid
+    Scheduler::Exit();
 }
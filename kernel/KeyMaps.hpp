@@ -0,0 +1,192 @@
+/**
+ *@file KeyMaps.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Keyboard layouts as compile time generated lookup tables
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef KEYMAPS_HPP
+#define KEYMAPS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "KeyCodes.hpp"
+
+// Keys are identified by a key index :
+// set 1 make code for normal keys, and 0x80 | make code for keys that come after 0xe0 prefix.
+// Set 2 scancodes are converted to set 1 before this (see Keyboard.cpp).
+#define KEY_EXTENDED 0x80
+#define KEYMAP_NUM_KEYS 256
+
+// modifier state is used as first index in keymap tables
+#define KEYMAP_MOD_SHIFT (1 << 0)
+#define KEYMAP_MOD_CAPSLOCK (1 << 1)
+#define KEYMAP_MOD_NUMLOCK (1 << 2)
+#define KEYMAP_NUM_MOD_STATES 8
+
+// one entry of layout description
+struct KeyMapSource {
+    uint8_t key;
+    char normal;
+    char shifted;
+};
+
+// ascii for each key in each modifier state, 0 if key doesn't print anything
+struct KeyMap {
+    char table[KEYMAP_NUM_MOD_STATES][KEYMAP_NUM_KEYS];
+};
+
+// keypad keys that print digits only when numlock is on
+constexpr bool IsNumlockKey(uint8_t key){
+    return (key >= KPD7_PRESSED && key <= KPDPOINT_PRESSED) &&
+        (key != KPDHYPHEN_PRESSED) && (key != KPDPLUS_PRESSED);
+}
+
+// generate tables for all modifier states from layout description
+// capslock affects only letters and numlock only keypad
+template<size_t N>
+constexpr KeyMap MakeKeyMap(const KeyMapSource (&keys)[N]){
+    KeyMap map = {};
+    for(size_t i = 0; i < N; i++){
+        const KeyMapSource& k = keys[i];
+        bool letter = (k.normal >= 'a') && (k.normal <= 'z');
+
+        for(size_t mod = 0; mod < KEYMAP_NUM_MOD_STATES; mod++){
+            bool shift = mod & KEYMAP_MOD_SHIFT;
+            if(letter && (mod & KEYMAP_MOD_CAPSLOCK)){
+                shift = !shift;
+            }
+
+            char c = shift ? k.shifted : k.normal;
+            if(IsNumlockKey(k.key) && !(mod & KEYMAP_MOD_NUMLOCK)){
+                c = 0;
+            }
+
+            map.table[mod][k.key] = c;
+        }
+    }
+
+    return map;
+}
+
+// keys that are same in all layouts
+#define KEYMAP_COMMON_KEYS \
+    {ENTER_PRESSED, '\n', '\n'}, {SPACE_PRESSED, ' ', ' '}, {BACKSPACE_PRESSED, '\b', '\b'}, \
+    {TAB_PRESSED, '\t', '\t'}, \
+    {KPD7_PRESSED, '7', '7'}, {KPD8_PRESSED, '8', '8'}, {KPD9_PRESSED, '9', '9'}, \
+    {KPD4_PRESSED, '4', '4'}, {KPD5_PRESSED, '5', '5'}, {KPD6_PRESSED, '6', '6'}, \
+    {KPD1_PRESSED, '1', '1'}, {KPD2_PRESSED, '2', '2'}, {KPD3_PRESSED, '3', '3'}, \
+    {KPD0_PRESSED, '0', '0'}, {KPDPOINT_PRESSED, '.', '.'}, \
+    {KPDPLUS_PRESSED, '+', '+'}, {KPDHYPHEN_PRESSED, '-', '-'}, {KPDSTAR_PRESSED, '*', '*'}, \
+    {KEY_EXTENDED | ENTER_PRESSED, '\n', '\n'}, {KEY_EXTENDED | FWDSLASH_PRESSED, '/', '/'}
+
+// us qwerty layout
+constexpr KeyMapSource QwertyKeyMapSource[] = {
+    KEYMAP_COMMON_KEYS,
+    {0x02, '1', '!'}, {0x03, '2', '@'}, {0x04, '3', '#'}, {0x05, '4', '$'}, {0x06, '5', '%'},
+    {0x07, '6', '^'}, {0x08, '7', '&'}, {0x09, '8', '*'}, {0x0a, '9', '('}, {0x0b, '0', ')'},
+    {HYPHEN_PRESSED, '-', '_'}, {EQUALTO_PRESSED, '=', '+'},
+    {Q_PRESSED, 'q', 'Q'}, {W_PRESSED, 'w', 'W'}, {E_PRESSED, 'e', 'E'}, {R_PRESSED, 'r', 'R'},
+    {T_PRESSED, 't', 'T'}, {Z_PRESSED, 'y', 'Y'}, {U_PRESSED, 'u', 'U'}, {I_PRESSED, 'i', 'I'},
+    {O_PRESSED, 'o', 'O'}, {P_PRESSED, 'p', 'P'},
+    {OPENSQBRACKET_PRESSED, '[', '{'}, {CLOSEDSQBRACKET_PRESSED, ']', '}'},
+    {A_PRESSED, 'a', 'A'}, {S_PRESSED, 's', 'S'}, {D_PRESSED, 'd', 'D'}, {F_PRESSED, 'f', 'F'},
+    {G_PRESSED, 'g', 'G'}, {H_PRESSED, 'h', 'H'}, {J_PRESSED, 'j', 'J'}, {K_PRESSED, 'k', 'K'},
+    {L_PRESSED, 'l', 'L'}, {SEMICOLON_PRESSED, ';', ':'}, {SINGLEQUOTE_PRESSED, '\'', '"'},
+    {BACKTICK_PRESSED, '`', '~'}, {BACKSLASH_PRESSED, '\\', '|'},
+    {Y_PRESSED, 'z', 'Z'}, {X_PRESSED, 'x', 'X'}, {C_PRESSED, 'c', 'C'}, {V_PRESSED, 'v', 'V'},
+    {B_PRESSED, 'b', 'B'}, {N_PRESSED, 'n', 'N'}, {M_PRESSED, 'm', 'M'},
+    {COMMA_PRESSED, ',', '<'}, {POINT_PRESSED, '.', '>'}, {FWDSLASH_PRESSED, '/', '?'}
+};
+
+// us dvorak layout
+constexpr KeyMapSource DvorakKeyMapSource[] = {
+    KEYMAP_COMMON_KEYS,
+    {0x02, '1', '!'}, {0x03, '2', '@'}, {0x04, '3', '#'}, {0x05, '4', '$'}, {0x06, '5', '%'},
+    {0x07, '6', '^'}, {0x08, '7', '&'}, {0x09, '8', '*'}, {0x0a, '9', '('}, {0x0b, '0', ')'},
+    {HYPHEN_PRESSED, '[', '{'}, {EQUALTO_PRESSED, ']', '}'},
+    {Q_PRESSED, '\'', '"'}, {W_PRESSED, ',', '<'}, {E_PRESSED, '.', '>'}, {R_PRESSED, 'p', 'P'},
+    {T_PRESSED, 'y', 'Y'}, {Z_PRESSED, 'f', 'F'}, {U_PRESSED, 'g', 'G'}, {I_PRESSED, 'c', 'C'},
+    {O_PRESSED, 'r', 'R'}, {P_PRESSED, 'l', 'L'},
+    {OPENSQBRACKET_PRESSED, '/', '?'}, {CLOSEDSQBRACKET_PRESSED, '=', '+'},
+    {A_PRESSED, 'a', 'A'}, {S_PRESSED, 'o', 'O'}, {D_PRESSED, 'e', 'E'}, {F_PRESSED, 'u', 'U'},
+    {G_PRESSED, 'i', 'I'}, {H_PRESSED, 'd', 'D'}, {J_PRESSED, 'h', 'H'}, {K_PRESSED, 't', 'T'},
+    {L_PRESSED, 'n', 'N'}, {SEMICOLON_PRESSED, 's', 'S'}, {SINGLEQUOTE_PRESSED, '-', '_'},
+    {BACKTICK_PRESSED, '`', '~'}, {BACKSLASH_PRESSED, '\\', '|'},
+    {Y_PRESSED, ';', ':'}, {X_PRESSED, 'q', 'Q'}, {C_PRESSED, 'j', 'J'}, {V_PRESSED, 'k', 'K'},
+    {B_PRESSED, 'x', 'X'}, {N_PRESSED, 'b', 'B'}, {M_PRESSED, 'm', 'M'},
+    {COMMA_PRESSED, 'w', 'W'}, {POINT_PRESSED, 'v', 'V'}, {FWDSLASH_PRESSED, 'z', 'Z'}
+};
+
+#undef KEYMAP_COMMON_KEYS
+
+// generated at compile time, these end up in rodata
+constexpr KeyMap QwertyKeyMap = MakeKeyMap(QwertyKeyMapSource);
+constexpr KeyMap DvorakKeyMap = MakeKeyMap(DvorakKeyMapSource);
+
+// Scancode set 2 make code to set 1 make code.
+// Extended keys use the same table, prefix is carried separately.
+// Codes not present here map to 0 and are ignored.
+struct ScancodeTable {
+    uint8_t table[KEYMAP_NUM_KEYS];
+};
+
+constexpr ScancodeTable MakeSet2ToSet1Table(){
+    constexpr uint8_t pairs[][2] = {
+        {0x01, 0x43}, {0x03, 0x3f}, {0x04, 0x3d}, {0x05, 0x3b}, {0x06, 0x3c}, {0x07, 0x58},
+        {0x09, 0x44}, {0x0a, 0x42}, {0x0b, 0x40}, {0x0c, 0x3e}, {0x0d, 0x0f}, {0x0e, 0x29},
+        {0x11, 0x38}, {0x12, 0x2a}, {0x14, 0x1d}, {0x15, 0x10}, {0x16, 0x02}, {0x1a, 0x2c},
+        {0x1b, 0x1f}, {0x1c, 0x1e}, {0x1d, 0x11}, {0x1e, 0x03}, {0x21, 0x2e}, {0x22, 0x2d},
+        {0x23, 0x20}, {0x24, 0x12}, {0x25, 0x05}, {0x26, 0x04}, {0x29, 0x39}, {0x2a, 0x2f},
+        {0x2b, 0x21}, {0x2c, 0x14}, {0x2d, 0x13}, {0x2e, 0x06}, {0x31, 0x31}, {0x32, 0x30},
+        {0x33, 0x23}, {0x34, 0x22}, {0x35, 0x15}, {0x36, 0x07}, {0x3a, 0x32}, {0x3b, 0x24},
+        {0x3c, 0x16}, {0x3d, 0x08}, {0x3e, 0x09}, {0x41, 0x33}, {0x42, 0x25}, {0x43, 0x17},
+        {0x44, 0x18}, {0x45, 0x0b}, {0x46, 0x0a}, {0x49, 0x34}, {0x4a, 0x35}, {0x4b, 0x26},
+        {0x4c, 0x27}, {0x4d, 0x19}, {0x4e, 0x0c}, {0x52, 0x28}, {0x54, 0x1a}, {0x55, 0x0d},
+        {0x58, 0x3a}, {0x59, 0x36}, {0x5a, 0x1c}, {0x5b, 0x1b}, {0x5d, 0x2b}, {0x66, 0x0e},
+        {0x69, 0x4f}, {0x6b, 0x4b}, {0x6c, 0x47}, {0x70, 0x52}, {0x71, 0x53}, {0x72, 0x50},
+        {0x73, 0x4c}, {0x74, 0x4d}, {0x75, 0x48}, {0x76, 0x01}, {0x77, 0x45}, {0x78, 0x57},
+        {0x79, 0x4e}, {0x7a, 0x51}, {0x7b, 0x4a}, {0x7c, 0x37}, {0x7d, 0x49}, {0x7e, 0x46},
+        {0x83, 0x41}
+    };
+
+    ScancodeTable t = {};
+    for(size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++){
+        t.table[pairs[i][0]] = pairs[i][1];
+    }
+
+    return t;
+}
+
+constexpr ScancodeTable Set2ToSet1 = MakeSet2ToSet1Table();
+
+#endif // KEYMAPS_HPP
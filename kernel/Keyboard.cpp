@@ -37,148 +37,320 @@
 #include "Keyboard.hpp"
 #include "Puts.hpp"
 #include "KeyCodes.hpp"
-#include "Utils/String.hpp"
-
-enum class KeyState : uint8_t{
-    Pressed, Released
+#include "KeyMaps.hpp"
+#include "IO.hpp"
+#include "Printf.hpp"
+#include "SoftIRQ.hpp"
+#include "Utils/RingBuffer.hpp"
+#include "CPU.hpp"
+
+// ps2 controller ports
+#define PS2_DATA_PORT 0x60
+#define PS2_STATUS_PORT 0x64
+#define PS2_COMMAND_PORT 0x64
+#define PS2_STATUS_OUTPUT_FULL (1 << 0)
+#define PS2_STATUS_INPUT_FULL (1 << 1)
+#define PS2_STATUS_AUX_DATA (1 << 5) // byte in output buffer is from mouse
+#define PS2_COMMAND_READ_CONFIG 0x20
+// controller translates set 2 to set 1 when this is set in config byte
+#define PS2_CONFIG_TRANSLATION (1 << 6)
+// max polls before giving up on controller
+#define PS2_TIMEOUT 100000
+
+// scancode prefixes
+#define SCANCODE_EXTENDED 0xe0
+#define SCANCODE_PAUSE 0xe1
+#define SCANCODE_SET2_BREAK 0xf0
+// pause key sends a fixed sequence after 0xe1 and has no break code
+#define SCANCODE_SET1_PAUSE_LENGTH 5
+#define SCANCODE_SET2_PAUSE_LENGTH 7
+
+// layout in use, switching layout is just a pointer swap
+static const KeyMap* currentKeyMap = &QwertyKeyMap;
+static uint8_t scancodeSet = 1;
+
+// modifier state
+static bool lshift = false;
+static bool rshift = false;
+static bool lctrl = false;
+static bool rctrl = false;
+static bool capslock = false;
+static bool numlock = false;
+
+// registered hotkeys
+struct KeyboardHotkey {
+    uint8_t key;
+    KeyboardHotkeyHandler handler;
 };
-
-// if caps is on then case will be changed
-char ChangeCase(char c, bool caps){
-    if(caps){
-        if(isupper(c)) return tolower(c);
-        if(islower(c)) return toupper(c);
+static KeyboardHotkey hotkeys[KEYBOARD_MAX_HOTKEYS];
+static size_t numHotkeys = 0;
+
+// decoder state for multi byte scancodes
+static bool extendedPrefix = false;
+static bool breakPrefix = false;
+static uint8_t pauseBytesLeft = 0;
+
+// feed one byte of scancode to decoder
+// returns true when a complete key has been decoded
+static bool DecodeScancode(uint8_t byte, uint8_t& key, bool& released){
+    if(pauseBytesLeft){
+        pauseBytesLeft--;
+        return false;
     }
 
-    return c;
-}
-
-static const char* _qwertzuiop = "qwertyuiop"; // 0x10-0x1c
-static const char* _asdfghjkl = "asdfghjkl";
-static const char* _yxcvbnm = "zxcvbnm";
-static const char* _num = "1234567890";
-static const char* _shiftnum = "!@#$%^&*()";
-
-char KeyboardToASCII(uint8_t key){
-    static bool caps = false;
-    static bool capslock = false;
-    static bool numlock = false;
-    static KeyState lshift = KeyState::Released;
-    static KeyState rshift = KeyState::Released;
-    static KeyState lctrl = KeyState::Released;
-    static KeyState rctrl = KeyState::Released;
-
-    if(key == CAPSLOCK_RELEASED){
-        capslock = !capslock;
-    }else if(key == LSHIFT_PRESSED){
-        lshift = KeyState::Pressed;
-    }else if(key == LSHIFT_RELEASED){
-        lshift = KeyState::Released;
-    }else if(key == RSHIFT_PRESSED){
-        rshift = KeyState::Pressed;
-    }else if(key == RSHIFT_RELEASED){
-        rshift = KeyState::Released;
-    }else if(key == NUMLOCK_RELEASED){
-        numlock = !numlock;
+    if(byte == SCANCODE_EXTENDED){
+        extendedPrefix = true;
+        return false;
     }
 
-    if(lshift == KeyState::Pressed || rshift == KeyState::Pressed){
-        if(capslock) caps = false;
-        else caps = true;
-    }else if(lshift == KeyState::Released || rshift == KeyState::Released){
-        caps = capslock;
+    if(byte == SCANCODE_PAUSE){
+        pauseBytesLeft = scancodeSet == 1 ? SCANCODE_SET1_PAUSE_LENGTH : SCANCODE_SET2_PAUSE_LENGTH;
+        return false;
     }
 
-    // alphabets
-    if(key >= Q_PRESSED && key <= P_PRESSED){
-        return ChangeCase(_qwertzuiop[key - Q_PRESSED], caps);
-    } else if(key >= A_PRESSED && key <= L_PRESSED) {
-        return ChangeCase(_asdfghjkl[key - A_PRESSED], caps);
-    } else if(key >= Y_PRESSED && key <= M_PRESSED) {
-        return ChangeCase(_yxcvbnm[key - Y_PRESSED], caps);
+    uint8_t make;
+    if(scancodeSet == 1){
+        released = byte & 0x80;
+        make = byte & 0x7f;
+    }else{
+        if(byte == SCANCODE_SET2_BREAK){
+            breakPrefix = true;
+            return false;
+        }
+
+        released = breakPrefix;
+        make = Set2ToSet1.table[byte];
     }
 
-    // numbers
-    if(key >= ONE_PRESSED && key <= ZERO_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? _shiftnum[key - ONE_PRESSED] : _num[key - ONE_PRESSED];
-    }
+    key = make | (extendedPrefix ? KEY_EXTENDED : 0);
+    extendedPrefix = false;
+    breakPrefix = false;
 
-    // special keys
-    if(key == ENTER_PRESSED) return '\n';
-    if(key == SPACE_PRESSED) return ' ';
-    if(key == BACKSPACE_PRESSED) return '\b';
-    if(key == TAB_PRESSED) return '\t';
+    // unknown key
+    return make != 0;
+}
 
-    if(numlock){
-        if(key == KPD1_PRESSED) return '1';
-        if(key == KPD2_PRESSED) return '2';
-        if(key == KPD3_PRESSED) return '3';
-        if(key == KPD4_PRESSED) return '4';
-        if(key == KPD5_PRESSED) return '5';
-        if(key == KPD6_PRESSED) return '6';
-        if(key == KPD7_PRESSED) return '7';
-        if(key == KPD8_PRESSED) return '8';
-        if(key == KPD9_PRESSED) return '9';
-        if(key == KPD0_PRESSED) return '0';
+// keep track of modifier keys
+static void UpdateModifiers(uint8_t key, bool released){
+    switch(key){
+        case LSHIFT_PRESSED : lshift = !released; break;
+        case RSHIFT_PRESSED : rshift = !released; break;
+        case LCTRL_PRESSED : lctrl = !released; break;
+        case KEY_EXTENDED | LCTRL_PRESSED : rctrl = !released; break;
+        case CAPSLOCK_PRESSED : if(!released) capslock = !capslock; break;
+        case NUMLOCK_PRESSED : if(!released) numlock = !numlock; break;
+        default : break;
     }
+}
 
-    if(key == KPDPLUS_PRESSED) return '+';
-    if(key == KPDHYPHEN_PRESSED) return '-';
-    if(key == KPDSTAR_PRESSED) return '*';
-    if(key == KPDPOINT_PRESSED) return '.';
+// first index in keymap table
+static uint8_t GetModifierIndex(){
+    uint8_t mod = 0;
+    if(lshift || rshift) mod |= KEYMAP_MOD_SHIFT;
+    if(capslock) mod |= KEYMAP_MOD_CAPSLOCK;
+    if(numlock) mod |= KEYMAP_MOD_NUMLOCK;
+    return mod;
+}
 
-    if(key == EQUALTO_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '+' : '=';
+// wait for controller to have a byte for us
+static bool WaitForControllerOutput(){
+    for(uint64_t i = 0; i < PS2_TIMEOUT; i++){
+        if(PortReadByte(PS2_STATUS_PORT) & PS2_STATUS_OUTPUT_FULL) return true;
     }
+    return false;
+}
 
-    if(key == SINGLEQUOTE_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '"' : '\'';
+// wait for controller to accept a byte from us
+static bool WaitForControllerInput(){
+    for(uint64_t i = 0; i < PS2_TIMEOUT; i++){
+        if(!(PortReadByte(PS2_STATUS_PORT) & PS2_STATUS_INPUT_FULL)) return true;
     }
+    return false;
+}
 
-    if(key == POINT_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '>' : '.';
+// Controller usually translates set 2 to set 1 for compatibility,
+// if translation is off then keyboard's set 2 codes reach us as they are.
+// Must be called with interrupts disabled, otherwise irq handler eats the reply.
+static void DetectScancodeSet(){
+    // drop stale bytes
+    while(PortReadByte(PS2_STATUS_PORT) & PS2_STATUS_OUTPUT_FULL){
+        PortReadByte(PS2_DATA_PORT);
     }
 
-    if(key == COMMA_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '<' : ',';
+    if(!WaitForControllerInput()) return;
+    PortWriteByte(PS2_COMMAND_PORT, PS2_COMMAND_READ_CONFIG);
+    if(!WaitForControllerOutput()){
+        Printf("[!] PS2 controller didn't respond, assuming scancode set 1\n");
+        return;
     }
 
-    if(key == SEMICOLON_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? ':' : ';';
+    uint8_t config = PortReadByte(PS2_DATA_PORT);
+    scancodeSet = (config & PS2_CONFIG_TRANSLATION) ? 1 : 2;
+}
+
+// layout switch
+void SetKeyboardLayout(KeyboardLayout layout){
+    switch(layout){
+        case KeyboardLayout::Dvorak : currentKeyMap = &DvorakKeyMap; break;
+        default : currentKeyMap = &QwertyKeyMap; break;
     }
+}
 
-    if(key == COMMA_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '<' : ',';
+// scancode set override
+void SetScancodeSet(uint8_t set){
+    if(set == 1 || set == 2){
+        scancodeSet = set;
+        extendedPrefix = false;
+        breakPrefix = false;
+        pauseBytesLeft = 0;
     }
+}
+
+uint8_t GetScancodeSet(){
+    return scancodeSet;
+}
 
-    if(key == OPENSQBRACKET_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '{' : '[';
+// hotkey registration
+bool RegisterKeyboardHotkey(uint8_t key, KeyboardHotkeyHandler handler){
+    if(numHotkeys == KEYBOARD_MAX_HOTKEYS){
+        Printf("[-] No space left to register hotkey 0x%x\n", key);
+        return false;
     }
 
-    if(key == CLOSEDSQBRACKET_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '}' : ']';
+    hotkeys[numHotkeys].key = key;
+    hotkeys[numHotkeys].handler = handler;
+    numHotkeys++;
+    return true;
+}
+
+// run hotkey if there's one for this key
+static bool RunHotkey(uint8_t key){
+    for(size_t i = 0; i < numHotkeys; i++){
+        if(hotkeys[i].key == key){
+            hotkeys[i].handler();
+            return true;
+        }
     }
 
-    if(key == BACKSLASH_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '|' : '\\';
+    return false;
+}
+
+// modifier ctrl state
+bool IsControlPressed(){
+    return lctrl || rctrl;
+}
+
+void HandleKeyboardEvent(uint8_t scancode){
+    KeyEvent event;
+    event.scancode = scancode;
+    event.timestamp = 0;
+
+    char c = TranslateKeyEvent(event);
+    if(c) PutChar(c);
+}
+
+// events from interrupt handler to consumer
+static RingBuffer<KeyEvent, KEYBOARD_RING_SIZE> keyEventRing;
+static uint64_t keyEventOverflows = 0;
+static bool keyboardEcho = true;
+
+// called from keyboard poller
+void QueueKeyEvent(uint8_t scancode){
+    KeyEvent event;
+    event.scancode = scancode;
+    event.timestamp = ReadTSC();
+
+    if(!keyEventRing.Push(event)){
+        keyEventOverflows++;
     }
 
-    if(key == HYPHEN_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '_' : '-';
+    // wake up consumer
+    if(keyboardEcho){
+        SoftIRQ::Raise(SOFTIRQ_KEYBOARD);
     }
+}
 
-    if(key == FWDSLASH_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '?' : '/';
+// drain controller
+size_t ReadKeyboardController(size_t budget){
+    size_t n = 0;
+    while(n < budget){
+        uint8_t status = PortReadByte(PS2_STATUS_PORT);
+        if(!(status & PS2_STATUS_OUTPUT_FULL) || (status & PS2_STATUS_AUX_DATA)){
+            break;
+        }
+
+        QueueKeyEvent(PortReadByte(PS2_DATA_PORT));
+        n++;
     }
 
-    if(key == BACKTICK_PRESSED){
-        return (lshift == KeyState::Pressed || rshift == KeyState::Pressed) ? '~' : '`';
+    return n;
+}
+
+// non blocking read
+bool ReadKeyEvent(KeyEvent& event){
+    return keyEventRing.Pop(event);
+}
+
+// blocking read, interrupt flag is left as caller had it
+KeyEvent WaitForKeyEvent(){
+    KeyEvent event;
+    while(true){
+        // interrupts are disabled between the check and hlt so that
+        // an event arriving in between doesn't get missed
+        uint64_t rflags = SaveAndDisableInterrupts();
+        if(keyEventRing.Pop(event)){
+            RestoreInterrupts(rflags);
+            return event;
+        }
+
+        // hlt with interrupts disabled would never wake up, just spin then
+        if(rflags & RFLAGS_INTERRUPT_ENABLE){
+            asm volatile("sti; hlt");
+        }else{
+            asm volatile("pause");
+        }
     }
+}
+
+// translation stage
+// single table lookup once key is decoded
+char TranslateKeyEvent(const KeyEvent& event){
+    uint8_t key;
+    bool released;
+    if(!DecodeScancode(event.scancode, key, released)) return 0;
 
-    return 0;
+    UpdateModifiers(key, released);
+    if(released) return 0;
+
+    if(RunHotkey(key)) return 0;
+
+    return currentKeyMap->table[GetModifierIndex()][key];
+}
+
+// echo on/off
+void SetKeyboardEcho(bool enable){
+    keyboardEcho = enable;
+}
+
+// dropped events
+uint64_t GetKeyboardOverflowCount(){
+    return keyEventOverflows;
 }
 
-void INTERRUPT_CALLEE_API HandleKeyboardEvent(uint8_t scancode){
-    if(scancode == 0) return;
-    PutChar(KeyboardToASCII(scancode));
+// runs in softirq with interrupts enabled
+static void ProcessKeyEvents(void* context){
+    (void)context;
+
+    KeyEvent event;
+    while(keyboardEcho && keyEventRing.Pop(event)){
+        HandleKeyboardEvent(event.scancode);
+    }
+}
+
+// register softirq
+void InitializeKeyboard(){
+    DetectScancodeSet();
+    Printf("[+] Keyboard using scancode set %u\n", scancodeSet);
+
+    SoftIRQ::Register(SOFTIRQ_KEYBOARD, ProcessKeyEvents, nullptr);
 }
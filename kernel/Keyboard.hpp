@@ -39,8 +39,76 @@
 
 #include "Common.hpp"
 #include <cstdint>
+#include <cstddef>
 
-// handle keyboard event
-void INTERRUPT_CALLEE_API HandleKeyboardEvent(uint8_t scancode);
+// max key events waiting to be read, must be a power of 2
+#define KEYBOARD_RING_SIZE 256
+
+// max number of hotkeys registered at once
+#define KEYBOARD_MAX_HOTKEYS 16
+
+// a scancode along with time at which it was received
+struct KeyEvent {
+    uint8_t scancode;
+    uint64_t timestamp; // tsc value in interrupt handler
+};
+
+// layouts that can be switched at runtime
+enum class KeyboardLayout : uint8_t {
+    Qwerty, Dvorak
+};
+
+// handle keyboard event (translate and print)
+void HandleKeyboardEvent(uint8_t scancode);
+
+// detect scancode set and setup deferred processing of keyboard events
+// must be called with interrupts disabled
+void InitializeKeyboard();
+
+// Keyboard poller (see IrqPoll.hpp) is the only producer of key events and whoever
+// reads them is the only consumer. By default the keyboard softirq is the consumer and
+// echoes keys on screen, disable echo before reading events from elsewhere.
+
+// add event to ring, called only by keyboard poller
+// event is dropped and counted if ring is full
+void QueueKeyEvent(uint8_t scancode);
+
+// move at most budget pending scancodes from ps2 controller to ring
+// returns number of scancodes read
+size_t ReadKeyboardController(size_t budget);
+
+// get next key event without waiting, returns false if there's none
+bool ReadKeyEvent(KeyEvent& event);
+
+// wait until a key event is available and return it
+KeyEvent WaitForKeyEvent();
+
+// translate key event to ascii, returns 0 for keys that don't print anything
+// this keeps track of modifier keys, so events must be translated in order
+char TranslateKeyEvent(const KeyEvent& event);
+
+// change layout used for translation, takes effect from next key
+void SetKeyboardLayout(KeyboardLayout layout);
+
+// scancode set is detected from ps2 controller at init (1 or 2)
+// can be overridden if detection is wrong
+void SetScancodeSet(uint8_t set);
+uint8_t GetScancodeSet();
+
+// called when hotkey is pressed, from whoever is translating key events
+typedef void (*KeyboardHotkeyHandler)();
+
+// run handler when key is pressed, key is a key index (see KeyMaps.hpp)
+// hotkeys are consumed and don't produce any character
+bool RegisterKeyboardHotkey(uint8_t key, KeyboardHotkeyHandler handler);
+
+// check if any ctrl key is held down
+bool IsControlPressed();
+
+// turn on/off echoing key events on screen
+void SetKeyboardEcho(bool enable);
+
+// number of events dropped because ring was full
+uint64_t GetKeyboardOverflowCount();
 
 #endif // KEYBOARD_HPP
@@ -0,0 +1,103 @@
+/**
+ *@file LockStats.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Per lock contention statistics for lock debug builds
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "LockStats.hpp"
+#include "Clock.hpp"
+#include "Printf.hpp"
+
+#ifdef ENABLE_LOCK_DEBUG
+// locks in order of their first acquisition, never removed
+static LockStats* registeredLocks[LOCK_STATS_MAX_LOCKS] = {};
+static size_t numRegisteredLocks = 0;
+
+// locks that don't fit are still counted, just not listed
+void LockStats::Register(LockStats* stats){
+    size_t index = __atomic_fetch_add(&numRegisteredLocks, 1, __ATOMIC_RELAXED);
+    if(index < LOCK_STATS_MAX_LOCKS){
+        __atomic_store_n(&registeredLocks[index], stats, __ATOMIC_RELEASE);
+    }
+}
+
+// only non empty buckets, each shown by it's upper bound
+static void ShowHistogram(const char* title, const uint64_t* histogram){
+    Printf("%s", title);
+    for(size_t bucket = 0; bucket < LOCK_STATS_BUCKETS; bucket++){
+        if(histogram[bucket] == 0){
+            continue;
+        }
+
+        if(bucket == LOCK_STATS_BUCKETS - 1){
+            Printf(" more:%lu", histogram[bucket]);
+        }else{
+            Printf(" <%luns:%lu", Clock::CyclesToNs(uint64_t(1) << (2 * (bucket + 1))), histogram[bucket]);
+        }
+    }
+    Printf("\n");
+}
+
+// counters are read without taking locks, a busy lock may show slightly torn numbers
+void ShowLockStatistics(){
+    Printf("[+] Lock Statistics :\n");
+
+    size_t count = __atomic_load_n(&numRegisteredLocks, __ATOMIC_ACQUIRE);
+    if(count > LOCK_STATS_MAX_LOCKS){
+        Printf("[!] %lu locks are not listed\n", count - LOCK_STATS_MAX_LOCKS);
+        count = LOCK_STATS_MAX_LOCKS;
+    }
+
+    for(size_t i = 0; i < count; i++){
+        const LockStats* stats = __atomic_load_n(&registeredLocks[i], __ATOMIC_ACQUIRE);
+        if(stats == nullptr){
+            continue;
+        }
+
+        uint64_t acquisitions = stats->acquisitions ? stats->acquisitions : 1;
+        uint64_t contentions = stats->contentions ? stats->contentions : 1;
+
+        Printf("\t%s (%lx) : %lu acquisitions, %lu contended\n", stats->name ? stats->name : "unnamed",
+               reinterpret_cast<uint64_t>(stats), stats->acquisitions, stats->contentions);
+        Printf("\t\twait avg %lu ns max %lu ns, hold avg %lu ns max %lu ns\n",
+               Clock::CyclesToNs(stats->totalWaitCycles / contentions), Clock::CyclesToNs(stats->maxWaitCycles),
+               Clock::CyclesToNs(stats->totalHoldCycles / acquisitions), Clock::CyclesToNs(stats->maxHoldCycles));
+        ShowHistogram("\t\twait :", stats->waitHistogram);
+        ShowHistogram("\t\thold :", stats->holdHistogram);
+    }
+}
+#else
+void ShowLockStatistics(){
+    Printf("[!] Lock statistics need a kernel built with ENABLE_LOCK_DEBUG\n");
+}
+#endif // ENABLE_LOCK_DEBUG
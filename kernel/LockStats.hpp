@@ -0,0 +1,110 @@
+/**
+ *@file LockStats.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Per lock contention statistics for lock debug builds
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LOCKSTATS_HPP
+#define LOCKSTATS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "CPU.hpp"
+
+// max number of locks whose statistics can be listed
+#define LOCK_STATS_MAX_LOCKS 128
+// histogram bucket n counts times in [4^n, 4^(n+1)) cycles, last one everything above
+#define LOCK_STATS_BUCKETS 16
+
+#ifdef ENABLE_LOCK_DEBUG
+// Embedded in every lock in lock debug builds. All fields are only written
+// by the lock holder, so updating them needs no atomics.
+// A lock is added to global list on it's first acquisition.
+struct LockStats {
+    const char* name; // nullptr if lock wasn't named
+    bool registered;
+    uint64_t acquiredAt; // tsc when current holder got the lock
+    uint64_t acquisitions;
+    uint64_t contentions; // acquisitions that had to wait
+    uint64_t totalWaitCycles;
+    uint64_t maxWaitCycles;
+    uint64_t totalHoldCycles;
+    uint64_t maxHoldCycles;
+    uint64_t waitHistogram[LOCK_STATS_BUCKETS];
+    uint64_t holdHistogram[LOCK_STATS_BUCKETS];
+
+    // call right after lock is taken, start is tsc from before first attempt
+    void Acquired(uint64_t start, bool contended){
+        acquiredAt = ReadTSC();
+        acquisitions++;
+        if(contended){
+            uint64_t wait = acquiredAt - start;
+            contentions++;
+            totalWaitCycles += wait;
+            if(wait > maxWaitCycles){
+                maxWaitCycles = wait;
+            }
+            waitHistogram[GetBucket(wait)]++;
+        }
+
+        if(!registered){
+            registered = true;
+            Register(this);
+        }
+    }
+
+    // call right before lock is released
+    void Released(){
+        uint64_t hold = ReadTSC() - acquiredAt;
+        totalHoldCycles += hold;
+        if(hold > maxHoldCycles){
+            maxHoldCycles = hold;
+        }
+        holdHistogram[GetBucket(hold)]++;
+    }
+
+    static size_t GetBucket(uint64_t cycles){
+        size_t bucket = (cycles == 0) ? 0 : size_t(63 - __builtin_clzll(cycles)) / 2;
+        return (bucket < LOCK_STATS_BUCKETS) ? bucket : (LOCK_STATS_BUCKETS - 1);
+    }
+
+    // add to global list
+    static void Register(LockStats* stats);
+};
+#endif // ENABLE_LOCK_DEBUG
+
+// list all locks taken so far with their counters and histograms
+// only prints a note when kernel is built without ENABLE_LOCK_DEBUG
+void ShowLockStatistics();
+
+#endif // LOCKSTATS_HPP
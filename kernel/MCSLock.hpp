@@ -0,0 +1,139 @@
+/**
+ *@file MCSLock.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Queue based spin lock for heavily contended data
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MCSLOCK_HPP
+#define MCSLOCK_HPP
+
+#include <cstdint>
+#include "CPU.hpp"
+#include "LockStats.hpp"
+
+// one for every cpu waiting on or holding an MCSLock, usually on caller's stack
+// must stay alive and untouched from Lock till Unlock
+struct MCSNode {
+    MCSNode* next; // waiter behind us
+    bool waiting; // cleared by previous holder when it hands lock over
+};
+
+// Mellor-Crummey Scott lock. Waiters form a queue of their own nodes and each
+// spins on it's own node, so a release touches only the next waiter's cache line
+// instead of all of them. Fair like TicketLock and scales with number of cpus,
+// but costs an extra atomic on release and callers have to pass a node around.
+// Zero initialized lock is unlocked.
+struct MCSLock {
+    MCSNode* tail; // last node in queue, nullptr if lock is free
+#ifdef ENABLE_LOCK_DEBUG
+    LockStats stats;
+#endif
+
+    void Lock(MCSNode* node){
+#ifdef ENABLE_LOCK_DEBUG
+        uint64_t start = ReadTSC();
+#endif
+        node->next = nullptr;
+        node->waiting = true;
+
+        MCSNode* previous = __atomic_exchange_n(&tail, node, __ATOMIC_ACQ_REL);
+        if(previous != nullptr){
+            __atomic_store_n(&previous->next, node, __ATOMIC_RELEASE);
+            while(__atomic_load_n(&node->waiting, __ATOMIC_ACQUIRE)){
+                asm volatile("pause");
+            }
+        }
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Acquired(start, previous != nullptr);
+#endif
+    }
+
+    // taken only if queue is empty, returns true if lock was taken
+    bool TryLock(MCSNode* node){
+        node->next = nullptr;
+        node->waiting = false;
+
+        MCSNode* expected = nullptr;
+        if(!__atomic_compare_exchange_n(&tail, &expected, node, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+            return false;
+        }
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Acquired(ReadTSC(), false);
+#endif
+        return true;
+    }
+
+    // hand lock to next waiter, or free it if there's none
+    void Unlock(MCSNode* node){
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Released();
+#endif
+        MCSNode* next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+        if(next == nullptr){
+            MCSNode* expected = node;
+            if(__atomic_compare_exchange_n(&tail, &expected, nullptr, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)){
+                return;
+            }
+
+            // someone queued up but hasn't linked itself to us yet
+            while((next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) == nullptr){
+                asm volatile("pause");
+            }
+        }
+
+        __atomic_store_n(&next->waiting, false, __ATOMIC_RELEASE);
+    }
+
+    // disable interrupts on this cpu before locking, returns rflags to restore
+    uint64_t LockIrqSave(MCSNode* node){
+        uint64_t rflags = SaveAndDisableInterrupts();
+        Lock(node);
+        return rflags;
+    }
+
+    void UnlockIrqRestore(MCSNode* node, uint64_t rflags){
+        Unlock(node);
+        RestoreInterrupts(rflags);
+    }
+
+    // name shown in lock statistics, does nothing without ENABLE_LOCK_DEBUG
+    void SetName(const char* name){
+#ifdef ENABLE_LOCK_DEBUG
+        stats.name = name;
+#else
+        (void)name;
+#endif
+    }
+};
+
+#endif // MCSLOCK_HPP
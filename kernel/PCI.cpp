@@ -0,0 +1,369 @@
+/**
+ *@file PCI.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief PCI configuration space access and device enumeration
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "PCI.hpp"
+#include "IO.hpp"
+#include "Printf.hpp"
+#include "VirtualMemoryManager.hpp"
+
+// create address of a register in configuration space
+static inline uint32_t ConfigAddress(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset){
+    // bit 31 is enable bit, registers are always dword aligned
+    return (uint32_t(1) << 31) | (uint32_t(bus) << 16) | (uint32_t(slot) << 11) |
+        (uint32_t(function) << 8) | (offset & 0xfc);
+}
+
+// read register
+uint32_t PCIDevice::ReadConfigDword(uint8_t offset){
+    PortWriteDword(PCI_CONFIG_ADDRESS, ConfigAddress(bus, slot, function, offset));
+    return PortReadDword(PCI_CONFIG_DATA);
+}
+
+// read word from register
+uint16_t PCIDevice::ReadConfigWord(uint8_t offset){
+    return uint16_t(ReadConfigDword(offset) >> ((offset & 2) * 8));
+}
+
+// read byte from register
+uint8_t PCIDevice::ReadConfigByte(uint8_t offset){
+    return uint8_t(ReadConfigDword(offset) >> ((offset & 3) * 8));
+}
+
+// write register
+void PCIDevice::WriteConfigDword(uint8_t offset, uint32_t value){
+    PortWriteDword(PCI_CONFIG_ADDRESS, ConfigAddress(bus, slot, function, offset));
+    PortWriteDword(PCI_CONFIG_DATA, value);
+}
+
+// write word into register without touching the other half
+void PCIDevice::WriteConfigWord(uint8_t offset, uint16_t value){
+    uint32_t shift = (offset & 2) * 8;
+    uint32_t dword = ReadConfigDword(offset);
+    dword &= ~(uint32_t(0xffff) << shift);
+    dword |= uint32_t(value) << shift;
+    WriteConfigDword(offset, dword);
+}
+
+// check bar type
+bool PCIDevice::IsIOBAR(uint8_t idx){
+    return ReadConfigDword(PCI_BAR0 + idx * 4) & 1;
+}
+
+// get base address
+uint64_t PCIDevice::GetBAR(uint8_t idx){
+    uint32_t bar = ReadConfigDword(PCI_BAR0 + idx * 4);
+
+    // I/O space bar
+    if(bar & 1){
+        return bar & ~uint32_t(0x3);
+    }
+
+    // 64 bit memory bar uses next bar for higher 32 bits
+    uint64_t address = bar & ~uint32_t(0xf);
+    if(((bar >> 1) & 0x3) == 0x2){
+        address |= uint64_t(ReadConfigDword(PCI_BAR0 + (idx + 1) * 4)) << 32;
+    }
+
+    return address;
+}
+
+// enable command bits
+void PCIDevice::EnableCommand(uint16_t bits){
+    WriteConfigWord(PCI_COMMAND, ReadConfigWord(PCI_COMMAND) | bits);
+}
+
+// walk capability list
+uint8_t PCIDevice::FindCapability(uint8_t id){
+    if(!(ReadConfigWord(PCI_STATUS) & PCI_STATUS_CAPABILITIES_LIST)){
+        return 0;
+    }
+
+    // lower 2 bits are reserved, limit walk in case list is broken
+    uint8_t offset = ReadConfigByte(PCI_CAPABILITIES_POINTER) & 0xfc;
+    for(size_t i = 0; (offset != 0) && (i < 48); i++){
+        if(ReadConfigByte(offset) == id){
+            return offset;
+        }
+        offset = ReadConfigByte(offset + 1) & 0xfc;
+    }
+
+    return 0;
+}
+
+// check if message can be delivered to this cpu without remapping
+static bool CheckMSIDestination(uint32_t apicID){
+    if(apicID > MSI_MAX_DEST_APIC_ID){
+        Printf("[-] Local APIC %u can't be targeted by MSI without interrupt remapping\n", apicID);
+        return false;
+    }
+
+    return true;
+}
+
+// msi vectors supported
+uint8_t PCIDevice::GetMSIVectorCount(){
+    uint8_t cap = FindCapability(PCI_CAP_ID_MSI);
+    if(cap == 0){
+        return 0;
+    }
+
+    uint16_t control = ReadConfigWord(cap + PCI_MSI_CONTROL);
+    return uint8_t(1) << ((control >> PCI_MSI_CONTROL_MMC_SHIFT) & 0x7);
+}
+
+// program msi capability
+int PCIDevice::EnableMSI(uint8_t count, uint32_t apicID, IrqHandler handler, void* context){
+    uint8_t cap = FindCapability(PCI_CAP_ID_MSI);
+    if((cap == 0) || (count == 0) || !CheckMSIDestination(apicID)){
+        return -1;
+    }
+
+    // device gets 2^n vectors and changes lower n bits of data for each interrupt
+    uint8_t maxCount = GetMSIVectorCount();
+    uint8_t log2Count = 0;
+    while((uint8_t(1) << log2Count) < count){
+        log2Count++;
+    }
+    if((uint8_t(1) << log2Count) > maxCount){
+        Printf("[-] Device supports only %u MSI vectors\n", maxCount);
+        return -1;
+    }
+    count = uint8_t(1) << log2Count;
+
+    int vector = AllocateIrqVectors(count, count);
+    if(vector < 0){
+        return -1;
+    }
+
+    // device must not be pointed at a vector nobody handles
+    for(uint8_t i = 0; i < count; i++){
+        if(!RegisterIrqHandler(uint8_t(vector + i), handler, context)){
+            Printf("[-] Failed to register handler for MSI vector 0x%x\n", vector + i);
+            while(i-- > 0){
+                UnregisterIrqHandler(uint8_t(vector + i), handler, context);
+            }
+            FreeIrqVectors(uint8_t(vector), count);
+            return -1;
+        }
+    }
+
+    uint16_t control = ReadConfigWord(cap + PCI_MSI_CONTROL);
+    uint32_t address = MSI_ADDRESS_BASE | (apicID << MSI_ADDRESS_DEST_SHIFT);
+    WriteConfigDword(cap + PCI_MSI_ADDRESS_LOW, address);
+    if(control & PCI_MSI_CONTROL_64BIT){
+        WriteConfigDword(cap + PCI_MSI_ADDRESS_HIGH, 0);
+        WriteConfigWord(cap + PCI_MSI_DATA_64, uint16_t(vector));
+    }else{
+        WriteConfigWord(cap + PCI_MSI_DATA_32, uint16_t(vector));
+    }
+
+    control &= ~uint16_t(0x7 << PCI_MSI_CONTROL_MME_SHIFT);
+    control |= uint16_t(log2Count << PCI_MSI_CONTROL_MME_SHIFT) | PCI_MSI_CONTROL_ENABLE;
+    WriteConfigWord(cap + PCI_MSI_CONTROL, control);
+
+    // no more pin based interrupts
+    EnableCommand(PCI_COMMAND_INTERRUPT_DISABLE);
+
+    return vector;
+}
+
+// msi-x table size
+uint16_t PCIDevice::GetMSIXVectorCount(){
+    uint8_t cap = FindCapability(PCI_CAP_ID_MSIX);
+    if(cap == 0){
+        return 0;
+    }
+
+    return (ReadConfigWord(cap + PCI_MSIX_CONTROL) & PCI_MSIX_CONTROL_TABLE_SIZE_MASK) + 1;
+}
+
+// map table and turn on msi-x
+bool PCIDevice::EnableMSIX(){
+    uint8_t cap = FindCapability(PCI_CAP_ID_MSIX);
+    if(cap == 0){
+        return false;
+    }
+
+    msixTableSize = GetMSIXVectorCount();
+
+    // table location is given as bar index and offset in that bar
+    uint32_t table = ReadConfigDword(cap + PCI_MSIX_TABLE);
+    uint8_t bir = table & PCI_MSIX_TABLE_BIR_MASK;
+    uint64_t tablePhys = GetBAR(bir) + (table & ~uint32_t(PCI_MSIX_TABLE_BIR_MASK));
+    msixTable = GetDefaultVirtualMemoryManager().MapDeviceMemory(tablePhys, uint64_t(msixTableSize) * PCI_MSIX_ENTRY_SIZE);
+
+    EnableCommand(PCI_COMMAND_MEMORY_SPACE);
+
+    // keep everything masked while entries are being programmed
+    uint16_t control = ReadConfigWord(cap + PCI_MSIX_CONTROL);
+    WriteConfigWord(cap + PCI_MSIX_CONTROL, control | PCI_MSIX_CONTROL_FUNCTION_MASK | PCI_MSIX_CONTROL_ENABLE);
+    for(uint16_t i = 0; i < msixTableSize; i++){
+        MaskMSIXVector(i, true);
+    }
+    WriteConfigWord(cap + PCI_MSIX_CONTROL, (control | PCI_MSIX_CONTROL_ENABLE) & ~uint16_t(PCI_MSIX_CONTROL_FUNCTION_MASK));
+
+    EnableCommand(PCI_COMMAND_INTERRUPT_DISABLE);
+
+    return true;
+}
+
+// get a register in msi-x table entry
+static inline volatile uint32_t* MSIXEntryRegister(uint64_t table, uint16_t entry, uint8_t reg){
+    return reinterpret_cast<volatile uint32_t*>(table + uint64_t(entry) * PCI_MSIX_ENTRY_SIZE + reg);
+}
+
+// mask bit in vector control
+void PCIDevice::MaskMSIXVector(uint16_t entry, bool mask){
+    if(entry >= msixTableSize){
+        return;
+    }
+
+    volatile uint32_t* control = MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_VECTOR_CONTROL);
+    if(mask){
+        *control = *control | PCI_MSIX_ENTRY_MASKED;
+    }else{
+        *control = *control & ~uint32_t(PCI_MSIX_ENTRY_MASKED);
+    }
+}
+
+// change destination of entry, entry is masked while address is rewritten
+bool PCIDevice::SetMSIXAffinity(uint16_t entry, uint32_t apicID){
+    if((entry >= msixTableSize) || !CheckMSIDestination(apicID)){
+        return false;
+    }
+
+    bool masked = *MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_VECTOR_CONTROL) & PCI_MSIX_ENTRY_MASKED;
+    MaskMSIXVector(entry, true);
+    *MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_ADDRESS_LOW) = MSI_ADDRESS_BASE | (apicID << MSI_ADDRESS_DEST_SHIFT);
+    *MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_ADDRESS_HIGH) = 0;
+    MaskMSIXVector(entry, masked);
+
+    return true;
+}
+
+// allocate, register and route
+int PCIDevice::BindMSIXVector(uint16_t entry, uint32_t apicID, IrqHandler handler, void* context){
+    if(entry >= msixTableSize){
+        Printf("[-] MSI-X entry %u out of range (table has %u entries)\n", entry, msixTableSize);
+        return -1;
+    }
+
+    if(!CheckMSIDestination(apicID)){
+        return -1;
+    }
+
+    int vector = AllocateIrqVectors(1);
+    if(vector < 0){
+        return -1;
+    }
+
+    if(!RegisterIrqHandler(uint8_t(vector), handler, context)){
+        Printf("[-] Failed to register handler for MSI-X vector 0x%x\n", vector);
+        FreeIrqVectors(uint8_t(vector), 1);
+        return -1;
+    }
+
+    MaskMSIXVector(entry, true);
+    *MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_ADDRESS_LOW) = MSI_ADDRESS_BASE | (apicID << MSI_ADDRESS_DEST_SHIFT);
+    *MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_ADDRESS_HIGH) = 0;
+    *MSIXEntryRegister(msixTable, entry, PCI_MSIX_ENTRY_DATA) = uint32_t(vector);
+    MaskMSIXVector(entry, false);
+
+    return vector;
+}
+
+// call callback for each device present on bus
+// enumeration stops if callback returns true
+template<typename Callback>
+static bool ForEachPCIDevice(Callback callback){
+    for(uint16_t bus = 0; bus < 256; bus++){
+        for(uint8_t slot = 0; slot < 32; slot++){
+            PCIDevice device;
+            device.bus = uint8_t(bus);
+            device.slot = slot;
+
+            // if function 0 is not present then device is not present
+            if(device.ReadConfigWord(PCI_VENDOR_ID) == PCI_INVALID_VENDOR){
+                continue;
+            }
+
+            // bit 7 of header type is set for multi function devices
+            uint8_t numFunctions = (device.ReadConfigByte(PCI_HEADER_TYPE) & 0x80) ? 8 : 1;
+            for(uint8_t function = 0; function < numFunctions; function++){
+                device.function = function;
+                device.vendorID = device.ReadConfigWord(PCI_VENDOR_ID);
+                if(device.vendorID == PCI_INVALID_VENDOR){
+                    continue;
+                }
+
+                device.deviceID = device.ReadConfigWord(PCI_DEVICE_ID);
+                if(callback(device)){
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+// find device
+bool FindPCIDevice(uint16_t vendorID, uint16_t deviceID, PCIDevice& device, uint32_t idx){
+    return ForEachPCIDevice([&](PCIDevice& d){
+        if((d.vendorID == vendorID) && (d.deviceID == deviceID)){
+            if(idx == 0){
+                device = d;
+                return true;
+            }
+
+            idx--;
+        }
+
+        return false;
+    });
+}
+
+// print devices
+void ShowPCIDevices(){
+    Printf("[+] PCI Devices : \n");
+    ForEachPCIDevice([](PCIDevice& d){
+        uint32_t classCode = d.ReadConfigDword(PCI_CLASS) >> 8;
+        Printf("\t%x:%x.%x vendor = %x device = %x class = %x msi = %u msix = %u\n",
+               d.bus, d.slot, d.function, d.vendorID, d.deviceID, classCode,
+               d.GetMSIVectorCount(), d.GetMSIXVectorCount());
+        return false;
+    });
+}
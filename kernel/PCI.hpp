@@ -0,0 +1,181 @@
+/**
+ *@file PCI.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief PCI configuration space access and device enumeration
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PCI_HPP
+#define PCI_HPP
+
+#include <cstdint>
+#include "IRQ.hpp"
+
+// configuration space is accessed using these two ports
+// write address of register to PCI_CONFIG_ADDRESS and then
+// read/write data from/to PCI_CONFIG_DATA
+#define PCI_CONFIG_ADDRESS 0xcf8
+#define PCI_CONFIG_DATA 0xcfc
+
+// offsets of common registers in configuration space
+#define PCI_VENDOR_ID 0x00
+#define PCI_DEVICE_ID 0x02
+#define PCI_COMMAND 0x04
+#define PCI_STATUS 0x06
+#define PCI_CLASS 0x08
+#define PCI_HEADER_TYPE 0x0e
+#define PCI_BAR0 0x10
+#define PCI_CAPABILITIES_POINTER 0x34
+#define PCI_INTERRUPT_LINE 0x3c
+
+// command register bits
+#define PCI_COMMAND_IO_SPACE (1 << 0)
+#define PCI_COMMAND_MEMORY_SPACE (1 << 1)
+#define PCI_COMMAND_BUS_MASTER (1 << 2)
+#define PCI_COMMAND_INTERRUPT_DISABLE (1 << 10)
+
+// status register bits
+#define PCI_STATUS_CAPABILITIES_LIST (1 << 4)
+
+// capability ids
+#define PCI_CAP_ID_MSI 0x05
+#define PCI_CAP_ID_MSIX 0x11
+
+// msi capability registers (offsets from start of capability)
+#define PCI_MSI_CONTROL 0x02
+#define PCI_MSI_ADDRESS_LOW 0x04
+#define PCI_MSI_ADDRESS_HIGH 0x08
+#define PCI_MSI_DATA_32 0x08 // device with 32 bit message address
+#define PCI_MSI_DATA_64 0x0c // device with 64 bit message address
+#define PCI_MSI_CONTROL_ENABLE (1 << 0)
+#define PCI_MSI_CONTROL_64BIT (1 << 7)
+// log2 of vectors supported (bits 1-3) and enabled (bits 4-6)
+#define PCI_MSI_CONTROL_MMC_SHIFT 1
+#define PCI_MSI_CONTROL_MME_SHIFT 4
+#define PCI_MSI_MAX_VECTORS 32
+
+// msi-x capability registers (offsets from start of capability)
+#define PCI_MSIX_CONTROL 0x02
+#define PCI_MSIX_TABLE 0x04
+#define PCI_MSIX_CONTROL_TABLE_SIZE_MASK 0x7ff
+#define PCI_MSIX_CONTROL_FUNCTION_MASK (1 << 14)
+#define PCI_MSIX_CONTROL_ENABLE (1 << 15)
+#define PCI_MSIX_TABLE_BIR_MASK 0x7
+
+// msi-x table entry, table is in memory pointed by one of the bars
+#define PCI_MSIX_ENTRY_SIZE 16
+#define PCI_MSIX_ENTRY_ADDRESS_LOW 0x00
+#define PCI_MSIX_ENTRY_ADDRESS_HIGH 0x04
+#define PCI_MSIX_ENTRY_DATA 0x08
+#define PCI_MSIX_ENTRY_VECTOR_CONTROL 0x0c
+#define PCI_MSIX_ENTRY_MASKED (1 << 0)
+
+// message is a write to local apic region of destination cpu
+// fixed delivery mode, physical destination, edge triggered
+#define MSI_ADDRESS_BASE 0xfee00000
+#define MSI_ADDRESS_DEST_SHIFT 12
+// wider ids need interrupt remapping
+#define MSI_MAX_DEST_APIC_ID 0xff
+
+// vendor id of a non existent device
+#define PCI_INVALID_VENDOR 0xffff
+
+// a single function of a device on PCI bus
+struct PCIDevice{
+    uint8_t bus = 0;
+    uint8_t slot = 0;
+    uint8_t function = 0;
+
+    uint16_t vendorID = PCI_INVALID_VENDOR;
+    uint16_t deviceID = PCI_INVALID_VENDOR;
+
+    // read/write registers in configuration space of this device
+    uint32_t ReadConfigDword(uint8_t offset);
+    uint16_t ReadConfigWord(uint8_t offset);
+    uint8_t ReadConfigByte(uint8_t offset);
+    void WriteConfigDword(uint8_t offset, uint32_t value);
+    void WriteConfigWord(uint8_t offset, uint16_t value);
+
+    // get base address in given BAR
+    // I/O and memory flags bits are masked out
+    uint64_t GetBAR(uint8_t idx);
+    // check if given BAR is an I/O space BAR
+    bool IsIOBAR(uint8_t idx);
+
+    // set given bits in command register
+    void EnableCommand(uint16_t bits);
+
+    // get offset of capability with given id in configuration space, 0 if not present
+    uint8_t FindCapability(uint8_t id);
+
+    // Message signalled interrupts : device writes vector number to local apic of
+    // destination cpu, so nothing is shared and no ioapic routing is needed.
+    // Vectors come from dynamic range in IRQ.hpp and go through normal dispatch.
+    // Destination is given as local apic id.
+
+    // max number of msi vectors device supports, 0 if no msi capability
+    uint8_t GetMSIVectorCount();
+
+    // enable msi with count vectors (rounded up to power of 2), all go to same cpu
+    // handler is registered for each vector with given context
+    // returns first vector, device raises first + n for it's n-th interrupt, -1 on failure
+    int EnableMSI(uint8_t count, uint32_t apicID, IrqHandler handler, void* context);
+
+    // number of entries in msi-x table, 0 if no msi-x capability
+    uint16_t GetMSIXVectorCount();
+
+    // enable msi-x with all entries masked, entries are bound one by one after this
+    bool EnableMSIX();
+
+    // allocate a vector for msi-x table entry, register handler for it
+    // and route it to given cpu. returns vector, -1 on failure
+    int BindMSIXVector(uint16_t entry, uint32_t apicID, IrqHandler handler, void* context);
+
+    // move msi-x entry to another cpu, vector stays same
+    bool SetMSIXAffinity(uint16_t entry, uint32_t apicID);
+
+    // mask/unmask msi-x table entry
+    void MaskMSIXVector(uint16_t entry, bool mask);
+
+    // virtual address of msi-x table, set by EnableMSIX
+    uint64_t msixTable = 0;
+    uint16_t msixTableSize = 0;
+};
+
+// find idx-th device with given vendor and device id
+// returns false if no such device is present
+bool FindPCIDevice(uint16_t vendorID, uint16_t deviceID, PCIDevice& device, uint32_t idx = 0);
+
+// print all devices on PCI bus
+void ShowPCIDevices();
+
+#endif // PCI_HPP
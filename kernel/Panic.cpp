@@ -11,7 +11,7 @@
 uint32_t oldbgcolor = 0;
 uint32_t oldfgcolor = 0;
 
-void PRINTF_API(1, 2) INTERRUPT_CALLEE_API PanicPrintf(const char* fmtstr, ...){
+void PRINTF_API(1, 2) PanicPrintf(const char* fmtstr, ...){
     // shorter name "r"
     FontRenderer& r = GetDefaultFontRenderer();
 
@@ -35,7 +35,7 @@ void PRINTF_API(1, 2) INTERRUPT_CALLEE_API PanicPrintf(const char* fmtstr, ...){
 }
 
 // normal print without formatting
-void INTERRUPT_CALLEE_API PanicPuts(const char* str){
+void PanicPuts(const char* str){
     // shorter name "r"
     FontRenderer& r = GetDefaultFontRenderer();
 
@@ -47,8 +47,8 @@ void INTERRUPT_CALLEE_API PanicPuts(const char* str){
     r.backgroundColour = PANIC_BGCOLOR;
     r.foregroundColour = PANIC_FGCOLOR;
 
-    // draw string
-    DrawString(str);
+    // draw string, without console lock since we may have panicked while holding it
+    r.DrawString(str);
 
     // restore colors
     r.backgroundColour = oldbgcolor;
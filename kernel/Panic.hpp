@@ -11,9 +11,9 @@
 
 // NOTE that after calling this function, caller registers wont be set back to nromal state
 // so panic must only be called in absolute panic state
-void PRINTF_API(1, 2) INTERRUPT_CALLEE_API PanicPrintf(const char* fmtstr, ...);
+void PRINTF_API(1, 2) PanicPrintf(const char* fmtstr, ...);
 
 // panic puts
-void INTERRUPT_CALLEE_API PanicPuts(const char* str);
+void PanicPuts(const char* str);
 
 #endif // PANIC_HPP
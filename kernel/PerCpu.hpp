@@ -0,0 +1,164 @@
+/**
+ *@file PerCpu.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Per cpu data helpers
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PERCPU_HPP
+#define PERCPU_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// max number of cpus kernel can manage
+#define MAX_CPUS 64
+
+// data written often is kept on separate cache lines
+#define CACHE_LINE_SIZE 64
+
+// sizes of per cpu scratch buffers
+#define PRINTF_BUFFER_SIZE 0x400
+#define INT_TO_STRING_BUFFER_SIZE 128
+
+struct IrqPoller;
+struct Thread;
+
+// Data private to each cpu. GS base of every cpu points to it's own CpuData,
+// so a field can be read or written with a single gs relative instruction (see PerCpu below).
+// Whole struct is cache line aligned so that two cpus never share a line, and
+// fields are grouped so that read mostly ones don't share a line with hot counters.
+// There's no user mode, so gs base always holds kernel's value and swapgs is never needed.
+struct CpuData {
+    // read mostly, set during bring up
+    CpuData* self; // address of this struct, gs:0 gives it
+    size_t index; // in range [0, MAX_CPUS), per cpu arrays are indexed with this
+    uint32_t apicID; // local apic id of this cpu
+
+    // written on every interrupt
+    uint64_t irqStackTop __attribute__((aligned(CACHE_LINE_SIZE))); // see IRQ.cpp
+    uint64_t irqStackDepth;
+    uint32_t softirqPending; // see SoftIRQ.cpp
+    bool softirqRunning;
+    uint32_t softirqDisableCount; // softirqs don't run on this cpu while this isn't 0
+    IrqPoller* pollList; // see IrqPoll.cpp
+
+    // written on every context switch, see Scheduler.cpp
+    Thread* currentThread;
+    Thread* previousThread; // thread we just switched away from
+    uint32_t preemptCount; // current thread can be preempted only when this is 0
+    bool needResched;
+
+    // written by other cpus to wake this one up, alone on it's line since idle cpu
+    // monitors it and any write to the line ends mwait, see Idle.cpp
+    uint32_t idleWakeup __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    // scratch buffers for formatting, so cpus don't overwrite each other's output
+    char printfBuffer[PRINTF_BUFFER_SIZE] __attribute__((aligned(CACHE_LINE_SIZE)));
+    char intToStringBuffer[INT_TO_STRING_BUFFER_SIZE];
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+// setup data area for cpu with given index and point gs base of current cpu to it
+// must be the first thing a cpu does, everything else depends on cpu index
+void InitializeCpuData(size_t index, uint32_t apicID);
+
+// get data area of cpu with given index
+CpuData* GetCpuData(size_t index);
+
+// data area of cpu executing this code
+inline CpuData* GetCurrentCpuData(){
+    CpuData* self;
+    asm volatile("mov %%gs:0, %0"
+                 : "=r"(self));
+    return self;
+}
+
+// Typed access to a field of current cpu's data, use through PER_CPU(field).
+// Each operation is a single gs relative instruction, so it's atomic with respect
+// to interrupts on this cpu without disabling them. These are not atomic with
+// respect to other cpus, a cpu's data must be modified only by that cpu.
+template<typename T, size_t Offset>
+struct PerCpu {
+    static T Read(){
+        T value;
+        asm volatile("mov %%gs:%c1, %0"
+                     : "=r"(value)
+                     : "i"(Offset));
+        return value;
+    }
+
+    static void Write(T value){
+        asm volatile("mov %0, %%gs:%c1"
+                     :
+                     : "r"(value), "i"(Offset)
+                     : "memory");
+    }
+
+    static void Add(T value){
+        asm volatile("add %0, %%gs:%c1"
+                     :
+                     : "r"(value), "i"(Offset)
+                     : "memory", "cc");
+    }
+
+    static void Or(T value){
+        asm volatile("or %0, %%gs:%c1"
+                     :
+                     : "r"(value), "i"(Offset)
+                     : "memory", "cc");
+    }
+
+    // returns old value
+    static T Exchange(T value){
+        asm volatile("xchg %0, %%gs:%c1"
+                     : "+r"(value)
+                     : "i"(Offset)
+                     : "memory");
+        return value;
+    }
+
+    // address of field in current cpu's data, for atomics and bigger types
+    // arrays are reached with GetCurrentCpuData()->field
+    static T* Pointer(){
+        return reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(GetCurrentCpuData()) + Offset);
+    }
+};
+
+// accessor for a field of CpuData
+#define PER_CPU(field) PerCpu<decltype(CpuData::field), offsetof(CpuData, field)>
+
+// index of cpu executing this code
+inline size_t GetCurrentCpuIndex(){
+    return PER_CPU(index)::Read();
+}
+
+#endif // PERCPU_HPP
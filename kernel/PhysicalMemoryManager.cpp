@@ -37,13 +37,14 @@
 #include "PhysicalMemoryManager.hpp"
 #include "Constants.hpp"
 #include "Printf.hpp"
+#include "Common.hpp"
 #include "Utils/String.hpp"
+#include "Swap.hpp"
+#include "VirtualMemoryManager.hpp"
 
 #include "Bootloader/BootInfo.hpp"
 #include "Bootloader/Util.hpp"
 
-#define MEM_PHYS_OFFSET 0xffff800000000000
-
 // defines a memory block
 struct MemoryBlock{
     uint64_t base = 0;
@@ -59,6 +60,7 @@ PhysicalMemoryManager::PhysicalMemoryManager(){
         return;
     }
 
+    lock.SetName("pmm");
     numMemmapEntries = BootInfo::GetMemmapCount();
     memmapEntries = BootInfo::GetMemmap();
 
@@ -90,7 +92,7 @@ PhysicalMemoryManager::PhysicalMemoryManager(){
         Printf("[-] Insufficient memory to initialize PhysicalMemoryManager\n");
         Printf("\tLargest memory block size : %li KB\n", (largestMemBlock.size / KB));
         Printf("\tMemory required : %li KB\n", (numPagesUsedByStack * PAGE_SIZE / KB));
-        while(true)asm("hlt");
+        EternalHalt();
     }
 
     // set pages at the start of this memory region
@@ -143,16 +145,30 @@ uint64_t PhysicalMemoryManager::GetTotalMemory(){ return freeMemory + usedMemory
 // allocate's a single page
 // this pops out the top element from stack and returns the value
 uint64_t PhysicalMemoryManager::AllocatePage(){
+    // running low on memory, try to swap out some cold pages
+    // reclaim path itself needs a few pages so this is done before we completely run out
+    if(currentStackSize < SWAP_RECLAIM_WATERMARK){
+        Swap::ReclaimPages(SWAP_RECLAIM_BATCH);
+    }
+
+    // page faults allocate too, so no interrupts while lock is held
+    MCSNode node;
+    uint64_t rflags = lock.LockIrqSave(&node);
+
     if(currentStackSize == 0){
+        lock.UnlockIrqRestore(&node, rflags);
         Printf("Out Of Memory!");
-        while(true)asm("hlt");
+        EternalHalt();
     }
 
     freeMemory -= PAGE_SIZE;
     usedMemory += PAGE_SIZE;
 
     currentStackSize--;
-    return pageStack[currentStackSize];
+    uint64_t page = pageStack[currentStackSize];
+
+    lock.UnlockIrqRestore(&node, rflags);
+    return page;
 }
 
 // allocate more than one pages at a time
@@ -177,24 +193,29 @@ uint64_t* PhysicalMemoryManager::AllocatePages(size_t n){
 // free a single page
 void PhysicalMemoryManager::FreePage(uint64_t page){
     bool freeable = true;
-    page -= MEM_PHYS_OFFSET;
+    // memory map contains physical addresses
+    // but the stack must contain addresses with higher half offset
+    uint64_t paddr = page - MEM_PHYS_OFFSET;
     for(uint64_t i = 0; i < numMemmapEntries; i++){
         if(memmapEntries[i].type != STIVALE2_MMAP_USABLE){
             // check if any part of this page is inside a reserved region
-            if((page + PAGE_SIZE > memmapEntries[i].base) &&
-               (page <= memmapEntries[i].base + memmapEntries[i].length)){
+            if((paddr + PAGE_SIZE > memmapEntries[i].base) &&
+               (paddr < memmapEntries[i].base + memmapEntries[i].length)){
                 freeable = false;
             }
         }
     }
 
     if(freeable){
+        MCSNode node;
+        uint64_t rflags = lock.LockIrqSave(&node);
         pageStack[currentStackSize] = page;
         currentStackSize++;
         usedMemory -= PAGE_SIZE;
         freeMemory += PAGE_SIZE;
+        lock.UnlockIrqRestore(&node, rflags);
     }else{
-        Printf("Attemt to free a reserved page! : Address = %lx\n", page);
+        Printf("Attemt to free a reserved page! : Address = %lx\n", paddr);
     }
 }
 
@@ -41,6 +41,7 @@
 #include <cstddef>
 #include "Bootloader/BootInfo.hpp"
 #include "Constants.hpp"
+#include "MCSLock.hpp"
 
 // Stack based page frame allocator :
 // store available pages in a stack
@@ -70,7 +71,7 @@ struct PhysicalMemoryManager{
     static uint64_t GetTotalMemory();
 
     // allocate a single page
-    // NOTE : Allocate page will always return PhysicalAddress + 0xffff800000000000
+    // NOTE : Allocate page will always return PhysicalAddress + MEM_PHYS_OFFSET
     [[nodiscard]] static uint64_t AllocatePage();
 
     // allocate multiple pages at once
@@ -105,6 +106,10 @@ private:
     // number of pages used by stack
     static inline size_t numPagesUsedByStack = 0;
 
+    // protects page stack and memory counters, every cpu allocates pages
+    // so waiters queue up instead of all spinning on one line
+    static inline MCSLock lock = {};
+
     // keep the memory map to check that we don't accidentially deallocate a reserved block
     static inline uint64_t numMemmapEntries = 0;
     static inline MemMapEntry* memmapEntries = nullptr;
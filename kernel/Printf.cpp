@@ -38,13 +38,18 @@
 
 #include "Renderer/FontRenderer.hpp"
 #include "Utils/String.hpp"
+#include "PerCpu.hpp"
+#include "SoftIRQ.hpp"
 #include <cstdint>
 #include <cstdarg>
 #include <cwctype>
 
-static char kprintf_buff[0x400] = {0};
-
 int PRINTF_API(1, 2) Printf(const char* fmtstr, ...){
+    // each cpu formats in it's own buffer, so stay on this cpu's thread until done
+    // and don't let a softirq printing on this cpu reuse it meanwhile (this disables preemption too)
+    SoftIRQ::DisableLocal();
+    char* kprintf_buff = GetCurrentCpuData()->printfBuffer;
+    kprintf_buff[0] = 0;
     va_list vl;
     int i = 0, finalstrsz = 0;
     va_start(vl, fmtstr);
@@ -115,8 +120,9 @@ int PRINTF_API(1, 2) Printf(const char* fmtstr, ...){
             }
 
             case 's':{
+                // buffer isn't terminated while it's being filled, so append at current end
                 char* tmp = va_arg(vl, char*);
-                strcat(kprintf_buff, tmp);
+                strcpy(&kprintf_buff[finalstrsz], tmp);
                 finalstrsz += strlen(tmp);
                 break;
             }
@@ -134,6 +140,7 @@ int PRINTF_API(1, 2) Printf(const char* fmtstr, ...){
     DrawString(kprintf_buff);
 
     va_end(vl);
+    SoftIRQ::EnableLocal();
     return finalstrsz;
 }
 
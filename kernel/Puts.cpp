@@ -45,6 +45,7 @@ void Puts(const char* str){
 // puts but with a color
 void ColorPuts(uint32_t fgcolor, uint32_t bgcolor, const char* str){
     FontRenderer& r = GetDefaultFontRenderer();
+    LockDefaultFontRenderer();
 
     // store old colors
     uint32_t oldbg = r.backgroundColour;
@@ -60,6 +61,7 @@ void ColorPuts(uint32_t fgcolor, uint32_t bgcolor, const char* str){
     // reset to old colors
     r.backgroundColour = oldbg;
     r.foregroundColour = oldfg;
+    UnlockDefaultFontRenderer();
 }
 
 // draw a string without any formatting
@@ -79,6 +81,7 @@ void ColorPutChar(uint32_t fgcolor, uint32_t bgcolor, char c){
     }
 
     FontRenderer& r = GetDefaultFontRenderer();
+    LockDefaultFontRenderer();
 
     // store old colors
     oldbg = r.backgroundColour;
@@ -94,4 +97,5 @@ void ColorPutChar(uint32_t fgcolor, uint32_t bgcolor, char c){
     // reset to old colors
     r.backgroundColour = oldbg;
     r.foregroundColour = oldfg;
+    UnlockDefaultFontRenderer();
 }
@@ -0,0 +1,252 @@
+/**
+ *@file Rcu.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Quiescent state based read-copy-update
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Rcu.hpp"
+#include "CPU.hpp"
+#include "APIC.hpp"
+#include "IRQ.hpp"
+#include "SMP.hpp"
+#include "SoftIRQ.hpp"
+#include "Clock.hpp"
+#include "Idle.hpp"
+#include "Printf.hpp"
+
+// callbacks run in softirq
+void Rcu::Initialize(){
+    lock.SetName("rcu");
+    SoftIRQ::Register(SOFTIRQ_RCU, ProcessCallbacks, nullptr);
+    Printf("[+] RCU initialized\n");
+}
+
+// reschedule ipi does nothing by itself, interrupt dispatch notes quiescent state
+// and runs softirqs, idle loop does the same on every pass
+void Rcu::KickCpus(uint64_t mask){
+    if(!APIC::IsEnabled()){
+        return;
+    }
+
+    mask &= ~(uint64_t(1) << GetCurrentCpuIndex());
+    while(mask != 0){
+        size_t cpu = size_t(__builtin_ctzll(mask));
+        mask &= mask - 1;
+        // idle cpus just go around idle loop, busy ones need an interrupt
+        if(!Idle::WakeCpu(cpu)){
+            APIC::SendIPI(GetCpuData(cpu)->apicID, APIC_RESCHEDULE_VECTOR);
+        }
+    }
+}
+
+// cpus that come online later never saw old pointers, they aren't waited for
+void Rcu::StartGracePeriod(){
+    uint64_t online = 0;
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        if(IsCpuOnline(cpu)){
+            online |= uint64_t(1) << cpu;
+        }
+    }
+
+    gpStart = ReadTSC();
+    pendingCpus = online;
+    __atomic_store_n(&currentGp, currentGp + 1, __ATOMIC_RELEASE);
+
+    // a busy cpu would only report on it's next switch or interrupt, that can be a second away
+    KickCpus(online);
+}
+
+// one in progress may have started before caller's update, so it needs the one after
+uint64_t Rcu::RequestGracePeriod(){
+    if(currentGp != completedGp){
+        gpRequested = true;
+        return currentGp + 1;
+    }
+
+    StartGracePeriod();
+    return currentGp;
+}
+
+// slow path, caller is in quiescent state for as long as this runs
+// so it's fine to report for whichever grace period is current under lock
+void Rcu::ReportQuiescentState(size_t cpu){
+    uint64_t bit = uint64_t(1) << cpu;
+
+    lock.Lock();
+    cpus[cpu].quiescentGp = currentGp;
+    if(pendingCpus & bit){
+        pendingCpus &= ~bit;
+        cpus[cpu].numQuiescentStates++;
+
+        if(pendingCpus == 0){
+            uint64_t cycles = ReadTSC() - gpStart;
+            totalGpCycles += cycles;
+            if(cycles > maxGpCycles){
+                maxGpCycles = cycles;
+            }
+            __atomic_store_n(&completedGp, currentGp, __ATOMIC_RELEASE);
+
+            // cpus with callbacks run them from softirq, idle ones need waking up
+            KickCpus(callbackCpus);
+            if(gpRequested){
+                gpRequested = false;
+                StartGracePeriod();
+            }
+        }
+    }
+    lock.Unlock();
+}
+
+// fast path only reads two shared words that change once per grace period
+void Rcu::NoteQuiescentState(){
+    size_t cpu = GetCurrentCpuIndex();
+    CpuState& state = cpus[cpu];
+
+    uint64_t gp = __atomic_load_n(&currentGp, __ATOMIC_ACQUIRE);
+    if((gp != state.quiescentGp) && (gp != __atomic_load_n(&completedGp, __ATOMIC_ACQUIRE))){
+        ReportQuiescentState(cpu);
+    }
+
+    // something to run, or a batch that needs a grace period requested
+    if(((state.waiting != nullptr) && (__atomic_load_n(&completedGp, __ATOMIC_ACQUIRE) >= state.waitingGp)) ||
+       ((state.waiting == nullptr) && (state.next != nullptr))){
+        SoftIRQ::Raise(SOFTIRQ_RCU);
+    }
+}
+
+// only one batch waits at a time, callbacks queued meanwhile form next batch
+void Rcu::AdvanceCallbacks(size_t cpu){
+    CpuState& state = cpus[cpu];
+    if((state.waiting != nullptr) || (state.next == nullptr)){
+        return;
+    }
+
+    state.waiting = state.next;
+    state.next = nullptr;
+    state.nextTail = nullptr;
+
+    lock.Lock();
+    state.waitingGp = RequestGracePeriod();
+    callbackCpus |= uint64_t(1) << cpu;
+    lock.Unlock();
+}
+
+// append to this cpu's next list
+void Rcu::Call(RcuHead* head, RcuCallback function, void* context){
+    head->next = nullptr;
+    head->function = function;
+    head->context = context;
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+    size_t cpu = GetCurrentCpuIndex();
+    CpuState& state = cpus[cpu];
+
+    if(state.nextTail == nullptr){
+        state.next = head;
+    }else{
+        state.nextTail->next = head;
+    }
+    state.nextTail = head;
+    state.numQueued++;
+
+    AdvanceCallbacks(cpu);
+    RestoreInterrupts(rflags);
+}
+
+// every switch is a quiescent state, so yielding keeps this cpu from holding it up
+void Rcu::Synchronize(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    lock.Lock();
+    uint64_t target = RequestGracePeriod();
+    lock.Unlock();
+    NoteQuiescentState();
+    RestoreInterrupts(rflags);
+
+    while(__atomic_load_n(&completedGp, __ATOMIC_ACQUIRE) < target){
+        Scheduler::Yield();
+    }
+}
+
+// run completed batch with interrupts enabled, then request grace period for next one
+void Rcu::ProcessCallbacks(void* context){
+    (void)context;
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+    size_t cpu = GetCurrentCpuIndex();
+    CpuState& state = cpus[cpu];
+
+    RcuHead* batch = nullptr;
+    if((state.waiting != nullptr) && (__atomic_load_n(&completedGp, __ATOMIC_ACQUIRE) >= state.waitingGp)){
+        batch = state.waiting;
+        state.waiting = nullptr;
+
+        lock.Lock();
+        callbackCpus &= ~(uint64_t(1) << cpu);
+        lock.Unlock();
+    }
+
+    AdvanceCallbacks(cpu);
+    RestoreInterrupts(rflags);
+
+    uint64_t count = 0;
+    while(batch != nullptr){
+        RcuHead* next = batch->next;
+        batch->function(batch->context);
+        batch = next;
+        count++;
+    }
+
+    state.numInvoked += count;
+    if(count > state.maxBatch){
+        state.maxBatch = count;
+    }
+}
+
+// counters are read without lock
+void Rcu::ShowStatistics(){
+    Printf("[+] RCU Statistics :\n");
+
+    uint64_t completed = __atomic_load_n(&completedGp, __ATOMIC_ACQUIRE);
+    Printf("\t%lu grace periods completed, avg %lu ns, max %lu ns\n", completed,
+           Clock::CyclesToNs(totalGpCycles / (completed ? completed : 1)), Clock::CyclesToNs(maxGpCycles));
+
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        if(!IsCpuOnline(cpu)){
+            continue;
+        }
+
+        const CpuState& state = cpus[cpu];
+        Printf("\tCPU %lu : %lu quiescent states reported, %lu callbacks queued, %lu invoked, at most %lu in one batch\n",
+               cpu, state.numQuiescentStates, state.numQueued, state.numInvoked, state.maxBatch);
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ *@file Rcu.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Quiescent state based read-copy-update
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef RCU_HPP
+#define RCU_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "PerCpu.hpp"
+#include "SpinLock.hpp"
+#include "Scheduler.hpp"
+
+// called once a grace period has passed after Rcu::Call
+typedef void (*RcuCallback)(void* context);
+
+// embed in objects freed through Rcu::Call
+struct RcuHead {
+    RcuHead* next;
+    RcuCallback function;
+    void* context;
+};
+
+// Read-copy-update for data that's read on hot paths and rarely changed.
+// Readers just load pointers (Dereference), they take no locks and write nothing shared.
+// Writers serialize among themselves (with a lock), publish new versions with Assign,
+// and free old versions only after a grace period : once every cpu has gone
+// through a quiescent state, so no reader can still hold an old pointer.
+//
+// Quiescent states are points where a cpu can't be in a read side critical section :
+// context switch, idle loop and interrupts that came in while interrupted code could
+// have been preempted (interrupts enabled, preemption enabled, no softirq running).
+// Read side critical sections are therefore just regions that can't be preempted.
+// ReadLock/ReadUnlock only disable preemption, and code that already can't be
+// preempted (interrupt handlers, softirqs, interrupts disabled) needs nothing at all.
+//
+// Grace periods are only started when someone waits for one. All cpus online at start
+// must report a quiescent state, they are sent a reschedule ipi so an idle cpu doesn't
+// hold it up. Callbacks queued on a cpu while a grace period is in progress are
+// batched and wait for next one together, they run in a softirq on that cpu.
+struct Rcu {
+    // register softirq
+    static void Initialize();
+
+    // read side critical section, must not sleep or yield inside
+    static void ReadLock(){ Scheduler::DisablePreemption(); }
+    static void ReadUnlock(){ Scheduler::EnablePreemption(); }
+
+    // read a pointer that's published with Assign
+    template<typename T>
+    static T Dereference(const T& pointer){ return __atomic_load_n(&pointer, __ATOMIC_CONSUME); }
+
+    // publish pointer, everything written to what it points to is visible before it
+    template<typename T>
+    static void Assign(T& pointer, T value){ __atomic_store_n(&pointer, value, __ATOMIC_RELEASE); }
+
+    // run function on this cpu after a grace period, can be called from any context
+    // head must stay untouched until function runs
+    static void Call(RcuHead* head, RcuCallback function, void* context);
+
+    // wait until a full grace period has passed, only from a thread outside of
+    // read side critical sections and with interrupts enabled
+    static void Synchronize();
+
+    // called at points where this cpu holds no references, interrupts must be disabled
+    static void NoteQuiescentState();
+
+    // show grace period and callback counters
+    static void ShowStatistics();
+
+private:
+    struct CpuState {
+        uint64_t quiescentGp; // latest grace period this cpu reported for
+        RcuHead* next; // callbacks not yet waiting on a grace period
+        RcuHead* nextTail;
+        RcuHead* waiting; // batch waiting for waitingGp to complete
+        uint64_t waitingGp;
+        // statistics
+        uint64_t numQueued;
+        uint64_t numInvoked;
+        uint64_t numQuiescentStates; // reported, not just noted
+        uint64_t maxBatch;
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    // grace period whose completion makes callbacks queued now safe to run, lock must be held
+    static uint64_t RequestGracePeriod();
+
+    // mark all online cpus pending and kick other cpus, lock must be held
+    static void StartGracePeriod();
+
+    // clear this cpu from pending cpus, complete grace period if it was the last one
+    static void ReportQuiescentState(size_t cpu);
+
+    // next list becomes waiting batch if there's none, interrupts must be disabled
+    static void AdvanceCallbacks(size_t cpu);
+
+    // softirq, runs batch whose grace period completed
+    static void ProcessCallbacks(void* context);
+
+    // ask other cpus in mask to go through interrupt exit or idle loop
+    static void KickCpus(uint64_t mask);
+
+    static inline CpuState cpus[MAX_CPUS] = {};
+
+    // grace period state, written only when grace periods start or end and when
+    // cpus report, fast path of NoteQuiescentState only reads currentGp and completedGp
+    static inline SpinLock lock = {};
+    static inline uint64_t currentGp = 0; // latest started
+    static inline uint64_t completedGp = 0; // latest completed, equal to currentGp when idle
+    static inline uint64_t pendingCpus = 0; // cpus that haven't reported for currentGp
+    static inline bool gpRequested = false; // start another one when current completes
+    static inline uint64_t callbackCpus = 0; // cpus with a waiting batch, kicked on completion
+    // statistics
+    static inline uint64_t gpStart = 0; // tsc
+    static inline uint64_t totalGpCycles = 0;
+    static inline uint64_t maxGpCycles = 0;
+};
+
+#endif // RCU_HPP
@@ -36,12 +36,20 @@
 
 #include "FontRenderer.hpp"
 #include "../Utils/String.hpp"
+#include "../TicketLock.hpp"
+#include "../SoftIRQ.hpp"
 
 // default font renderer
 static FontRenderer DefaultFontRenderer;
 
+// protects default renderer and lastLineSize below
+// ticket lock so that a cpu printing in a loop can't starve others
+// keyboard softirq echoes keys, so softirqs are kept off while it's held, interrupts stay enabled
+static TicketLock consoleLock = {};
+
 void CreateDefaultFontRenderer(){
     DefaultFontRenderer = FontRenderer();
+    consoleLock.SetName("console");
 }
 
 // default font renderer
@@ -133,10 +141,25 @@ void FontRenderer::DrawString(const char* str){
 
 // draw character
 void DrawCharacter(char c){
+    LockDefaultFontRenderer();
     DefaultFontRenderer.DrawCharacter(c);
+    UnlockDefaultFontRenderer();
 }
 
 // draw string
 void DrawString(const char* str){
+    LockDefaultFontRenderer();
     DefaultFontRenderer.DrawString(str);
+    UnlockDefaultFontRenderer();
+}
+
+// for direct use of default renderer
+void LockDefaultFontRenderer(){
+    SoftIRQ::DisableLocal();
+    consoleLock.Lock();
+}
+
+void UnlockDefaultFontRenderer(){
+    consoleLock.Unlock();
+    SoftIRQ::EnableLocal();
 }
@@ -70,10 +70,16 @@ private:
 };
 
 // draw single character using defualt renderer
+// takes console lock, so output of different cpus doesn't get mixed up
 void DrawCharacter(char c);
-// draw a string using default renderer
+// draw a string using default renderer, whole string is drawn under console lock
 void DrawString(const char* str);
 
+// hold console lock while using default renderer directly (changing colours etc...)
+// softirqs are disabled while it's held, so don't take it from a hard interrupt handler
+void LockDefaultFontRenderer();
+void UnlockDefaultFontRenderer();
+
 // create default font renderer
 void CreateDefaultFontRenderer();
 // setter for default font renderer
@@ -0,0 +1,191 @@
+/**
+ *@file SMP.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Bring up of application processors
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SMP.hpp"
+#include "PerCpu.hpp"
+#include "CPU.hpp"
+#include "GDT.hpp"
+#include "IDT.hpp"
+#include "IRQ.hpp"
+#include "APIC.hpp"
+#include "SoftIRQ.hpp"
+#include "Scheduler.hpp"
+#include "Topology.hpp"
+#include "Rcu.hpp"
+#include "Idle.hpp"
+#include "Printf.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "Bootloader/BootInfo.hpp"
+
+// filled by boot cpu before starting others, read by entry stub below
+extern "C" {
+    uint64_t apPageMapRoot = 0;
+    uint32_t apEferFlags = 0;
+}
+
+// Application processors jump here with bootloader's page tables loaded
+// and rsp pointing to the stack we gave them, which isn't mapped in those tables.
+// So switch to kernel's page tables before touching the stack, nx must be enabled
+// before that because kernel's page tables use it.
+// Fake return address keeps stack alignment same as after a call.
+asm(R"(
+.pushsection .text
+.global ApStart
+ApStart:
+    movl $0xc0000080, %ecx
+    rdmsr
+    orl apEferFlags(%rip), %eax
+    wrmsr
+    movq apPageMapRoot(%rip), %rax
+    movq %rax, %cr3
+    xorq %rbp, %rbp
+    pushq $0
+    jmp ApEntry
+.popsection
+)");
+
+// defined in asm above
+extern "C" uint8_t ApStart[];
+
+// set by each cpu once it's ready
+static bool cpuOnline[MAX_CPUS];
+static size_t numOnlineCpus = 1;
+
+// c++ entry of application processors
+extern "C" [[noreturn]] void ApEntry(stivale2_smp_info* info){
+    size_t index = info->extra_argument;
+    InitializeCpuData(index, info->lapic_id);
+
+    // same as boot cpu (see VirtualMemoryManager)
+    WriteCR0(ReadCR0() | CR0_WRITE_PROTECT);
+
+    InstallGDT();
+    LoadIDT();
+    InitializeIrqStack();
+    APIC::InitializeCpu();
+    Topology::InitializeCpu();
+    Scheduler::InitializeCpu();
+    SoftIRQ::InitializeCpu();
+
+    Printf("[+] CPU %lu (Local APIC %u) online\n", index, info->lapic_id);
+    __atomic_store_n(&cpuOnline[index], true, __ATOMIC_RELEASE);
+
+    CpuIdleLoop();
+}
+
+// start cpus one by one
+void StartApplicationProcessors(){
+    cpuOnline[0] = true;
+
+    stivale2_struct_tag_smp* smp = BootInfo::GetSMPInfo();
+    if(smp == nullptr){
+        Printf("[!] Bootloader didn't start application processors, running on boot cpu only\n");
+        return;
+    }
+
+    GetCpuData(0)->apicID = smp->bsp_lapic_id;
+
+    apPageMapRoot = ReadCR3();
+    apEferFlags = uint32_t(ReadMSR(MSR_EFER) & EFER_NO_EXECUTE_ENABLE);
+
+    size_t index = 1;
+    for(uint64_t i = 0; i < smp->cpu_count; i++){
+        stivale2_smp_info* info = &smp->smp_info[i];
+        if(info->lapic_id == smp->bsp_lapic_id){
+            continue;
+        }
+
+        if(index == MAX_CPUS){
+            Printf("[!] Only %u cpus are supported, rest are left parked\n", MAX_CPUS);
+            break;
+        }
+
+        info->target_stack = GetDefaultVirtualMemoryManager().AllocateKernelStack(AP_STACK_SIZE);
+        info->extra_argument = index;
+        // cpu starts as soon as it sees the address
+        __atomic_store_n(&info->goto_address, reinterpret_cast<uint64_t>(ApStart), __ATOMIC_SEQ_CST);
+
+        uint64_t spins = 0;
+        while(!__atomic_load_n(&cpuOnline[index], __ATOMIC_ACQUIRE) && (spins < AP_STARTUP_TIMEOUT)){
+            asm volatile("pause");
+            spins++;
+        }
+
+        if(cpuOnline[index]){
+            numOnlineCpus++;
+        }else{
+            Printf("[-] CPU with Local APIC %u didn't come online\n", info->lapic_id);
+        }
+
+        // index is never reused, cpu might still come up late
+        index++;
+    }
+
+    Printf("[+] %lu CPUs online\n", numOnlineCpus);
+}
+
+// online cpus
+size_t GetNumOnlineCpus(){
+    return numOnlineCpus;
+}
+
+// check cpu state
+bool IsCpuOnline(size_t index){
+    return __atomic_load_n(&cpuOnline[index], __ATOMIC_ACQUIRE);
+}
+
+// idle loop, runs deferred work that interrupts couldn't finish and gives cpu
+// to threads when they become ready
+// interrupts stay disabled from the checks until Idle::Enter sleeps, so no wakeup is missed
+void CpuIdleLoop(){
+    while(true){
+        asm volatile("cli");
+        // every pass is a quiescent state, may raise rcu softirq
+        Rcu::NoteQuiescentState();
+        if(SoftIRQ::HasPending()){
+            SoftIRQ::Run();
+            asm volatile("sti");
+        }else if(Scheduler::HasReadyThreads() || Scheduler::StealWork()){
+            Scheduler::Yield();
+            asm volatile("sti");
+        }else{
+            // woken up by an interrupt, or by a cpu that has work for us (see Idle.hpp)
+            Scheduler::EnterIdle();
+            Idle::Enter();
+            Scheduler::ExitIdle();
+        }
+    }
+}
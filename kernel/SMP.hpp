@@ -0,0 +1,65 @@
+/**
+ *@file SMP.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Bring up of application processors
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SMP_HPP
+#define SMP_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Constants.hpp"
+
+// stack each application processor starts on
+#define AP_STACK_SIZE (16*KB)
+// number of pause loops to wait for an application processor to come online
+#define AP_STARTUP_TIMEOUT 100000000
+
+// Bootloader starts all processors and parks them waiting for an address to jump to.
+// Each one gets it's own stack and cpu index, switches to kernel's page tables,
+// sets up it's gdt/tss, idt, irq stack and local apic and then sits in idle loop.
+// Processors are started one at a time, so bring up code doesn't need locks.
+void StartApplicationProcessors();
+
+// number of cpus that are online (including boot cpu)
+size_t GetNumOnlineCpus();
+
+// check if cpu with given index is online
+bool IsCpuOnline(size_t index);
+
+// run deferred work and ready threads, halt when there's nothing to do
+// this is what idle thread of each cpu runs
+[[noreturn]] void CpuIdleLoop();
+
+#endif // SMP_HPP
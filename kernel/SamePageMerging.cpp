@@ -0,0 +1,425 @@
+/**
+ *@file SamePageMerging.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Merges anonymous pages with same contents into a single read only frame
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SamePageMerging.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "Interrupts.hpp"
+#include "Swap.hpp"
+#include "Printf.hpp"
+#include "CPU.hpp"
+#include "Scheduler.hpp"
+#include "Tlb.hpp"
+#include "Utils/String.hpp"
+
+// FNV-1a constants
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325
+#define FNV_PRIME 0x100000001b3
+
+// hash contents of a page
+// zero is set to true if page is completely zero filled
+static uint64_t HashPage(uint64_t page, bool& zero){
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(page);
+    uint64_t hash = FNV_OFFSET_BASIS;
+    uint64_t bits = 0;
+
+    // hash 8 bytes at a time, this is a lot faster than byte by byte
+    for(size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++){
+        hash = (hash ^ words[i]) * FNV_PRIME;
+        bits |= words[i];
+    }
+
+    zero = (bits == 0);
+    return hash;
+}
+
+// get physical frame (with higher half offset) mapped in given page
+static inline uint64_t GetFrame(Page* page){
+    return (page->GetAddress() << 12) + MEM_PHYS_OFFSET;
+}
+
+// stop writes to page on all cpus, contents hashed while it was writable can be checked again after this
+static void WriteProtect(Page* page, uint64_t vaddr){
+    page->UnsetFlags(MAP_READ_WRITE);
+    Tlb::Shootdown(vaddr);
+}
+
+// map frame read only and mark copy on write
+// old frame is freed by caller, so no cpu may keep reading it through a stale tlb entry
+static void MapShared(Page* page, uint64_t vaddr, uint64_t frame){
+    page->SetAddress((frame - MEM_PHYS_OFFSET) >> 12);
+    page->UnsetFlags(MAP_READ_WRITE);
+    page->SetFlags(MAP_COPY_ON_WRITE);
+    Tlb::Shootdown(vaddr);
+}
+
+// get shared zero page, first caller allocates it
+uint64_t SamePageMerging::GetZeroPage(){
+    uint64_t page = __atomic_load_n(&zeroPage, __ATOMIC_ACQUIRE);
+    if(page != NULLADDR){
+        return page;
+    }
+
+    page = PhysicalMemoryManager::AllocatePage();
+    memset(reinterpret_cast<void*>(page), 0, PAGE_SIZE);
+
+    uint64_t expected = NULLADDR;
+    if(!__atomic_compare_exchange_n(&zeroPage, &expected, page, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+        PhysicalMemoryManager::FreePage(page);
+        return expected;
+    }
+
+    return page;
+}
+
+// set scan rate
+uint64_t SamePageMerging::SetScanRate(uint64_t pagesPerScan){
+    return __atomic_exchange_n(&scanRate, pagesPerScan, __ATOMIC_RELAXED);
+}
+
+// scanner thread
+void SamePageMerging::ScanThread(void* argument){
+    (void)argument;
+    while(true){
+        Scan();
+        Scheduler::Sleep(SPM_SCAN_INTERVAL_NS);
+    }
+}
+
+// start scanner
+void SamePageMerging::Start(){
+    if(Scheduler::CreateThread("spm", ScanThread, nullptr) == nullptr){
+        Printf("[-] Failed to create same page merging thread\n");
+        return;
+    }
+
+    Printf("[+] Same page merging scans %lu pages every %lu ms\n", scanRate, SPM_SCAN_INTERVAL_NS / 1000000);
+}
+
+// find shared frame with same contents as given frame
+int32_t SamePageMerging::FindStableByContents(uint64_t frame, uint64_t hash){
+    for(int32_t i = hashBuckets[hash & (SPM_NUM_BUCKETS - 1)]; i != -1; i = stableFrames[i].nextByHash){
+        if((stableFrames[i].hash == hash) &&
+           (memcmp(reinterpret_cast<void*>(stableFrames[i].frame), reinterpret_cast<void*>(frame), PAGE_SIZE) == 0)){
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// find shared frame entry for given frame
+int32_t SamePageMerging::FindStableByFrame(uint64_t frame){
+    for(int32_t i = frameBuckets[(frame / PAGE_SIZE) & (SPM_NUM_BUCKETS - 1)]; i != -1; i = stableFrames[i].nextByFrame){
+        if(stableFrames[i].frame == frame){
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// add a new shared frame
+int32_t SamePageMerging::InsertStable(uint64_t frame, uint64_t hash){
+    if(freeStableFrame == -1){
+        return -1;
+    }
+
+    int32_t idx = freeStableFrame;
+    freeStableFrame = stableFrames[idx].nextByHash;
+
+    StableFrame& sf = stableFrames[idx];
+    sf.frame = frame;
+    sf.hash = hash;
+    sf.refcount = 0;
+
+    // link in both buckets
+    uint64_t hb = hash & (SPM_NUM_BUCKETS - 1);
+    sf.nextByHash = hashBuckets[hb];
+    hashBuckets[hb] = idx;
+
+    uint64_t fb = (frame / PAGE_SIZE) & (SPM_NUM_BUCKETS - 1);
+    sf.nextByFrame = frameBuckets[fb];
+    frameBuckets[fb] = idx;
+
+    numSharedFrames++;
+    return idx;
+}
+
+// remove shared frame
+void SamePageMerging::RemoveStable(int32_t idx){
+    StableFrame& sf = stableFrames[idx];
+
+    // unlink from hash bucket
+    int32_t* link = &hashBuckets[sf.hash & (SPM_NUM_BUCKETS - 1)];
+    while(*link != idx) link = &stableFrames[*link].nextByHash;
+    *link = sf.nextByHash;
+
+    // unlink from frame bucket
+    link = &frameBuckets[(sf.frame / PAGE_SIZE) & (SPM_NUM_BUCKETS - 1)];
+    while(*link != idx) link = &stableFrames[*link].nextByFrame;
+    *link = sf.nextByFrame;
+
+    // put back in free list
+    sf.nextByHash = freeStableFrame;
+    freeStableFrame = idx;
+
+    numSharedFrames--;
+}
+
+// try to merge given page, swap lock must be held
+// page is hashed while it's still writable, so before it's mapped to a shared
+// frame writes to it are stopped and it's checked again
+bool SamePageMerging::MergePage(uint64_t vaddr){
+    Page* page = GetDefaultVirtualMemoryManager().GetPage(vaddr, false);
+
+    // only private writable pages can be merged
+    if((page == nullptr) || !page->GetFlags(MAP_PRESENT) ||
+       !page->GetFlags(MAP_READ_WRITE) || page->GetFlags(MAP_COPY_ON_WRITE)){
+        return false;
+    }
+
+    uint64_t frame = GetFrame(page);
+    bool zero;
+    uint64_t hash = HashPage(frame, zero);
+
+    // look for something to merge with
+    int32_t idx = -1;
+    uint64_t u = numUnstablePages;
+    if(!zero){
+        idx = FindStableByContents(frame, hash);
+        for(uint64_t i = 0; (idx == -1) && (i < numUnstablePages); i++){
+            if(unstablePages[i].hash == hash){
+                u = i;
+                break;
+            }
+        }
+    }
+
+    // remember this page for rest of the pass
+    if(!zero && (idx == -1) && (u == numUnstablePages)){
+        if(numUnstablePages < SPM_MAX_UNSTABLE_PAGES){
+            unstablePages[numUnstablePages++] = {.vaddr = vaddr, .hash = hash};
+        }
+        return false;
+    }
+
+    // page changed after it was hashed
+    WriteProtect(page, vaddr);
+    bool stillZero;
+    if((HashPage(frame, stillZero) != hash) || (stillZero != zero) ||
+       ((idx != -1) && (FindStableByContents(frame, hash) != idx))){
+        page->SetFlags(MAP_READ_WRITE);
+        return false;
+    }
+
+    // zero filled pages are replaced by the zero page
+    if(zero){
+        MapShared(page, vaddr, GetZeroPage());
+        PhysicalMemoryManager::FreePage(frame);
+        numZeroPagesMerged++;
+        return true;
+    }
+
+    // some shared frame has same contents
+    if(idx != -1){
+        MapShared(page, vaddr, stableFrames[idx].frame);
+        stableFrames[idx].refcount++;
+        PhysicalMemoryManager::FreePage(frame);
+        numPagesMerged++;
+        return true;
+    }
+
+    // we saw same page earlier in this pass
+    uint64_t otherVaddr = unstablePages[u].vaddr;
+    unstablePages[u] = unstablePages[--numUnstablePages];
+
+    Page* other = GetDefaultVirtualMemoryManager().GetPage(otherVaddr, false);
+    if((other == nullptr) || !other->GetFlags(MAP_PRESENT) ||
+       !other->GetFlags(MAP_READ_WRITE) || other->GetFlags(MAP_COPY_ON_WRITE)){
+        page->SetFlags(MAP_READ_WRITE);
+        return false;
+    }
+
+    // hash collision or other page changed after it was hashed
+    uint64_t otherFrame = GetFrame(other);
+    WriteProtect(other, otherVaddr);
+    if(memcmp(reinterpret_cast<void*>(otherFrame), reinterpret_cast<void*>(frame), PAGE_SIZE) != 0){
+        other->SetFlags(MAP_READ_WRITE);
+        page->SetFlags(MAP_READ_WRITE);
+        return false;
+    }
+
+    // other page's frame becomes the shared frame
+    idx = InsertStable(otherFrame, hash);
+    if(idx == -1){
+        other->SetFlags(MAP_READ_WRITE);
+        page->SetFlags(MAP_READ_WRITE);
+        return false;
+    }
+
+    // other page keeps it's frame, only marking it copy on write is left
+    other->SetFlags(MAP_COPY_ON_WRITE);
+    MapShared(page, vaddr, otherFrame);
+    stableFrames[idx].refcount = 2;
+    PhysicalMemoryManager::FreePage(frame);
+    numPagesMerged++;
+    return true;
+}
+
+// scan next batch of pages
+uint64_t SamePageMerging::Scan(){
+    if(!isInitialized){
+        for(int32_t i = 0; i < SPM_NUM_BUCKETS; i++){
+            hashBuckets[i] = -1;
+            frameBuckets[i] = -1;
+        }
+
+        // link all entries in free list
+        for(int32_t i = 0; i < SPM_MAX_STABLE_FRAMES; i++){
+            stableFrames[i].nextByHash = (i + 1 < SPM_MAX_STABLE_FRAMES) ? i + 1 : -1;
+        }
+        freeStableFrame = 0;
+
+        isInitialized = true;
+    }
+
+    if(Swap::GetNumTrackedPages() == 0){
+        return 0;
+    }
+
+    // lock is dropped after every page, so faults and reclaim don't wait for whole batch
+    uint64_t reclaimed = 0;
+    uint64_t rate = __atomic_load_n(&scanRate, __ATOMIC_RELAXED);
+    for(uint64_t i = 0; i < rate; i++){
+        uint64_t rflags = Swap::Lock();
+
+        // new pass starts with empty unstable table
+        if(scanCursor >= Swap::GetNumTrackedPages()){
+            scanCursor = 0;
+            numUnstablePages = 0;
+            numFullScans++;
+        }
+
+        if(MergePage(Swap::GetTrackedPage(scanCursor))){
+            reclaimed++;
+        }
+
+        scanCursor++;
+        numPagesScanned++;
+        Swap::Unlock(rflags);
+    }
+
+    numFramesReclaimed += reclaimed;
+    return reclaimed;
+}
+
+// break sharing on write
+bool SamePageMerging::HandlePageFault(uint64_t vaddr, uint64_t errorcode){
+    // only writes to present pages are copy on write faults
+    if(!(errorcode & PAGE_FAULT_PRESENT) || !(errorcode & PAGE_FAULT_WRITE)){
+        return false;
+    }
+
+    vaddr &= ~(PAGE_SIZE - 1);
+    Page* page = GetDefaultVirtualMemoryManager().GetPage(vaddr, false);
+    if(page == nullptr){
+        return false;
+    }
+
+    uint64_t rflags = Swap::Lock();
+
+    // sharing was broken (or merge was undone) after this cpu cached read only mapping
+    if(page->GetFlags(MAP_PRESENT) && page->GetFlags(MAP_READ_WRITE)){
+        Swap::Unlock(rflags);
+        InvalidatePage(vaddr);
+        return true;
+    }
+
+    if(!page->GetFlags(MAP_COPY_ON_WRITE)){
+        Swap::Unlock(rflags);
+        return false;
+    }
+
+    uint64_t frame = GetFrame(page);
+    int32_t idx = (frame == zeroPage) ? -1 : FindStableByFrame(frame);
+
+    bool copied = false;
+    if((idx != -1) && (stableFrames[idx].refcount == 1)){
+        // we are the last user of this frame, just take it
+        RemoveStable(idx);
+    }else{
+        copied = true;
+        uint64_t copy = PhysicalMemoryManager::AllocatePage();
+        if(frame == zeroPage){
+            memset(reinterpret_cast<void*>(copy), 0, PAGE_SIZE);
+        }else{
+            memcpy(reinterpret_cast<void*>(copy), reinterpret_cast<void*>(frame), PAGE_SIZE);
+        }
+
+        if(idx != -1){
+            stableFrames[idx].refcount--;
+        }
+
+        page->SetAddress((copy - MEM_PHYS_OFFSET) >> 12);
+    }
+
+    page->UnsetFlags(MAP_COPY_ON_WRITE);
+    page->SetFlags(MAP_READ_WRITE);
+
+    // other cpus may still read shared frame through a stale entry, they must see the copy
+    // when frame is kept they only have a read only entry, a write there faults and ends up above
+    if(copied){
+        Tlb::Shootdown(vaddr);
+    }else{
+        InvalidatePage(vaddr);
+    }
+
+    numCopyOnWriteBreaks++;
+    Swap::Unlock(rflags);
+    return true;
+}
+
+// print statistics
+void SamePageMerging::ShowStatistics(){
+    Printf("[+] Same Page Merging Stats : \n");
+    Printf("\tScan Rate : %lu pages per scan\n", scanRate);
+    Printf("\tPages Scanned : %lu pages (%lu full scans)\n", numPagesScanned, numFullScans);
+    Printf("\tZero Pages Merged : %lu pages\n", numZeroPagesMerged);
+    Printf("\tPages Merged : %lu pages into %lu shared frames\n", numPagesMerged, numSharedFrames);
+    Printf("\tCopy On Write Breaks : %lu\n", numCopyOnWriteBreaks);
+    Printf("\tFrames Reclaimed : %lu (%lu KB)\n", numFramesReclaimed, numFramesReclaimed * PAGE_SIZE / KB);
+}
@@ -0,0 +1,143 @@
+/**
+ *@file SamePageMerging.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Merges anonymous pages with same contents into a single read only frame
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SAMEPAGEMERGING_HPP
+#define SAMEPAGEMERGING_HPP
+
+#include <cstdint>
+#include "Common.hpp"
+#include "Constants.hpp"
+
+// Scanner goes over anonymous pages (same ones that are tracked for swap)
+// and hashes their contents.
+// - Zero filled pages are replaced by a single shared zero page.
+// - If a page matches an already shared frame (stable table), it's mapped to that frame.
+// - Otherwise page is remembered in the unstable table and when another page
+//   with same contents is found in the same scan pass, both are merged into
+//   a new shared frame.
+// Shared frames are mapped read only and marked copy on write, so first write
+// to them breaks the sharing.
+
+// max number of shared frames
+#define SPM_MAX_STABLE_FRAMES 4096
+// max number of merge candidates remembered in one scan pass
+#define SPM_MAX_UNSTABLE_PAGES 4096
+// number of hash buckets, must be a power of 2
+#define SPM_NUM_BUCKETS 1024
+
+// default number of pages scanned in a single call to Scan
+#define SPM_DEFAULT_SCAN_RATE uint64_t(256)
+// time scanner thread sleeps between two calls to Scan
+#define SPM_SCAN_INTERVAL_NS uint64_t(100000000)
+
+struct SamePageMerging{
+    // get the shared zero page (virtual address)
+    // anonymous memory is mapped to this page until it's first written
+    static uint64_t GetZeroPage();
+
+    // start scanner thread, it calls Scan every SPM_SCAN_INTERVAL_NS
+    static void Start();
+
+    // scan next batch of pages and merge duplicates
+    // returns number of frames reclaimed
+    static uint64_t Scan();
+
+    // set number of pages scanned in each call to Scan, returns previous rate
+    static uint64_t SetScanRate(uint64_t pagesPerScan);
+
+    // must be called by page fault handler
+    // returns true if fault was a write to a copy on write page and sharing was broken
+    static bool HandlePageFault(uint64_t vaddr, uint64_t errorcode);
+
+    // print merging statistics
+    static void ShowStatistics();
+private:
+    // shared frame
+    struct StableFrame{
+        uint64_t frame; // virtual address of shared frame
+        uint64_t hash; // hash of contents
+        uint64_t refcount; // number of pages mapped to this frame
+        int32_t nextByHash; // next frame in same hash bucket (-1 if last)
+        int32_t nextByFrame; // next frame in same frame bucket (-1 if last)
+    };
+
+    // page that may get merged
+    struct UnstablePage{
+        uint64_t vaddr;
+        uint64_t hash;
+    };
+
+    // scan at configured rate forever
+    static void ScanThread(void* argument);
+
+    // try to merge page mapped at given virtual address
+    static bool MergePage(uint64_t vaddr);
+
+    // stable table helpers
+    static int32_t FindStableByContents(uint64_t frame, uint64_t hash);
+    static int32_t FindStableByFrame(uint64_t frame);
+    static int32_t InsertStable(uint64_t frame, uint64_t hash);
+    static void RemoveStable(int32_t idx);
+
+    // shared zero page
+    static inline uint64_t zeroPage = NULLADDR;
+
+    // stable table, shared frames are indexed both by hash and frame address
+    static inline StableFrame stableFrames[SPM_MAX_STABLE_FRAMES] = {};
+    static inline int32_t hashBuckets[SPM_NUM_BUCKETS] = {};
+    static inline int32_t frameBuckets[SPM_NUM_BUCKETS] = {};
+    static inline int32_t freeStableFrame = -1;
+    static inline bool isInitialized = false;
+
+    // unstable table, cleared after every full scan
+    static inline UnstablePage unstablePages[SPM_MAX_UNSTABLE_PAGES] = {};
+    static inline uint64_t numUnstablePages = 0;
+
+    // scanner position and rate
+    static inline uint64_t scanCursor = 0;
+    static inline uint64_t scanRate = SPM_DEFAULT_SCAN_RATE;
+
+    // statistics
+    static inline uint64_t numPagesScanned = 0;
+    static inline uint64_t numFullScans = 0;
+    static inline uint64_t numZeroPagesMerged = 0;
+    static inline uint64_t numPagesMerged = 0;
+    static inline uint64_t numSharedFrames = 0;
+    static inline uint64_t numCopyOnWriteBreaks = 0;
+    static inline uint64_t numFramesReclaimed = 0;
+};
+
+#endif // SAMEPAGEMERGING_HPP
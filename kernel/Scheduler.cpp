@@ -0,0 +1,763 @@
+/**
+ *@file Scheduler.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Preemptive kernel threads with per cpu run queues
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Scheduler.hpp"
+#include "CPU.hpp"
+#include "APIC.hpp"
+#include "IRQ.hpp"
+#include "SMP.hpp"
+#include "Topology.hpp"
+#include "Clock.hpp"
+#include "ClockEvent.hpp"
+#include "TimerWheel.hpp"
+#include "Rcu.hpp"
+#include "Idle.hpp"
+#include "Printf.hpp"
+#include "VirtualMemoryManager.hpp"
+
+// Save callee saved registers of current thread on it's stack, store stack pointer
+// in *oldRsp, load newRsp and restore registers of the other thread from it's stack.
+// Rest of the registers are caller saved so compiler has already taken care of them.
+// New threads get a frame that looks like this was called from ThreadStart,
+// which passes thread (kept in r12) to ThreadMain.
+asm(R"(
+.pushsection .text
+.global SwitchContext
+SwitchContext:
+    pushq %rbx
+    pushq %rbp
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbp
+    popq %rbx
+    ret
+
+ThreadStart:
+    movq %r12, %rdi
+    call ThreadMain
+    ud2
+.popsection
+)");
+
+// defined in asm above
+extern "C" void SwitchContext(uint64_t* oldRsp, uint64_t newRsp);
+extern "C" uint8_t ThreadStart[];
+
+// registers popped by SwitchContext, in order of popping
+struct SwitchFrame {
+    uint64_t r15, r14, r13, r12, rbp, rbx;
+    uint64_t rip;
+};
+
+// first code run by every new thread, interrupts are disabled here
+extern "C" [[noreturn]] void ThreadMain(Thread* thread){
+    Scheduler::FinishSwitch();
+    asm volatile("sti" ::: "memory");
+
+    thread->function(thread->argument);
+    Scheduler::Exit();
+}
+
+// idle thread of boot cpu, others use the context they were started with
+static void IdleThreadMain(void* argument){
+    (void)argument;
+    CpuIdleLoop();
+}
+
+// claim a free slot
+Thread* Scheduler::NewThread(const char* name, ThreadFunction function, void* argument){
+    Thread* thread = nullptr;
+    for(size_t i = 0; i < SCHED_MAX_THREADS; i++){
+        ThreadState expected = THREAD_FREE;
+        if(__atomic_compare_exchange_n(&threads[i].state, &expected, THREAD_READY, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+            thread = &threads[i];
+            break;
+        }
+    }
+
+    if(thread == nullptr){
+        Printf("[-] No free thread slots left\n");
+        return nullptr;
+    }
+
+    thread->id = __atomic_fetch_add(&nextThreadID, 1, __ATOMIC_RELAXED);
+    thread->cpu = GetCurrentCpuIndex();
+    thread->pinned = false;
+    thread->name = name;
+    thread->function = function;
+    thread->argument = argument;
+    thread->switches = 0;
+    thread->next = nullptr;
+
+    return thread;
+}
+
+// stack of an exited thread is reused as is
+void Scheduler::SetupStack(Thread* thread){
+    if(thread->stackTop == 0){
+        thread->stackTop = GetDefaultVirtualMemoryManager().AllocateKernelStack(SCHED_THREAD_STACK_SIZE);
+    }
+
+    // stack must be 16 byte aligned after ThreadStart's call pushes return address
+    SwitchFrame* frame = reinterpret_cast<SwitchFrame*>(thread->stackTop - 16 - sizeof(SwitchFrame));
+    frame->r15 = 0;
+    frame->r14 = 0;
+    frame->r13 = 0;
+    frame->r12 = reinterpret_cast<uint64_t>(thread);
+    frame->rbp = 0; // ends stack traces
+    frame->rbx = 0;
+    frame->rip = reinterpret_cast<uint64_t>(ThreadStart);
+
+    thread->rsp = reinterpret_cast<uint64_t>(frame);
+}
+
+// current stack and registers become a thread
+Thread* Scheduler::AdoptCurrentContext(const char* name, bool idle){
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+
+    Thread* thread = NewThread(name, nullptr, nullptr);
+    thread->state = THREAD_RUNNING;
+    if(idle){
+        queue.idle = thread;
+    }
+
+    queue.sliceEnd = Clock::NowNs() + SCHED_TIME_SLICE_NS;
+    PER_CPU(currentThread)::Write(thread);
+    return thread;
+}
+
+// timer isn't armed until something needs it
+void Scheduler::StartTimer(){
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    queue.startTime = Clock::NowNs();
+    queue.lock.SetName("run queue");
+    TimerWheel::InitializeCpu();
+
+    if(!ClockEvent::IsAvailable()){
+        return;
+    }
+
+    ClockEvent::InitializeCpu();
+    queue.hasTimer = true;
+}
+
+// earliest of : end of time slice if others are waiting, earliest timer wheel expiry,
+// a slow tick if current thread runs alone, nothing if cpu is idle
+void Scheduler::UpdateTimer(RunQueue& queue){
+    if(!queue.hasTimer){
+        return;
+    }
+
+    uint64_t deadline = ~uint64_t(0);
+    bool idle = GetCurrentThread() == queue.idle;
+
+    if(!idle){
+        deadline = (queue.numReady != 0) ? queue.sliceEnd : (Clock::NowNs() + SCHED_SINGLE_TASK_TICK_NS);
+    }
+
+    uint64_t expiry = TimerWheel::GetNextExpiry();
+    if(expiry < deadline){
+        deadline = expiry;
+    }
+
+    if(deadline == ~uint64_t(0)){
+        if(queue.timerDeadline != 0){
+            ClockEvent::Stop();
+            queue.timerDeadline = 0;
+        }
+        return;
+    }
+
+    // an earlier deadline that's already armed is fine, handler will arm again
+    // this keeps slow tick of a single thread from being pushed back on every switch
+    if((queue.timerDeadline == 0) || (deadline < queue.timerDeadline)){
+        ClockEvent::SetDeadline(deadline);
+        queue.timerDeadline = deadline;
+    }
+}
+
+// nearest idle cpu, so stolen thread finds warm caches
+void Scheduler::KickIdleCpu(){
+    if(!APIC::IsEnabled()){
+        return;
+    }
+
+    uint64_t idle = __atomic_load_n(&idleCpuMask, __ATOMIC_RELAXED);
+    if(idle == 0){
+        return;
+    }
+
+    size_t self = GetCurrentCpuIndex();
+    for(uint8_t level = TOPOLOGY_SAME_CORE; level < TOPOLOGY_NUM_LEVELS; level++){
+        for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+            if(!(idle & (uint64_t(1) << cpu)) || (Topology::GetLevel(self, cpu) != level)){
+                continue;
+            }
+
+            // whoever clears the bit wakes it up, so a cpu is woken only once
+            // a cpu in mwait needs just a write, one in hlt gets an ipi
+            uint64_t bit = uint64_t(1) << cpu;
+            if(__atomic_fetch_and(&idleCpuMask, ~bit, __ATOMIC_ACQ_REL) & bit){
+                Idle::WakeCpu(cpu);
+                return;
+            }
+        }
+    }
+}
+
+// idle loop marks itself before halting
+void Scheduler::EnterIdle(){
+    __atomic_fetch_or(&idleCpuMask, uint64_t(1) << GetCurrentCpuIndex(), __ATOMIC_RELEASE);
+}
+
+void Scheduler::ExitIdle(){
+    __atomic_fetch_and(&idleCpuMask, ~(uint64_t(1) << GetCurrentCpuIndex()), __ATOMIC_RELEASE);
+}
+
+// nothing to do here, interrupt just wakes up idle loop
+bool Scheduler::RescheduleHandler(InterruptContext* frame, void* context){
+    (void)frame;
+    (void)context;
+    return true;
+}
+
+// boot cpu
+void Scheduler::Initialize(){
+    RegisterIrqHandler(APIC_TIMER_VECTOR, TimerHandler, nullptr);
+    RegisterIrqHandler(APIC_RESCHEDULE_VECTOR, RescheduleHandler, nullptr);
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+
+    AdoptCurrentContext("init", false);
+
+    Thread* idle = NewThread("idle", IdleThreadMain, nullptr);
+    SetupStack(idle);
+    runQueues[GetCurrentCpuIndex()].idle = idle;
+
+    // init runs alone for now, so it only gets slow tick
+    StartTimer();
+    UpdateTimer(runQueues[GetCurrentCpuIndex()]);
+    RestoreInterrupts(rflags);
+
+    if(!runQueues[GetCurrentCpuIndex()].hasTimer){
+        Printf("[!] No APIC timer, threads are switched only when they yield\n");
+    }
+    Printf("[+] Scheduler initialized\n");
+}
+
+// application processor, already running on it's own stack
+void Scheduler::InitializeCpu(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    AdoptCurrentContext("idle", true);
+    StartTimer();
+    RestoreInterrupts(rflags);
+}
+
+// create and queue
+Thread* Scheduler::CreateThread(const char* name, ThreadFunction function, void* argument, bool pinned){
+    Thread* thread = NewThread(name, function, argument);
+    if(thread == nullptr){
+        return nullptr;
+    }
+
+    thread->pinned = pinned;
+    SetupStack(thread);
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    Enqueue(queue, thread);
+    UpdateTimer(queue);
+    KickIdleCpu();
+    RestoreInterrupts(rflags);
+
+    return thread;
+}
+
+// add at tail
+void Scheduler::Enqueue(RunQueue& queue, Thread* thread){
+    thread->state = THREAD_READY;
+    thread->next = nullptr;
+
+    queue.lock.Lock();
+    if(queue.tail == nullptr){
+        queue.head = thread;
+    }else{
+        queue.tail->next = thread;
+    }
+    queue.tail = thread;
+    queue.numReady++;
+    queue.lock.Unlock();
+}
+
+// take from head
+Thread* Scheduler::Dequeue(RunQueue& queue){
+    queue.lock.Lock();
+    Thread* thread = queue.head;
+    if(thread != nullptr){
+        queue.head = thread->next;
+        if(queue.head == nullptr){
+            queue.tail = nullptr;
+        }
+        queue.numReady--;
+        thread->next = nullptr;
+    }
+    queue.lock.Unlock();
+
+    return thread;
+}
+
+// head ran longest ago so it has least in cache, take that unless it's pinned
+Thread* Scheduler::DequeueForSteal(RunQueue& queue){
+    if(!queue.lock.TryLock()){
+        return nullptr;
+    }
+
+    Thread* previous = nullptr;
+    Thread* thread = queue.head;
+    while((thread != nullptr) && thread->pinned){
+        previous = thread;
+        thread = thread->next;
+    }
+
+    if(thread != nullptr){
+        if(previous == nullptr){
+            queue.head = thread->next;
+        }else{
+            previous->next = thread->next;
+        }
+        if(queue.tail == thread){
+            queue.tail = previous;
+        }
+        queue.numReady--;
+        queue.migrationsOut++;
+        thread->next = nullptr;
+    }
+
+    queue.lock.Unlock();
+    return thread;
+}
+
+// nearest cpus first, starting after ourselves so idle cpus don't all pick same victim
+Thread* Scheduler::Steal(){
+    size_t self = GetCurrentCpuIndex();
+    RunQueue& queue = runQueues[self];
+    queue.stealAttempts++;
+
+    for(uint8_t level = TOPOLOGY_SAME_CORE; level < TOPOLOGY_NUM_LEVELS; level++){
+        for(size_t i = 1; i < MAX_CPUS; i++){
+            size_t cpu = (self + i) % MAX_CPUS;
+            if(!IsCpuOnline(cpu) || (Topology::GetLevel(self, cpu) != level)){
+                continue;
+            }
+
+            // peek without lock, most of the time there's nothing to take
+            RunQueue& victim = runQueues[cpu];
+            if(__atomic_load_n(&victim.numReady, __ATOMIC_RELAXED) == 0){
+                continue;
+            }
+
+            Thread* thread = DequeueForSteal(victim);
+            if(thread != nullptr){
+                thread->cpu = self;
+                queue.migrationsIn++;
+                return thread;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+// idle cpu pulls work
+bool Scheduler::StealWork(){
+    Thread* thread = Steal();
+    if(thread == nullptr){
+        return false;
+    }
+
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    Enqueue(queue, thread);
+    UpdateTimer(queue);
+    return true;
+}
+
+// round robin
+void Scheduler::Schedule(){
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    Thread* previous = GetCurrentThread();
+    PER_CPU(needResched)::Write(false);
+
+    // threads can't switch inside read side critical sections (see Rcu.hpp)
+    Rcu::NoteQuiescentState();
+
+    // current thread may have gone to sleep or exited
+    bool runnable = previous->state == THREAD_RUNNING;
+
+    Thread* next = Dequeue(queue);
+    if(next == nullptr){
+        if(runnable && (previous != queue.idle)){
+            return;
+        }
+
+        // about to go idle, look for work on other cpus first
+        next = Steal();
+        if(next == nullptr){
+            if(runnable){
+                return;
+            }
+            next = queue.idle;
+        }
+    }
+
+    // still runnable, it's queued again by FinishSwitch once it's registers are saved,
+    // otherwise another cpu could steal it before that
+    if(runnable){
+        previous->state = THREAD_READY;
+    }
+
+    // idle thread can be switched away from while halted, cpu isn't idle anymore
+    if(previous == queue.idle){
+        ExitIdle();
+        Idle::Exit();
+    }
+
+    next->state = THREAD_RUNNING;
+    next->switches++;
+    queue.switches++;
+    queue.sliceEnd = Clock::NowNs() + SCHED_TIME_SLICE_NS;
+
+    PER_CPU(currentThread)::Write(next);
+    PER_CPU(previousThread)::Write(previous);
+    SwitchContext(&previous->rsp, next->rsp);
+
+    // we are back, running as previous again
+    FinishSwitch();
+}
+
+// previous thread can be queued again, or freed if it exited, only once we are off it's stack
+// idle thread is never queued, it runs when there's nothing else
+// timer is armed for whatever new thread needs
+void Scheduler::FinishSwitch(){
+    Thread* previous = PER_CPU(previousThread)::Exchange(nullptr);
+    if(previous == nullptr){
+        return;
+    }
+
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    if(previous->state == THREAD_DEAD){
+        __atomic_store_n(&previous->state, THREAD_FREE, __ATOMIC_RELEASE);
+    }else if((previous->state == THREAD_READY) && (previous != queue.idle)){
+        Enqueue(queue, previous);
+    }
+
+    UpdateTimer(queue);
+}
+
+// give up rest of time slice
+void Scheduler::Yield(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    runQueues[GetCurrentCpuIndex()].yields++;
+    Schedule();
+    RestoreInterrupts(rflags);
+}
+
+// sleep timer runs in softirq on cpu thread slept on
+void Scheduler::WakeSleeper(void* context){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    MakeReady(static_cast<Thread*>(context));
+    RestoreInterrupts(rflags);
+}
+
+// blocked threads are woken up by their own cpu, so interrupts disabled are enough
+void Scheduler::Wake(Thread* thread){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    if(thread->state == THREAD_BLOCKED){
+        MakeReady(thread);
+    }
+    RestoreInterrupts(rflags);
+}
+
+// queue woken up thread
+void Scheduler::MakeReady(Thread* thread){
+    size_t cpu = GetCurrentCpuIndex();
+    RunQueue& queue = runQueues[cpu];
+    bool idle = GetCurrentThread() == queue.idle;
+
+    thread->cpu = cpu;
+    Enqueue(queue, thread);
+
+    // switch happens on interrupt exit or in idle loop
+    if(idle || (Clock::NowNs() >= queue.sliceEnd)){
+        PER_CPU(needResched)::Write(true);
+    }
+
+    // more woke up than this cpu will run next
+    if(queue.numReady > (idle ? 1 : 0)){
+        KickIdleCpu();
+    }
+
+    UpdateTimer(queue);
+}
+
+// wait for sleep timer to wake us up
+void Scheduler::Sleep(uint64_t ns){
+    uint64_t wakeupTime = Clock::NowNs() + ns;
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    Thread* current = GetCurrentThread();
+
+    // idle thread must always be runnable, without a timer nobody would wake us up
+    if(!queue.hasTimer || (current == queue.idle)){
+        RestoreInterrupts(rflags);
+        while(Clock::NowNs() < wakeupTime){
+            Yield();
+        }
+        return;
+    }
+
+    // timer can't run before we switch away, interrupts stay disabled till then
+    current->state = THREAD_SLEEPING;
+    TimerWheel::Add(&current->sleepTimer, ns, WakeSleeper, current);
+
+    Schedule();
+    RestoreInterrupts(rflags);
+}
+
+// switch away until woken up
+void Scheduler::Block(){
+    GetCurrentThread()->state = THREAD_BLOCKED;
+    Schedule();
+}
+
+// never returns, slot is freed by thread that runs next
+void Scheduler::Exit(){
+    asm volatile("cli" ::: "memory");
+    GetCurrentThread()->state = THREAD_DEAD;
+    Schedule();
+    __builtin_unreachable();
+}
+
+// anything to run
+bool Scheduler::HasReadyThreads(){
+    return runQueues[GetCurrentCpuIndex()].numReady != 0;
+}
+
+// tick on every cpu, only touches this cpu's queue
+bool Scheduler::TimerHandler(InterruptContext* frame, void* context){
+    (void)frame;
+    (void)context;
+
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+    queue.timerInterrupts++;
+    // one shot, nothing is armed anymore
+    queue.timerDeadline = 0;
+
+    uint64_t now = Clock::NowNs();
+    bool idle = GetCurrentThread() == queue.idle;
+
+
+    // switch happens on interrupt exit, we are still on irq stack here
+    if((queue.numReady != 0) && ((now >= queue.sliceEnd) || idle)){
+        PER_CPU(needResched)::Write(true);
+    }
+
+    // expired timers (sleepers among them) are run in softirq on interrupt exit,
+    // it arms timer once it's done, wheel would look due until then
+    if(!TimerWheel::OnTimerInterrupt(now)){
+        UpdateTimer(queue);
+    }
+    return true;
+}
+
+// interrupt exit
+void Scheduler::PreemptIfNeeded(){
+    if(!PER_CPU(needResched)::Read()){
+        return;
+    }
+
+    // preemption disabled, or softirqs were interrupted and must finish first
+    if((PER_CPU(preemptCount)::Read() != 0) || PER_CPU(softirqRunning)::Read()){
+        return;
+    }
+
+    runQueues[GetCurrentCpuIndex()].preemptions++;
+    Schedule();
+}
+
+// names of thread states
+static const char* threadStateNames[] = {
+    "free", "ready", "running", "sleeping", "blocked", "dead"
+};
+
+// per cpu counters and threads
+void Scheduler::ShowStatistics(){
+    Printf("[+] Scheduler Statistics :\n");
+    uint64_t now = Clock::NowNs();
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        if(!IsCpuOnline(cpu)){
+            continue;
+        }
+
+        const RunQueue& queue = runQueues[cpu];
+        uint64_t periodic = (now - queue.startTime) / (NS_PER_SECOND / SCHED_PERIODIC_TICK_HZ);
+        Printf("\tCPU %lu (package %u, node %u) : %lu switches, %lu preemptions, %lu yields, %lu ready\n",
+               cpu, Topology::Get(cpu).package, Topology::Get(cpu).node,
+               queue.switches, queue.preemptions, queue.yields, queue.numReady);
+        Printf("\t\t%lu timer interrupts, %lu avoided compared to %u Hz tick\n",
+               queue.timerInterrupts, (periodic > queue.timerInterrupts) ? (periodic - queue.timerInterrupts) : 0,
+               SCHED_PERIODIC_TICK_HZ);
+        Printf("\t\t%lu steal attempts, %lu threads migrated in, %lu migrated out\n",
+               queue.stealAttempts, queue.migrationsIn, queue.migrationsOut);
+    }
+
+    for(size_t i = 0; i < SCHED_MAX_THREADS; i++){
+        const Thread& thread = threads[i];
+        if(thread.state == THREAD_FREE){
+            continue;
+        }
+
+        Printf("\t%s (id %lu, cpu %lu) : %s, switched to %lu times\n", thread.name, thread.id, thread.cpu,
+               threadStateNames[thread.state], thread.switches);
+    }
+}
+
+// benchmark threads just yield to each other
+static volatile uint64_t benchmarkThreadsRunning = 0;
+
+static void BenchmarkThreadMain(void* argument){
+    (void)argument;
+    for(uint64_t i = 0; i < SCHED_BENCHMARK_ITERATIONS; i++){
+        Scheduler::Yield();
+    }
+    __atomic_fetch_sub(&benchmarkThreadsRunning, 1, __ATOMIC_RELEASE);
+}
+
+// keeps a cpu busy without ever yielding
+static volatile bool benchmarkSpin = false;
+
+static void SpinThreadMain(void* argument){
+    (void)argument;
+    while(benchmarkSpin){
+        asm volatile("pause");
+    }
+    __atomic_fetch_sub(&benchmarkThreadsRunning, 1, __ATOMIC_RELEASE);
+}
+
+// busy wait without yielding
+static void Spin(uint64_t ns){
+    uint64_t end = Clock::NowNs() + ns;
+    while(Clock::NowNs() < end){
+        asm volatile("pause");
+    }
+}
+
+// compare with what a periodic tick would've taken on all cpus
+static void ReportTicklessPhase(const char* name, uint64_t interrupts){
+    uint64_t periodic = GetNumOnlineCpus() * SCHED_PERIODIC_TICK_HZ * (SCHED_TICKLESS_BENCHMARK_NS / 1000000) / 1000;
+    Printf("[+] Tickless, %s : %lu timer interrupts on %lu cpus, %u Hz periodic tick would take %lu\n",
+           name, interrupts, GetNumOnlineCpus(), SCHED_PERIODIC_TICK_HZ, periodic);
+}
+
+// sum over all cpus, counters are only read
+uint64_t Scheduler::CountTimerInterrupts(){
+    uint64_t total = 0;
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        total += __atomic_load_n(&runQueues[cpu].timerInterrupts, __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+// two threads and caller yield round robin, each yield is one switch
+// then timer interrupts are counted while everything is idle, while caller spins
+// alone on this cpu and while it shares this cpu with another spinning thread
+void Scheduler::Benchmark(){
+    RunQueue& queue = runQueues[GetCurrentCpuIndex()];
+
+    benchmarkThreadsRunning = 2;
+    // pinned, otherwise idle cpus would take them away
+    if((CreateThread("bench0", BenchmarkThreadMain, nullptr, true) == nullptr) ||
+       (CreateThread("bench1", BenchmarkThreadMain, nullptr, true) == nullptr)){
+        return;
+    }
+
+    uint64_t switches = queue.switches;
+    uint64_t start = ReadTSC();
+    while(__atomic_load_n(&benchmarkThreadsRunning, __ATOMIC_ACQUIRE) != 0){
+        Yield();
+    }
+    uint64_t cycles = ReadTSC() - start;
+    switches = queue.switches - switches;
+
+    uint64_t perSwitch = cycles / (switches ? switches : 1);
+    Printf("[+] Context switch benchmark : %lu switches, %lu cycles (%lu ns) per switch\n",
+           switches, perSwitch, Clock::CyclesToNs(perSwitch));
+
+    if(!queue.hasTimer){
+        return;
+    }
+
+    uint64_t before = CountTimerInterrupts();
+    Sleep(SCHED_TICKLESS_BENCHMARK_NS);
+    ReportTicklessPhase("all cpus idle", CountTimerInterrupts() - before);
+
+    before = CountTimerInterrupts();
+    Spin(SCHED_TICKLESS_BENCHMARK_NS);
+    ReportTicklessPhase("one busy thread", CountTimerInterrupts() - before);
+
+    benchmarkSpin = true;
+    benchmarkThreadsRunning = 1;
+    if(CreateThread("spin", SpinThreadMain, nullptr, true) == nullptr){
+        return;
+    }
+
+    before = CountTimerInterrupts();
+    Spin(SCHED_TICKLESS_BENCHMARK_NS);
+    ReportTicklessPhase("two busy threads on one cpu", CountTimerInterrupts() - before);
+
+    benchmarkSpin = false;
+    while(__atomic_load_n(&benchmarkThreadsRunning, __ATOMIC_ACQUIRE) != 0){
+        Yield();
+    }
+}
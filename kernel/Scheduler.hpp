@@ -0,0 +1,253 @@
+/**
+ *@file Scheduler.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Preemptive kernel threads with per cpu run queues
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Constants.hpp"
+#include "PerCpu.hpp"
+#include "SpinLock.hpp"
+#include "TimerWheel.hpp"
+
+// max number of threads alive at once (all cpus combined)
+#define SCHED_MAX_THREADS 256
+// stack of each kernel thread
+#define SCHED_THREAD_STACK_SIZE (16*KB)
+// how long a thread runs before it's preempted (if something else is ready)
+#define SCHED_TIME_SLICE_NS uint64_t(10000000)
+// a cpu running a single thread only gets a timer interrupt this often
+#define SCHED_SINGLE_TASK_TICK_NS uint64_t(1000000000)
+// rate of a conventional periodic tick, tickless statistics are compared against it
+#define SCHED_PERIODIC_TICK_HZ 250
+// number of yields in context switch benchmark
+#define SCHED_BENCHMARK_ITERATIONS 10000
+// length of each phase of tickless benchmark
+#define SCHED_TICKLESS_BENCHMARK_NS uint64_t(1000000000)
+
+struct InterruptContext;
+
+// thread entry point
+typedef void (*ThreadFunction)(void* argument);
+
+enum ThreadState : uint8_t {
+    THREAD_FREE = 0, // slot can be reused
+    THREAD_READY, // in a run queue
+    THREAD_RUNNING,
+    THREAD_SLEEPING, // waiting for sleep timer
+    THREAD_BLOCKED, // waiting for Wake
+    THREAD_DEAD // exited, slot is freed after switching away from it
+};
+
+struct Thread {
+    uint64_t rsp; // saved stack pointer, callee saved registers are on stack
+    uint64_t stackTop; // 0 if thread runs on a stack it didn't allocate (boot/idle)
+    ThreadState state;
+    size_t cpu; // cpu whose run queue this is in
+    bool pinned; // never moved to another cpu
+    uint64_t id;
+    const char* name;
+    ThreadFunction function;
+    void* argument;
+    Timer sleepTimer; // wakes thread up, in timer wheel of cpu it slept on
+    uint64_t switches; // number of times this was switched to
+    Thread* next; // run queue link
+};
+
+// Kernel threads are scheduled round robin from per cpu run queues.
+// Context switch saves callee saved registers on thread's stack and swaps stack pointer,
+// rest of the registers are already saved by caller (or by interrupt entry code).
+// There's no periodic tick. Timer of each cpu is armed (see ClockEvent.hpp) only for
+// the next thing that needs it : end of time slice if other threads are waiting,
+// earliest timer (see TimerWheel.hpp), or once a second if a single thread is running.
+// An idle cpu with no timers gets no timer interrupts at all. When time slice of current thread is
+// used up it's preempted on interrupt exit, once we are back on the thread's own stack.
+// Threads can also yield, sleep, block until woken up or exit.
+//
+// Every cpu has an idle thread that runs when run queue is empty, it's never queued.
+// On boot cpu code that called Initialize becomes "init" thread and idle thread is created,
+// on other cpus code that called InitializeCpu becomes idle thread.
+// Threads start on cpu they were created on. A cpu that runs out of work steals
+// a ready thread from another cpu's run queue, trying cpus that share more caches
+// first (see Topology.hpp). Idle cpus sleep (see Idle.hpp), so a cpu that has
+// more work than it can run wakes up the nearest idle one. Each run queue has a lock that's held only for a single
+// queue operation, stealers just try the lock and move on if it's busy.
+// Sleeping threads are in no queue, their sleep timer queues them again on cpu they slept on.
+struct Scheduler {
+    // setup boot cpu, caller becomes init thread
+    static void Initialize();
+
+    // setup an application processor, caller becomes idle thread of this cpu
+    static void InitializeCpu();
+
+    // create a thread in run queue of this cpu, pinned threads are never stolen
+    // returns nullptr if there are no free thread slots
+    static Thread* CreateThread(const char* name, ThreadFunction function, void* argument, bool pinned = false);
+
+    // let other ready threads run
+    static void Yield();
+
+    // sleep for at least given number of nanoseconds
+    static void Sleep(uint64_t ns);
+
+    // wait until Wake is called on this thread, not allowed on idle thread
+    // interrupts must be disabled, so that condition checked before can't be missed
+    static void Block();
+
+    // queue a blocked thread on this cpu, does nothing if it isn't blocked
+    // must be called on cpu thread blocked on (pinned threads are woken by their own cpu)
+    static void Wake(Thread* thread);
+
+    // end current thread
+    [[noreturn]] static void Exit();
+
+    // thread running on this cpu
+    static Thread* GetCurrentThread(){ return PER_CPU(currentThread)::Read(); }
+
+    // is there something other than idle thread to run on this cpu
+    static bool HasReadyThreads();
+
+    // move a ready thread from another cpu to this one, nearest cpus are tried first
+    // interrupts must be disabled, returns true if something was stolen
+    static bool StealWork();
+
+    // what timer of this cpu is armed for (see Clock::NowNs), 0 if it's stopped
+    static uint64_t GetTimerDeadline(){ return runQueues[GetCurrentCpuIndex()].timerDeadline; }
+
+    // arm timer of this cpu again after timer wheel changed, interrupts must be disabled
+    static void RearmTimer(){ UpdateTimer(runQueues[GetCurrentCpuIndex()]); }
+
+    // called from interrupt exit with interrupts disabled, once back on thread's stack
+    static void PreemptIfNeeded();
+
+    // done by a thread right after it's switched to, frees previous thread if it exited
+    static void FinishSwitch();
+
+    // current thread can't be preempted until EnablePreemption is called, can be nested
+    // interrupts are still taken, only switch on their exit is delayed
+    static void DisablePreemption(){ PER_CPU(preemptCount)::Add(1); }
+    static void EnablePreemption(){ PER_CPU(preemptCount)::Add(uint32_t(-1)); }
+
+    // mark this cpu idle/busy, idle cpus are woken up with an ipi when there's work
+    static void EnterIdle();
+    static void ExitIdle();
+
+    // show per cpu counters and thread list
+    static void ShowStatistics();
+
+    // measure cost of a yield between two threads on this cpu and count timer
+    // interrupts taken with idle cpus, one busy thread and two busy threads
+    static void Benchmark();
+
+private:
+    struct RunQueue {
+        SpinLock lock; // protects ready list only
+        Thread* head;
+        Thread* tail;
+        size_t numReady;
+        Thread* idle;
+        uint64_t sliceEnd; // when current thread's time slice ends
+        uint64_t timerDeadline; // what timer is armed for, 0 if it's stopped
+        bool hasTimer; // without a timer there's no preemption and sleep is a yield loop
+        // statistics
+        uint64_t timerInterrupts;
+        uint64_t startTime; // when statistics started, to compare with a periodic tick
+        uint64_t switches;
+        uint64_t preemptions;
+        uint64_t yields;
+        uint64_t stealAttempts;
+        uint64_t migrationsIn; // threads stolen by this cpu
+        uint64_t migrationsOut; // threads stolen from this cpu
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    // take a free slot and fill it, thread is not queued
+    static Thread* NewThread(const char* name, ThreadFunction function, void* argument);
+
+    // allocate stack if slot doesn't have one yet and build first frame
+    // so that switching to thread starts it's function
+    static void SetupStack(Thread* thread);
+
+    // make code running on this cpu a thread
+    static Thread* AdoptCurrentContext(const char* name, bool idle);
+
+    // setup timer of this cpu, does nothing if there's no apic
+    static void StartTimer();
+
+    // arm timer of this cpu for next event, or stop it if nothing needs it
+    // interrupts must be disabled
+    static void UpdateTimer(RunQueue& queue);
+
+    // queue has more than this cpu can run right now, wake up an idle cpu to steal it
+    static void KickIdleCpu();
+
+    // run queue operations, interrupts must be disabled
+    static void Enqueue(RunQueue& queue, Thread* thread);
+    static Thread* Dequeue(RunQueue& queue);
+
+    // take first thread that isn't pinned, returns nullptr if lock is busy
+    static Thread* DequeueForSteal(RunQueue& queue);
+
+    // find a thread on another cpu and make it ours, it's not queued
+    static Thread* Steal();
+
+    // pick next thread and switch to it, interrupts must be disabled
+    // current thread is queued again if it's still running
+    static void Schedule();
+
+    // sleep timer expired, queue thread on this cpu
+    static void WakeSleeper(void* context);
+
+    // queue a thread that wasn't runnable on this cpu, interrupts must be disabled
+    static void MakeReady(Thread* thread);
+
+    // timer interrupt
+    static bool TimerHandler(InterruptContext* frame, void* context);
+
+    // reschedule ipi, idle loop does the rest
+    static bool RescheduleHandler(InterruptContext* frame, void* context);
+
+    // count timer interrupts on all cpus while running a benchmark phase
+    static uint64_t CountTimerInterrupts();
+
+    static inline Thread threads[SCHED_MAX_THREADS] = {};
+    static inline RunQueue runQueues[MAX_CPUS] = {};
+    static inline uint64_t nextThreadID = 0;
+    // bit n is set while cpu n is halted in idle loop
+    static inline uint64_t idleCpuMask = 0;
+};
+
+#endif // SCHEDULER_HPP
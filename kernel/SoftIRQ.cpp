@@ -0,0 +1,177 @@
+/**
+ *@file SoftIRQ.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Deferred interrupt work (bottom halves)
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SoftIRQ.hpp"
+#include "CPU.hpp"
+#include "Printf.hpp"
+#include "SMP.hpp"
+#include "Scheduler.hpp"
+
+// thread stays on this cpu, it's only woken up from here
+void SoftIRQ::InitializeCpu(){
+    Thread* thread = Scheduler::CreateThread("softirq", ThreadMain, nullptr, true);
+    if(thread == nullptr){
+        Printf("[-] Failed to create softirq thread, leftover work waits for next interrupt\n");
+        return;
+    }
+    threads[GetCurrentCpuIndex()] = thread;
+}
+
+// runs as ordinary thread, so a busy cpu still gets to it at end of time slice
+void SoftIRQ::ThreadMain(void* argument){
+    (void)argument;
+    while(true){
+        // check and block with interrupts disabled, so a wakeup in between isn't lost
+        asm volatile("cli" ::: "memory");
+        if(!HasPending()){
+            Scheduler::Block();
+        }
+        asm volatile("sti" ::: "memory");
+
+        stats[GetCurrentCpuIndex()].threadRuns++;
+        Run();
+
+        // still more, let others run before next pass
+        if(HasPending()){
+            Scheduler::Yield();
+        }
+    }
+}
+
+// set handler
+void SoftIRQ::Register(SoftIrqType type, SoftIrqHandler handler, void* context){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    actions[type].handler = handler;
+    actions[type].context = context;
+    RestoreInterrupts(rflags);
+}
+
+// mark as pending
+void SoftIRQ::Raise(SoftIrqType type){
+    PER_CPU(softirqPending)::Or(uint32_t(1) << type);
+}
+
+// anything to do?
+bool SoftIRQ::HasPending(){
+    return PER_CPU(softirqPending)::Read() != 0;
+}
+
+// budget limited loop
+void SoftIRQ::Run(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+
+    if(PER_CPU(softirqRunning)::Read() || (PER_CPU(softirqDisableCount)::Read() != 0)){
+        RestoreInterrupts(rflags);
+        return;
+    }
+    PER_CPU(softirqRunning)::Write(true);
+    Stats& cpuStats = stats[GetCurrentCpuIndex()];
+
+    for(size_t restart = 0; restart < SOFTIRQ_MAX_RESTARTS; restart++){
+        // take all pending work at once, new work raised while running is seen in next pass
+        uint32_t work = PER_CPU(softirqPending)::Exchange(0);
+        if(work == 0){
+            break;
+        }
+
+        // handlers run with interrupts enabled so that hard irqs aren't delayed
+        asm volatile("sti" ::: "memory");
+        while(work != 0){
+            uint8_t type = uint8_t(__builtin_ctz(work));
+            work &= work - 1;
+
+            if(actions[type].handler == nullptr){
+                continue;
+            }
+
+            uint64_t start = ReadTSC();
+            actions[type].handler(actions[type].context);
+            uint64_t cycles = ReadTSC() - start;
+
+            cpuStats.runCounts[type]++;
+            if(cycles > cpuStats.maxCycles[type]) cpuStats.maxCycles[type] = cycles;
+        }
+        asm volatile("cli" ::: "memory");
+    }
+
+    // budget exhausted, rest is left to thread (does nothing if we are the thread)
+    Thread* thread = threads[GetCurrentCpuIndex()];
+    if((PER_CPU(softirqPending)::Read() != 0) && (thread != nullptr)){
+        cpuStats.numDeferred++;
+        Scheduler::Wake(thread);
+    }
+
+    PER_CPU(softirqRunning)::Write(false);
+    RestoreInterrupts(rflags);
+}
+
+// thread can't move to another cpu while count is held
+void SoftIRQ::DisableLocal(){
+    Scheduler::DisablePreemption();
+    PER_CPU(softirqDisableCount)::Add(1);
+}
+
+void SoftIRQ::EnableLocal(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    PER_CPU(softirqDisableCount)::Add(uint32_t(-1));
+    if((rflags & RFLAGS_INTERRUPT_ENABLE) && (PER_CPU(softirqDisableCount)::Read() == 0) && HasPending()){
+        Run();
+    }
+    RestoreInterrupts(rflags);
+    Scheduler::EnablePreemption();
+}
+
+// print stats
+void SoftIRQ::ShowStatistics(){
+    Printf("[+] SoftIRQ Statistics :\n");
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        if(!IsCpuOnline(cpu)){
+            continue;
+        }
+
+        const Stats& cpuStats = stats[cpu];
+        for(size_t t = 0; t < SOFTIRQ_MAX; t++){
+            if(cpuStats.runCounts[t] == 0){
+                continue;
+            }
+
+            Printf("\tCPU %lu Type %lu : %lu runs, max %lu cycles\n", cpu, t, cpuStats.runCounts[t],
+                   cpuStats.maxCycles[t]);
+        }
+        Printf("\tCPU %lu Deferred to thread : %lu times, thread ran %lu times\n", cpu, cpuStats.numDeferred,
+               cpuStats.threadRuns);
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ *@file SoftIRQ.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Deferred interrupt work (bottom halves)
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SOFTIRQ_HPP
+#define SOFTIRQ_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "PerCpu.hpp"
+
+struct Thread;
+
+// max number of times pending work is rechecked in a single run
+// anything raised after this is left to softirq thread of the cpu
+#define SOFTIRQ_MAX_RESTARTS 10
+
+// types of deferred work, lower number runs first
+enum SoftIrqType : uint8_t {
+    SOFTIRQ_POLL = 0, // polled devices, runs before consumers of their events
+    SOFTIRQ_KEYBOARD = 1,
+    SOFTIRQ_TIMER = 2, // expired timers of timer wheel
+    SOFTIRQ_RCU = 3, // callbacks whose grace period is over
+    SOFTIRQ_MAX = 32
+};
+
+// deferred work handler
+typedef void (*SoftIrqHandler)(void* context);
+
+// Hard interrupt handlers should only acknowledge the device and raise a softirq.
+// Raised softirqs are marked in a per cpu pending bitmap and handlers are run
+// with interrupts enabled when the outermost interrupt exits, or from idle loop.
+// Work that keeps getting raised (polled devices) would otherwise wait for next interrupt
+// on a busy cpu, so once restart budget runs out a pinned per cpu thread is woken up.
+// It drains pending work and gets cpu time like any other thread.
+struct SoftIRQ {
+    // create softirq thread of this cpu, after scheduler is setup on it
+    static void InitializeCpu();
+
+    // set handler for given type
+    static void Register(SoftIrqType type, SoftIrqHandler handler, void* context);
+
+    // mark given type as pending on this cpu, safe to call from interrupt handlers
+    static void Raise(SoftIrqType type);
+
+    // check if this cpu has pending work
+    static bool HasPending();
+
+    // run pending work on this cpu, loops at most SOFTIRQ_MAX_RESTARTS times
+    // and wakes softirq thread if something is still pending after that
+    // interrupts are enabled while handlers run and are restored on return
+    // does nothing if called from within a softirq handler or while softirqs are disabled
+    static void Run();
+
+    // keep softirqs (and other threads) off this cpu until EnableLocal is called, can be nested
+    // for data shared with softirq handlers that doesn't need hard interrupts disabled
+    static void DisableLocal();
+    // work raised meanwhile is run here, if caller has interrupts enabled
+    static void EnableLocal();
+
+    // show number of runs and max time of each type on each cpu
+    static void ShowStatistics();
+
+private:
+    struct Action {
+        SoftIrqHandler handler;
+        void* context;
+    };
+
+    static inline Action actions[SOFTIRQ_MAX] = {};
+
+    // thread of each cpu, nullptr until InitializeCpu
+    static inline Thread* threads[MAX_CPUS] = {};
+
+    // drains pending work of it's cpu, blocks when there's none
+    static void ThreadMain(void* argument);
+
+    // pending bitmap (one bit for each type) and a flag that stops nested runs
+    // are kept in per cpu data (see PerCpu.hpp)
+
+    // statistics, each cpu only writes it's own
+    struct Stats {
+        uint64_t runCounts[SOFTIRQ_MAX];
+        uint64_t maxCycles[SOFTIRQ_MAX];
+        uint64_t numDeferred; // times budget ran out and thread was woken up
+        uint64_t threadRuns;
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    static inline Stats stats[MAX_CPUS] = {};
+};
+
+#endif // SOFTIRQ_HPP
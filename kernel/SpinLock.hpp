@@ -0,0 +1,116 @@
+/**
+ *@file SpinLock.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Spin locks for data shared between cpus
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SPINLOCK_HPP
+#define SPINLOCK_HPP
+
+#include <cstdint>
+#include "CPU.hpp"
+#include "LockStats.hpp"
+
+// Test and test-and-set lock. Waiters spin on a plain load so the line
+// stays shared until the lock is released, and only then try to take it.
+// Cheapest lock when uncontended, but unfair : a cpu that just released it
+// often takes it again. Use TicketLock (fair) or MCSLock (each waiter spins
+// on it's own line) for locks many cpus fight over.
+// Lock/Unlock don't touch interrupts, data shared with interrupt handlers
+// must be locked with LockIrqSave/UnlockIrqRestore.
+// Zero initialized lock is unlocked, so these can be static without constructors.
+struct SpinLock {
+    bool locked;
+#ifdef ENABLE_LOCK_DEBUG
+    LockStats stats;
+#endif
+
+    void Lock(){
+#ifdef ENABLE_LOCK_DEBUG
+        uint64_t start = ReadTSC();
+#endif
+        bool contended = false;
+        while(__atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE)){
+            contended = true;
+            while(__atomic_load_n(&locked, __ATOMIC_RELAXED)){
+                asm volatile("pause");
+            }
+        }
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Acquired(start, contended);
+#else
+        (void)contended;
+#endif
+    }
+
+    // single attempt, returns true if lock was taken
+    bool TryLock(){
+        if(__atomic_load_n(&locked, __ATOMIC_RELAXED) || __atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE)){
+            return false;
+        }
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Acquired(ReadTSC(), false);
+#endif
+        return true;
+    }
+
+    void Unlock(){
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Released();
+#endif
+        __atomic_store_n(&locked, false, __ATOMIC_RELEASE);
+    }
+
+    // disable interrupts on this cpu before locking, returns rflags to restore
+    uint64_t LockIrqSave(){
+        uint64_t rflags = SaveAndDisableInterrupts();
+        Lock();
+        return rflags;
+    }
+
+    void UnlockIrqRestore(uint64_t rflags){
+        Unlock();
+        RestoreInterrupts(rflags);
+    }
+
+    // name shown in lock statistics, does nothing without ENABLE_LOCK_DEBUG
+    void SetName(const char* name){
+#ifdef ENABLE_LOCK_DEBUG
+        stats.name = name;
+#else
+        (void)name;
+#endif
+    }
+};
+
+#endif // SPINLOCK_HPP
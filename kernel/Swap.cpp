@@ -0,0 +1,420 @@
+/**
+ *@file Swap.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Swapping out cold anonymous pages and bringing them back on fault
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Swap.hpp"
+#include "CompressedSwap.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "Interrupts.hpp"
+#include "Printf.hpp"
+#include "CPU.hpp"
+#include "Utils/String.hpp"
+#include "SamePageMerging.hpp"
+#include "Scheduler.hpp"
+#include "PerCpu.hpp"
+#include "Tlb.hpp"
+
+// number of virtual addresses in a single page of tracked pages array
+#define TRACKED_PAGES_PER_CHUNK (PAGE_SIZE / sizeof(uint64_t))
+
+// shootdowns must still be answered while waiting, holder may be doing one
+uint64_t Swap::Lock(){
+    uint64_t rflags = Tlb::LockIrqSave(lock);
+    lockOwner = GetCurrentCpuIndex();
+    return rflags;
+}
+
+void Swap::Unlock(uint64_t rflags){
+    lockOwner = SIZE_MAX;
+    lock.UnlockIrqRestore(rflags);
+}
+
+// add page to list of reclaimable pages
+void Swap::TrackPage(uint64_t vaddr){
+    uint64_t rflags = Lock();
+    if(numTrackedPages >= SWAP_MAX_TRACKED_PAGES){
+        Unlock(rflags);
+        Printf("[!] Cannot track more than %lu anonymous pages\n", SWAP_MAX_TRACKED_PAGES);
+        return;
+    }
+
+    // first level is allocated on first use
+    if(trackedPages == nullptr){
+        trackedPages = reinterpret_cast<uint64_t**>(PhysicalMemoryManager::AllocatePage());
+        memset(trackedPages, 0, PAGE_SIZE);
+    }
+
+    uint64_t chunk = numTrackedPages / TRACKED_PAGES_PER_CHUNK;
+    if(trackedPages[chunk] == nullptr){
+        trackedPages[chunk] = reinterpret_cast<uint64_t*>(PhysicalMemoryManager::AllocatePage());
+    }
+
+    trackedPages[chunk][numTrackedPages % TRACKED_PAGES_PER_CHUNK] = vaddr;
+    numTrackedPages++;
+    Unlock(rflags);
+}
+
+// get number of tracked pages, lock must be held to look at them
+uint64_t Swap::GetNumTrackedPages(){
+    return numTrackedPages;
+}
+
+// get tracked page at given index
+uint64_t Swap::GetTrackedPage(uint64_t idx){
+    return trackedPages[idx / TRACKED_PAGES_PER_CHUNK][idx % TRACKED_PAGES_PER_CHUNK];
+}
+
+// write pending cluster to swap device
+uint64_t Swap::FlushCluster(){
+    if(clusterSize == 0){
+        return 0;
+    }
+
+    size_t n = clusterSize;
+    clusterSize = 0;
+
+    uint64_t slot = SwapDevice::AllocateSlots(n);
+    if(slot != SWAP_SLOT_INVALID && !SwapDevice::WriteSlots(slot, clusterFrames, n)){
+        Printf("[-] Failed to write %lu pages to swap device\n", n);
+        for(size_t i = 0; i < n; i++) SwapDevice::FreeSlot(slot + i);
+        slot = SWAP_SLOT_INVALID;
+    }
+
+    // no space in swap, map the pages back
+    if(slot == SWAP_SLOT_INVALID){
+        for(size_t i = 0; i < n; i++){
+            GetDefaultVirtualMemoryManager().GetPage(clusterPages[i], false)->value = clusterOldValues[i];
+        }
+        return 0;
+    }
+
+    for(size_t i = 0; i < n; i++){
+        Page* page = GetDefaultVirtualMemoryManager().GetPage(clusterPages[i], false);
+        page->SetSwapEntry(MakeSwapEntry(SWAP_TYPE_DEVICE, slot + i));
+        SwapDevice::SetOwner(slot + i, clusterPages[i]);
+        PhysicalMemoryManager::FreePage(clusterFrames[i]);
+    }
+
+    numSwapOuts += n;
+    numClusterWrites++;
+    return n;
+}
+
+// swap out given page if it's cold
+uint64_t Swap::SwapOutPage(uint64_t vaddr){
+    Page* page = GetDefaultVirtualMemoryManager().GetPage(vaddr, false);
+    if(page == nullptr || !page->GetFlags(MAP_PRESENT)){
+        return 0;
+    }
+
+    // shared frames (zero page, merged pages) can't be freed by a single user
+    if(page->GetFlags(MAP_COPY_ON_WRITE)){
+        return 0;
+    }
+
+    // recently used page gets a second chance
+    if(page->GetFlags(MAP_ACCESSED)){
+        page->UnsetFlags(MAP_ACCESSED);
+        InvalidatePage(vaddr);
+        return 0;
+    }
+
+    // unmap page before compressing it so that nobody
+    // modifies it while it's being stored, other cpus may still have it in their tlb
+    uint64_t oldValue = page->value;
+    uint64_t frame = (page->GetAddress() << 12) + MEM_PHYS_OFFSET;
+    page->UnsetFlags(MAP_PRESENT);
+    Tlb::Shootdown(vaddr);
+
+    uint64_t offset;
+    if(CompressedSwap::Store(frame, offset)){
+        page->SetSwapEntry(MakeSwapEntry(SWAP_TYPE_COMPRESSED, offset));
+        PhysicalMemoryManager::FreePage(frame);
+        numSwapOuts++;
+        return 1;
+    }
+
+    if(!SwapDevice::IsAvailable()){
+        page->value = oldValue;
+        return 0;
+    }
+
+    // only virtually adjacent pages go in same cluster
+    uint64_t freed = 0;
+    if((clusterSize > 0) && (clusterPages[clusterSize - 1] + PAGE_SIZE != vaddr)){
+        freed += FlushCluster();
+    }
+
+    clusterPages[clusterSize] = vaddr;
+    clusterFrames[clusterSize] = frame;
+    clusterOldValues[clusterSize] = oldValue;
+    clusterSize++;
+
+    if(clusterSize == SWAP_CLUSTER_SIZE){
+        freed += FlushCluster();
+    }
+
+    return freed;
+}
+
+// reclaim atmost count pages
+uint64_t Swap::ReclaimPages(uint64_t count){
+    // owner can only be this cpu if we are called from inside locked code on this cpu
+    if((numTrackedPages == 0) || (__atomic_load_n(&lockOwner, __ATOMIC_RELAXED) == GetCurrentCpuIndex())){
+        return 0;
+    }
+
+    uint64_t rflags = Lock();
+
+    // in worst case, hand has to go over all pages twice
+    // first time to clear the accessed bits and second time to swap them out
+    uint64_t reclaimed = 0;
+    for(uint64_t scanned = 0; (scanned < 2 * numTrackedPages) && (reclaimed + clusterSize < count); scanned++){
+        uint64_t vaddr = GetTrackedPage(clockHand);
+        clockHand = (clockHand + 1) % numTrackedPages;
+
+        reclaimed += SwapOutPage(vaddr);
+    }
+
+    // write whatever is left in cluster
+    reclaimed += FlushCluster();
+
+    Unlock(rflags);
+    return reclaimed;
+}
+
+// read slot and it's neighbours
+bool Swap::SwapInFromDevice(uint64_t slot, uint64_t frame){
+    if(scratchPage == 0){
+        scratchPage = PhysicalMemoryManager::AllocatePage();
+    }
+
+    // read whole cluster aligned window around the slot
+    uint64_t start = slot & ~uint64_t(SWAP_CLUSTER_SIZE - 1);
+    size_t n = SWAP_CLUSTER_SIZE;
+    if(start + n > SwapDevice::GetNumSlots()){
+        n = SwapDevice::GetNumSlots() - start;
+    }
+
+    uint64_t frames[SWAP_CLUSTER_SIZE];
+    for(size_t i = 0; i < n; i++){
+        if(start + i == slot){
+            frames[i] = frame;
+        }else if(SwapDevice::IsSlotUsed(start + i)){
+            frames[i] = PhysicalMemoryManager::AllocatePage();
+        }else{
+            frames[i] = scratchPage;
+        }
+    }
+
+    bool loaded = SwapDevice::ReadSlots(start, frames, n);
+
+    // map neighbours that are still swapped out in the same slot
+    for(size_t i = 0; i < n; i++){
+        if((start + i == slot) || (frames[i] == scratchPage)){
+            continue;
+        }
+
+        uint64_t owner = SwapDevice::GetOwner(start + i);
+        Page* page = GetDefaultVirtualMemoryManager().GetPage(owner, false);
+        if(loaded && (page != nullptr) && page->IsSwapped() &&
+           (page->GetSwapEntry() == MakeSwapEntry(SWAP_TYPE_DEVICE, start + i))){
+            page->ClearSwapEntry();
+            page->SetAddress((frames[i] - MEM_PHYS_OFFSET) >> 12);
+            page->SetFlags(MAP_PRESENT);
+            SwapDevice::FreeSlot(start + i);
+            numReadAheadPages++;
+            numSwapIns++;
+        }else{
+            PhysicalMemoryManager::FreePage(frames[i]);
+        }
+    }
+
+    if(loaded){
+        SwapDevice::FreeSlot(slot);
+    }
+
+    return loaded;
+}
+
+// bring a swapped out page back
+bool Swap::HandlePageFault(uint64_t vaddr, uint64_t errorcode){
+    // page was present, this is a protection violation
+    if(errorcode & PAGE_FAULT_PRESENT){
+        return false;
+    }
+
+    vaddr &= ~(PAGE_SIZE - 1);
+    Page* page = GetDefaultVirtualMemoryManager().GetPage(vaddr, false);
+    // nothing was ever mapped here
+    if((page == nullptr) || (page->value == 0)){
+        return false;
+    }
+
+    uint64_t start = ReadTSC();
+
+    // allocation may have to reclaim, so it's done before taking the lock
+    uint64_t frame = PhysicalMemoryManager::AllocatePage();
+    uint64_t rflags = Lock();
+
+    // another cpu brought it back (or it was in a cluster that couldn't be written)
+    // while we were waiting, retrying the access is enough
+    if(!page->IsSwapped()){
+        bool present = page->GetFlags(MAP_PRESENT);
+        Unlock(rflags);
+        PhysicalMemoryManager::FreePage(frame);
+        return present;
+    }
+
+    uint64_t entry = page->GetSwapEntry();
+
+    bool loaded = false;
+    switch(GetSwapEntryType(entry)){
+    case SWAP_TYPE_COMPRESSED:
+        loaded = CompressedSwap::Load(GetSwapEntryOffset(entry), frame);
+        if(loaded) CompressedSwap::Free(GetSwapEntryOffset(entry));
+        break;
+    case SWAP_TYPE_DEVICE:
+        loaded = SwapInFromDevice(GetSwapEntryOffset(entry), frame);
+        break;
+    }
+
+    if(!loaded){
+        Unlock(rflags);
+        Printf("[-] Failed to swap in page at vaddr(%lx), swap entry = %lx\n", vaddr, entry);
+        PhysicalMemoryManager::FreePage(frame);
+        return false;
+    }
+
+    // map it back with the same flags it had before
+    page->ClearSwapEntry();
+    page->SetAddress((frame - MEM_PHYS_OFFSET) >> 12);
+    page->SetFlags(MAP_PRESENT);
+
+    uint64_t cycles = ReadTSC() - start;
+    swapInCycles += cycles;
+    if(cycles > maxSwapInCycles) maxSwapInCycles = cycles;
+    numSwapIns++;
+
+    Unlock(rflags);
+    return true;
+}
+
+// contents of given word of given self test page
+// every 4th page is zero, then one with same contents in all such pages,
+// one that compresses well and one that doesn't (only swap device takes these)
+static uint64_t GetSelfTestWord(uint64_t page, uint64_t word){
+    switch(page % 4){
+    case 0:
+        return 0;
+    case 1:
+        return 0x5a5a5a5a5a5a5a5a ^ word;
+    case 2:
+        return page;
+    default:{
+        // xorshift, seeded by position
+        uint64_t x = (page * (PAGE_SIZE / sizeof(uint64_t)) + word + 1) * 0x9e3779b97f4a7c15;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+    }
+}
+
+// dirty anonymous pages, swap them out and check them after they come back
+void Swap::SelfTest(void* argument){
+    (void)argument;
+    const uint64_t wordsPerPage = PAGE_SIZE / sizeof(uint64_t);
+
+    GetDefaultVirtualMemoryManager().AllocateAnonymousMemory(ANONYMOUS_MEMORY_BASE, SWAP_SELFTEST_PAGES * PAGE_SIZE,
+                                                             MAP_READ_WRITE);
+
+    // first write to each page breaks sharing with zero page
+    for(uint64_t p = 0; p < SWAP_SELFTEST_PAGES; p++){
+        uint64_t* words = reinterpret_cast<uint64_t*>(ANONYMOUS_MEMORY_BASE + p * PAGE_SIZE);
+        for(uint64_t w = 0; w < wordsPerPage; w++){
+            words[w] = GetSelfTestWord(p, w);
+        }
+    }
+
+    // let merging scanner go over whole region a couple of times, zero and duplicate
+    // pages end up sharing frames which stay in memory
+    uint64_t scanRate = SamePageMerging::SetScanRate(SWAP_SELFTEST_PAGES);
+    Scheduler::Sleep(2 * SPM_SCAN_INTERVAL_NS);
+    SamePageMerging::SetScanRate(scanRate);
+
+    // every page was just written, so clock hand needs a second round to swap them out
+    uint64_t swapIns = numSwapIns;
+    uint64_t swappedOut = ReclaimPages(SWAP_SELFTEST_PAGES);
+
+    // swapped out pages are brought back by page fault handler
+    uint64_t bad = 0;
+    for(uint64_t p = 0; p < SWAP_SELFTEST_PAGES; p++){
+        const uint64_t* words = reinterpret_cast<const uint64_t*>(ANONYMOUS_MEMORY_BASE + p * PAGE_SIZE);
+        for(uint64_t w = 0; w < wordsPerPage; w++){
+            if(words[w] != GetSelfTestWord(p, w)){
+                bad++;
+                break;
+            }
+        }
+    }
+
+    if(bad){
+        Printf("[-] Swap self test : %lu of %lu pages came back corrupted\n", bad, SWAP_SELFTEST_PAGES);
+    }else{
+        Printf("[+] Swap self test : %lu pages swapped out, %lu swapped in, all %lu pages intact\n",
+               swappedOut, numSwapIns - swapIns, SWAP_SELFTEST_PAGES);
+    }
+}
+
+// print swap statistics
+void Swap::ShowStatistics(){
+    Printf("[+] Swap Stats : \n");
+    Printf("\tTracked Pages : %lu pages\n", numTrackedPages);
+    Printf("\tSwapped Out : %lu pages\n", numSwapOuts);
+    Printf("\tSwapped In : %lu pages\n", numSwapIns);
+    if(numSwapIns){
+        Printf("\tSwap In Latency : %lu cycles (avg), %lu cycles (max)\n",
+               swapInCycles / numSwapIns, maxSwapInCycles);
+    }
+
+    Printf("\tCluster Writes : %lu\n", numClusterWrites);
+    Printf("\tRead Ahead : %lu pages\n", numReadAheadPages);
+
+    CompressedSwap::ShowStatistics();
+    SwapDevice::ShowStatistics();
+}
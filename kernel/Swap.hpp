@@ -0,0 +1,164 @@
+/**
+ *@file Swap.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Swapping out cold anonymous pages and bringing them back on fault
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAP_HPP
+#define SWAP_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Common.hpp"
+#include "SwapDevice.hpp"
+#include "SpinLock.hpp"
+
+// swap entry is stored in place of physical address in a non present page
+// | 46 ... 4 | 3 ... 0 |
+// |  offset  |  type   |
+// type tells which swap backend has the page and offset is backend specific
+#define SWAP_TYPE_BITS 4
+#define SWAP_TYPE_MASK uint64_t((1 << SWAP_TYPE_BITS) - 1)
+
+// swap backends
+enum SwapType : uint8_t {
+    SWAP_TYPE_COMPRESSED = 0, // compressed and kept in ram (see CompressedSwap.hpp)
+    SWAP_TYPE_DEVICE = 1 // written to a block device (see SwapDevice.hpp)
+};
+
+inline uint64_t MakeSwapEntry(uint64_t type, uint64_t offset){
+    return (offset << SWAP_TYPE_BITS) | (type & SWAP_TYPE_MASK);
+}
+
+inline uint64_t GetSwapEntryType(uint64_t entry){
+    return entry & SWAP_TYPE_MASK;
+}
+
+inline uint64_t GetSwapEntryOffset(uint64_t entry){
+    return entry >> SWAP_TYPE_BITS;
+}
+
+// max number of anonymous pages reclaim path can keep track of (1 GB)
+#define SWAP_MAX_TRACKED_PAGES uint64_t(512 * 512)
+
+// reclaim starts when number of free pages go below this
+#define SWAP_RECLAIM_WATERMARK 64
+// number of pages to reclaim in one go
+#define SWAP_RECLAIM_BATCH 32
+// anonymous pages dirtied, swapped out and checked by self test
+#define SWAP_SELFTEST_PAGES uint64_t(1024)
+
+// Pages are selected for swap out using clock (second chance) algorithm :
+// the clock hand goes over all tracked pages, if page was accessed
+// since the last time hand passed it then accessed bit is cleared
+// and page gets a second chance, otherwise the page is cold and is swapped out
+//
+// Cold pages are first compressed and kept in memory. Pages that don't compress
+// (or when compressed pool is full) go to swap device. Virtually adjacent pages
+// are collected in a cluster and written to consecutive slots in a single request,
+// and when one of them is faulted back, whole cluster is read in.
+//
+// Tracked pages, their mappings, the cluster and both backends are protected by a single lock
+// (same page merging takes it too, it edits the same mappings). It's held with interrupts
+// disabled across a whole reclaim, so page faults and reclaim on different cpus are serialized.
+// Every unmapped page is flushed from tlb of all cpus (see Tlb.hpp) before it's contents are stored.
+struct Swap{
+    // lock anonymous memory, returns rflags to pass to Unlock
+    static uint64_t Lock();
+    static void Unlock(uint64_t rflags);
+
+    // add an anonymous page to the list of reclaimable pages
+    static void TrackPage(uint64_t vaddr);
+
+    // swap out atmost count cold pages
+    // returns number of pages actually swapped out
+    static uint64_t ReclaimPages(uint64_t count);
+
+    // must be called by page fault handler
+    // returns true if page was swapped out and is now brought back in
+    static bool HandlePageFault(uint64_t vaddr, uint64_t errorcode);
+
+    // print swap statistics
+    static void ShowStatistics();
+
+    // thread that maps anonymous memory, fills it with zero, duplicate, compressible
+    // and incompressible pages, lets them merge, swaps out the rest and checks every page after it comes back
+    static void SelfTest(void* argument);
+
+    // get number of tracked pages
+    static uint64_t GetNumTrackedPages();
+    // get idx-th tracked page
+    static uint64_t GetTrackedPage(uint64_t idx);
+private:
+    // try to swap out page mapped at given virtual address
+    // returns number of frames freed
+    static uint64_t SwapOutPage(uint64_t vaddr);
+
+    // write pending cluster to swap device
+    // returns number of frames freed
+    static uint64_t FlushCluster();
+
+    // read slot into frame along with it's neighbours
+    static bool SwapInFromDevice(uint64_t slot, uint64_t frame);
+
+    // tracked pages are stored in a two level array
+    // first level is a single page containing pointers to pages of virtual addresses
+    static inline uint64_t** trackedPages = nullptr;
+    static inline uint64_t numTrackedPages = 0;
+
+    // current position of clock hand
+    static inline uint64_t clockHand = 0;
+
+    // reclaim path may allocate memory, cpu holding the lock doesn't try to reclaim again
+    static inline SpinLock lock = {};
+    static inline size_t lockOwner = SIZE_MAX;
+
+    // unmapped pages waiting to be written to swap device
+    static inline uint64_t clusterPages[SWAP_CLUSTER_SIZE] = {};
+    static inline uint64_t clusterFrames[SWAP_CLUSTER_SIZE] = {};
+    static inline uint64_t clusterOldValues[SWAP_CLUSTER_SIZE] = {};
+    static inline size_t clusterSize = 0;
+
+    // page used as a sink when read ahead reads free slots
+    static inline uint64_t scratchPage = 0;
+
+    // statistics
+    static inline uint64_t numSwapOuts = 0;
+    static inline uint64_t numSwapIns = 0;
+    static inline uint64_t swapInCycles = 0;
+    static inline uint64_t maxSwapInCycles = 0;
+    static inline uint64_t numClusterWrites = 0;
+    static inline uint64_t numReadAheadPages = 0;
+};
+
+#endif // SWAP_HPP
@@ -0,0 +1,162 @@
+/**
+ *@file SwapDevice.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Swap slots on a block device
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SwapDevice.hpp"
+#include "VirtioBlock.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "Printf.hpp"
+#include "Utils/String.hpp"
+
+// number of sectors in a single slot
+#define SECTORS_PER_SLOT (PAGE_SIZE / VIRTIO_BLK_SECTOR_SIZE)
+
+// number of owners in a single page of owners array
+#define OWNERS_PER_CHUNK (PAGE_SIZE / sizeof(uint64_t))
+
+// bitmap memory for max number of slots
+static uint8_t slotBitmapBuffer[SWAP_DEVICE_MAX_SLOTS / 8];
+
+// find swap device
+bool SwapDevice::Initialize(){
+    if(!VirtioBlock::Initialize()){
+        Printf("[!] No swap device found\n");
+        return false;
+    }
+
+    numSlots = VirtioBlock::GetCapacity() / SECTORS_PER_SLOT;
+    if(numSlots > SWAP_DEVICE_MAX_SLOTS){
+        numSlots = SWAP_DEVICE_MAX_SLOTS;
+    }
+
+    memset(slotBitmapBuffer, 0, sizeof(slotBitmapBuffer));
+    slotBitmap = Bitmap((numSlots + 7) / 8, slotBitmapBuffer);
+
+    // mark bits after last slot as used so they are never allocated
+    for(uint64_t slot = numSlots; slot < slotBitmap.size * 8; slot++){
+        slotBitmap.SetBit(slot);
+    }
+
+    owners = reinterpret_cast<uint64_t**>(PhysicalMemoryManager::AllocatePage());
+    memset(owners, 0, PAGE_SIZE);
+
+    isAvailable = true;
+    Printf("[+] Swap device has %lu slots (%lu KB)\n", numSlots, numSlots * PAGE_SIZE / KB);
+    return true;
+}
+
+bool SwapDevice::IsAvailable(){ return isAvailable; }
+uint64_t SwapDevice::GetNumSlots(){ return numSlots; }
+
+// allocate consecutive slots
+uint64_t SwapDevice::AllocateSlots(size_t n){
+    if(!isAvailable){
+        return SWAP_SLOT_INVALID;
+    }
+
+    // search after hint first and then wrap around
+    uint64_t slot = slotBitmap.FindUnsetRange(n, nextSlotHint);
+    if(slot >= numSlots){
+        slot = slotBitmap.FindUnsetRange(n, 0);
+        if(slot >= numSlots){
+            return SWAP_SLOT_INVALID;
+        }
+    }
+
+    for(size_t i = 0; i < n; i++){
+        slotBitmap.SetBit(slot + i);
+    }
+
+    numUsedSlots += n;
+    nextSlotHint = slot + n;
+    return slot;
+}
+
+// free slot
+void SwapDevice::FreeSlot(uint64_t slot){
+    if(slot >= numSlots || !slotBitmap[slot]){
+        return;
+    }
+
+    slotBitmap.UnsetBit(slot);
+    numUsedSlots--;
+}
+
+// check slot
+bool SwapDevice::IsSlotUsed(uint64_t slot){
+    return (slot < numSlots) && slotBitmap[slot];
+}
+
+// set owner of slot
+void SwapDevice::SetOwner(uint64_t slot, uint64_t vaddr){
+    uint64_t chunk = slot / OWNERS_PER_CHUNK;
+    if(owners[chunk] == nullptr){
+        owners[chunk] = reinterpret_cast<uint64_t*>(PhysicalMemoryManager::AllocatePage());
+    }
+
+    owners[chunk][slot % OWNERS_PER_CHUNK] = vaddr;
+}
+
+// get owner of slot
+uint64_t SwapDevice::GetOwner(uint64_t slot){
+    uint64_t* chunk = owners[slot / OWNERS_PER_CHUNK];
+    return (chunk == nullptr) ? NULLADDR : chunk[slot % OWNERS_PER_CHUNK];
+}
+
+// write pages
+bool SwapDevice::WriteSlots(uint64_t slot, const uint64_t* pages, size_t n){
+    numWriteRequests++;
+    numPagesWritten += n;
+    return VirtioBlock::WritePages(slot * SECTORS_PER_SLOT, pages, n);
+}
+
+// read pages
+bool SwapDevice::ReadSlots(uint64_t slot, const uint64_t* pages, size_t n){
+    numReadRequests++;
+    numPagesRead += n;
+    return VirtioBlock::ReadPages(slot * SECTORS_PER_SLOT, pages, n);
+}
+
+// print statistics
+void SwapDevice::ShowStatistics(){
+    if(!isAvailable){
+        return;
+    }
+
+    Printf("[+] Swap Device Stats : \n");
+    Printf("\tUsed Slots : %lu / %lu\n", numUsedSlots, numSlots);
+    Printf("\tWrites : %lu pages in %lu requests\n", numPagesWritten, numWriteRequests);
+    Printf("\tReads : %lu pages in %lu requests\n", numPagesRead, numReadRequests);
+}
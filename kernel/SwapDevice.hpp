@@ -0,0 +1,113 @@
+/**
+ *@file SwapDevice.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Swap slots on a block device
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAPDEVICE_HPP
+#define SWAPDEVICE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "Utils/Bitmap.hpp"
+
+// Swap device is divided into page sized slots.
+// Used slots are tracked in a bitmap, and for each used slot we remember
+// the virtual address of page stored in it. This reverse mapping is used
+// to bring in neighbouring pages when a page is read back (read ahead).
+
+// number of pages written together and read back together
+#define SWAP_CLUSTER_SIZE 8
+
+// max number of slots (1 GB of swap)
+#define SWAP_DEVICE_MAX_SLOTS uint64_t(512 * 512)
+
+// returned when a slot cannot be allocated
+#define SWAP_SLOT_INVALID uint64_t(-1)
+
+struct SwapDevice{
+    // find a block device to swap to
+    // returns false if no device is found
+    static bool Initialize();
+
+    // check if a swap device is available
+    static bool IsAvailable();
+
+    // get total number of slots
+    static uint64_t GetNumSlots();
+
+    // allocate n consecutive slots
+    // returns first slot or SWAP_SLOT_INVALID
+    static uint64_t AllocateSlots(size_t n);
+
+    // release a slot
+    static void FreeSlot(uint64_t slot);
+
+    // check if given slot is used
+    static bool IsSlotUsed(uint64_t slot);
+
+    // set/get virtual address of page stored in given slot
+    static void SetOwner(uint64_t slot, uint64_t vaddr);
+    static uint64_t GetOwner(uint64_t slot);
+
+    // write n pages to consecutive slots starting at given slot
+    static bool WriteSlots(uint64_t slot, const uint64_t* pages, size_t n);
+
+    // read n consecutive slots starting at given slot into pages
+    static bool ReadSlots(uint64_t slot, const uint64_t* pages, size_t n);
+
+    // print statistics
+    static void ShowStatistics();
+private:
+    static inline bool isAvailable = false;
+
+    // used slots
+    static inline Bitmap slotBitmap;
+    static inline uint64_t numSlots = 0;
+    static inline uint64_t numUsedSlots = 0;
+
+    // allocation starts searching from here
+    // this keeps consecutive allocations close to each other
+    static inline uint64_t nextSlotHint = 0;
+
+    // owners are stored in a two level array like swap's tracked pages
+    static inline uint64_t** owners = nullptr;
+
+    // statistics
+    static inline uint64_t numWriteRequests = 0;
+    static inline uint64_t numPagesWritten = 0;
+    static inline uint64_t numReadRequests = 0;
+    static inline uint64_t numPagesRead = 0;
+};
+
+#endif // SWAPDEVICE_HPP
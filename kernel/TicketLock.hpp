@@ -0,0 +1,121 @@
+/**
+ *@file TicketLock.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Fair first come first served spin lock
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TICKETLOCK_HPP
+#define TICKETLOCK_HPP
+
+#include <cstdint>
+#include "CPU.hpp"
+#include "LockStats.hpp"
+
+// Every waiter takes a ticket and waits until it's number is served, so cpus
+// get the lock in order they asked for it and none of them starves.
+// All waiters still spin on same line, every release invalidates it on all of them,
+// waiters further back in line pause longer between checks to soften that.
+// Use this where fairness matters (console output), MCSLock for heavy contention.
+// Zero initialized lock is unlocked.
+struct TicketLock {
+    uint32_t next; // ticket given to next cpu that asks
+    uint32_t serving; // ticket that holds the lock
+#ifdef ENABLE_LOCK_DEBUG
+    LockStats stats;
+#endif
+
+    void Lock(){
+#ifdef ENABLE_LOCK_DEBUG
+        uint64_t start = ReadTSC();
+#endif
+        uint32_t ticket = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED);
+        uint32_t current = __atomic_load_n(&serving, __ATOMIC_ACQUIRE);
+        bool contended = current != ticket;
+        while(current != ticket){
+            // wait roughly in proportion to number of cpus ahead of us
+            for(uint32_t i = ticket - current; i != 0; i--){
+                asm volatile("pause");
+            }
+            current = __atomic_load_n(&serving, __ATOMIC_ACQUIRE);
+        }
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Acquired(start, contended);
+#else
+        (void)contended;
+#endif
+    }
+
+    // lock is free only when nobody holds a ticket, returns true if lock was taken
+    bool TryLock(){
+        uint32_t current = __atomic_load_n(&serving, __ATOMIC_RELAXED);
+        uint32_t expected = current;
+        if(!__atomic_compare_exchange_n(&next, &expected, current + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+            return false;
+        }
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Acquired(ReadTSC(), false);
+#endif
+        return true;
+    }
+
+    // only holder writes serving
+    void Unlock(){
+#ifdef ENABLE_LOCK_DEBUG
+        stats.Released();
+#endif
+        __atomic_store_n(&serving, serving + 1, __ATOMIC_RELEASE);
+    }
+
+    // disable interrupts on this cpu before locking, returns rflags to restore
+    uint64_t LockIrqSave(){
+        uint64_t rflags = SaveAndDisableInterrupts();
+        Lock();
+        return rflags;
+    }
+
+    void UnlockIrqRestore(uint64_t rflags){
+        Unlock();
+        RestoreInterrupts(rflags);
+    }
+
+    // name shown in lock statistics, does nothing without ENABLE_LOCK_DEBUG
+    void SetName(const char* name){
+#ifdef ENABLE_LOCK_DEBUG
+        stats.name = name;
+#else
+        (void)name;
+#endif
+    }
+};
+
+#endif // TICKETLOCK_HPP
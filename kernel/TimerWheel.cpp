@@ -0,0 +1,359 @@
+/**
+ *@file TimerWheel.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Per cpu hierarchical timer wheel
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "TimerWheel.hpp"
+#include "CPU.hpp"
+#include "SMP.hpp"
+#include "SoftIRQ.hpp"
+#include "Clock.hpp"
+#include "Scheduler.hpp"
+#include "Printf.hpp"
+
+// ticks covered by a single slot of given level
+static inline uint64_t LevelGranularity(size_t level){
+    return uint64_t(1) << (level * TIMER_WHEEL_SLOT_BITS);
+}
+
+// round up, a timer never fires early
+static inline uint64_t NsToTick(uint64_t ns){
+    return (ns + (uint64_t(1) << TIMER_WHEEL_TICK_SHIFT) - 1) >> TIMER_WHEEL_TICK_SHIFT;
+}
+
+static inline uint64_t TickToNs(uint64_t tick){
+    return tick << TIMER_WHEEL_TICK_SHIFT;
+}
+
+// softirq runs all due timers
+void TimerWheel::Initialize(){
+    SoftIRQ::Register(SOFTIRQ_TIMER, RunExpired, nullptr);
+    Printf("[+] Timer wheel initialized (%u levels of %u slots, tick %lu ns)\n",
+           TIMER_WHEEL_LEVELS, TIMER_WHEEL_SLOTS, TickToNs(1));
+}
+
+// nothing before now needs processing
+void TimerWheel::InitializeCpu(){
+    Base& base = bases[GetCurrentCpuIndex()];
+    base.lock.SetName("timer wheel");
+    base.nextTick = (Clock::NowNs() >> TIMER_WHEEL_TICK_SHIFT) + 1;
+}
+
+// level is picked by how far away expiry is, slot by bits of expiry at that level
+void TimerWheel::Enqueue(Base& base, Timer* timer){
+    // already due, process with next tick
+    if(timer->expires < base.nextTick){
+        timer->expires = base.nextTick;
+    }
+
+    uint64_t delta = timer->expires - base.nextTick;
+    uint64_t position = timer->expires;
+
+    size_t level = 0;
+    if(delta >= TIMER_WHEEL_SLOTS){
+        level = size_t(63 - __builtin_clzll(delta)) / TIMER_WHEEL_SLOT_BITS;
+    }
+
+    // too far away, park in farthest slot, it's placed again when that's cascaded
+    if(level >= TIMER_WHEEL_LEVELS){
+        level = TIMER_WHEEL_LEVELS - 1;
+        position = base.nextTick + LevelGranularity(TIMER_WHEEL_LEVELS) - 1;
+    }
+
+    size_t slot = (position >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+    timer->level = uint8_t(level);
+    timer->slot = uint8_t(slot);
+
+    Timer** head = &base.slots[level][slot];
+    timer->next = *head;
+    if(timer->next != nullptr){
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+
+    base.bitmaps[level] |= uint64_t(1) << slot;
+}
+
+// works for wheel slots and expired list alike
+void TimerWheel::Detach(Base& base, Timer* timer){
+    *timer->pprev = timer->next;
+    if(timer->next != nullptr){
+        timer->next->pprev = timer->pprev;
+    }
+
+    if((timer->level != TIMER_WHEEL_EXPIRED_LEVEL) && (base.slots[timer->level][timer->slot] == nullptr)){
+        base.bitmaps[timer->level] &= ~(uint64_t(1) << timer->slot);
+    }
+
+    timer->next = nullptr;
+    timer->pprev = nullptr;
+}
+
+// at a multiple of 64 next slot of level 1 moves down, if that slot was 0 level 1 has wrapped
+// and next slot of level 2 moves down too and so on
+void TimerWheel::Cascade(Base& base, uint64_t tick){
+    for(size_t level = 1; level < TIMER_WHEEL_LEVELS; level++){
+        size_t slot = (tick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+
+        Timer* timer = base.slots[level][slot];
+        base.slots[level][slot] = nullptr;
+        base.bitmaps[level] &= ~(uint64_t(1) << slot);
+
+        while(timer != nullptr){
+            Timer* next = timer->next;
+            Enqueue(base, timer);
+            base.numCascaded++;
+            timer = next;
+        }
+
+        if(slot != 0){
+            break;
+        }
+    }
+}
+
+// one tick at a time would mean a million iterations after a long idle period,
+// so ticks in which nothing can happen are skipped : if lowest n levels are empty
+// nothing happens until next multiple of 64^n, when level n is cascaded
+void TimerWheel::Advance(Base& base, uint64_t tick){
+    while(base.nextTick <= tick){
+        if(base.numPending == 0){
+            base.nextTick = tick + 1;
+            return;
+        }
+
+        size_t level = 0;
+        while((level < TIMER_WHEEL_LEVELS - 1) && (base.bitmaps[level] == 0)){
+            level++;
+        }
+
+        uint64_t current = base.nextTick;
+        if(level != 0){
+            uint64_t step = LevelGranularity(level);
+            current = (current + step - 1) & ~(step - 1);
+            if(current > tick){
+                base.nextTick = tick + 1;
+                return;
+            }
+        }
+
+        // timers moving down must see this as the tick being processed
+        base.nextTick = current;
+        if((current & (TIMER_WHEEL_SLOTS - 1)) == 0){
+            Cascade(base, current);
+        }
+
+        // everything in this slot of level 0 expires exactly now
+        size_t slot = current & (TIMER_WHEEL_SLOTS - 1);
+        Timer* timer = base.slots[0][slot];
+        while(timer != nullptr){
+            Timer* next = timer->next;
+            Detach(base, timer);
+
+            timer->level = TIMER_WHEEL_EXPIRED_LEVEL;
+            timer->next = base.expired;
+            if(timer->next != nullptr){
+                timer->next->pprev = &timer->next;
+            }
+            timer->pprev = &base.expired;
+            base.expired = timer;
+
+            timer = next;
+        }
+
+        base.nextTick = current + 1;
+    }
+}
+
+// queue on this cpu's wheel
+void TimerWheel::Add(Timer* timer, uint64_t delay, TimerFunction function, void* context){
+    uint64_t rflags = SaveAndDisableInterrupts();
+
+    // a pending timer is moved, possibly from another cpu
+    Cancel(timer);
+
+    size_t cpu = GetCurrentCpuIndex();
+    Base& base = bases[cpu];
+    uint64_t now = Clock::NowNs();
+
+    base.lock.Lock();
+    // empty wheel has nothing to catch up with, skip straight to now
+    if(base.numPending == 0){
+        Advance(base, now >> TIMER_WHEEL_TICK_SHIFT);
+    }
+
+    timer->function = function;
+    timer->context = context;
+    timer->cpu = uint32_t(cpu);
+    timer->expires = NsToTick(now + delay);
+    Enqueue(base, timer);
+    base.numPending++;
+    base.numAdded++;
+    base.lock.Unlock();
+
+    // timer interrupt may be armed for later than this
+    Scheduler::RearmTimer();
+    RestoreInterrupts(rflags);
+}
+
+// lock the wheel timer is in, it may belong to another cpu
+bool TimerWheel::Cancel(Timer* timer){
+    if(!IsPending(timer)){
+        return false;
+    }
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+    Base& base = bases[timer->cpu];
+    base.lock.Lock();
+
+    // could have expired while we waited for lock
+    bool pending = IsPending(timer);
+    if(pending){
+        Detach(base, timer);
+        base.numPending--;
+        base.numCancelled++;
+    }
+
+    base.lock.Unlock();
+    RestoreInterrupts(rflags);
+
+    // an earlier timer interrupt is harmless, it's not rearmed for later here
+    return pending;
+}
+
+// level 0 slots are single ticks, so first non empty one is exact expiry
+// in higher levels it's when first non empty slot gets cascaded
+uint64_t TimerWheel::GetLevelExpiry(const Base& base, size_t level){
+    uint64_t bitmap = base.bitmaps[level];
+    if(bitmap == 0){
+        return ~uint64_t(0);
+    }
+
+    // first slot to look at is the one processed (level 0) or cascaded next,
+    // at first multiple of it's granularity that's not before nextTick
+    size_t shift = level * TIMER_WHEEL_SLOT_BITS;
+    uint64_t first = (base.nextTick + LevelGranularity(level) - 1) >> shift;
+    size_t start = size_t(first & (TIMER_WHEEL_SLOTS - 1));
+    uint64_t rotated = (start == 0) ? bitmap : ((bitmap >> start) | (bitmap << (TIMER_WHEEL_SLOTS - start)));
+
+    return (first + uint64_t(__builtin_ctzll(rotated))) << shift;
+}
+
+// earliest of all levels
+uint64_t TimerWheel::GetNextExpiry(){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    Base& base = bases[GetCurrentCpuIndex()];
+
+    uint64_t tick = ~uint64_t(0);
+    base.lock.Lock();
+    // expired list is left out, softirq running them arms timer again when done
+    if(base.numPending != 0){
+        for(size_t level = 0; level < TIMER_WHEEL_LEVELS; level++){
+            uint64_t expiry = GetLevelExpiry(base, level);
+            if(expiry < tick){
+                tick = expiry;
+            }
+        }
+    }
+    base.lock.Unlock();
+
+    RestoreInterrupts(rflags);
+    return (tick == ~uint64_t(0)) ? tick : TickToNs(tick);
+}
+
+// cheap check in hard interrupt, wheel is processed in softirq
+bool TimerWheel::OnTimerInterrupt(uint64_t now){
+    if(GetNextExpiry() > now){
+        return false;
+    }
+
+    SoftIRQ::Raise(SOFTIRQ_TIMER);
+    return true;
+}
+
+// collect everything that's due in one pass, then run them one by one
+// lock is dropped while a function runs, so it can add timers again (even itself)
+// and others can still cancel what's left in the batch
+void TimerWheel::RunExpired(void* context){
+    (void)context;
+
+    uint64_t rflags = SaveAndDisableInterrupts();
+    Base& base = bases[GetCurrentCpuIndex()];
+
+    base.lock.Lock();
+    Advance(base, Clock::NowNs() >> TIMER_WHEEL_TICK_SHIFT);
+
+    uint64_t batch = 0;
+    Timer* timer;
+    while((timer = base.expired) != nullptr){
+        Detach(base, timer);
+        base.numPending--;
+        base.numExpired++;
+        batch++;
+
+        TimerFunction function = timer->function;
+        void* functionContext = timer->context;
+
+        base.lock.Unlock();
+        RestoreInterrupts(rflags);
+        function(functionContext);
+        rflags = SaveAndDisableInterrupts();
+        base.lock.Lock();
+    }
+
+    if(batch > base.maxBatch){
+        base.maxBatch = batch;
+    }
+    base.lock.Unlock();
+
+    // next interrupt is for whatever is earliest now
+    Scheduler::RearmTimer();
+    RestoreInterrupts(rflags);
+}
+
+// per cpu counters
+void TimerWheel::ShowStatistics(){
+    Printf("[+] Timer Wheel Statistics :\n");
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        if(!IsCpuOnline(cpu)){
+            continue;
+        }
+
+        const Base& base = bases[cpu];
+        Printf("\tCPU %lu : %lu pending, %lu added, %lu cancelled, %lu expired\n",
+               cpu, base.numPending, base.numAdded, base.numCancelled, base.numExpired);
+        Printf("\t\t%lu cascaded, at most %lu run in one batch\n", base.numCascaded, base.maxBatch);
+    }
+}
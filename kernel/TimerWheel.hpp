@@ -0,0 +1,142 @@
+/**
+ *@file TimerWheel.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Per cpu hierarchical timer wheel
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "PerCpu.hpp"
+#include "SpinLock.hpp"
+
+// wheel advances in ticks of 2^20 ns (~1.05ms), so converting is a shift
+#define TIMER_WHEEL_TICK_SHIFT 20
+// number of levels and slots in each, level n slot covers 64^n ticks
+// 5 levels reach 2^30 ticks (~13 days), later timers are parked in last level
+#define TIMER_WHEEL_LEVELS 5
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+// level of timers that expired and wait for their function to run
+#define TIMER_WHEEL_EXPIRED_LEVEL TIMER_WHEEL_LEVELS
+
+// called in softirq context with interrupts enabled, must not sleep
+typedef void (*TimerFunction)(void* context);
+
+// embed this wherever a timeout is needed, zero initialized timer is not pending
+struct Timer {
+    Timer* next;
+    Timer** pprev; // link pointing to this, nullptr if timer isn't pending
+    uint64_t expires; // wheel tick
+    TimerFunction function;
+    void* context;
+    uint32_t cpu; // whose wheel this is in
+    uint8_t level;
+    uint8_t slot;
+};
+
+// Each cpu has a wheel of TIMER_WHEEL_LEVELS levels with TIMER_WHEEL_SLOTS slots.
+// A timer goes into level 0 if it expires within 64 ticks, level 1 if within 64^2 and so on,
+// slot is picked by bits of it's expiry tick. Timers are doubly linked so add and cancel are O(1).
+// When level 0 wraps around, next slot of level 1 is cascaded (it's timers are added again,
+// now landing in level 0), same for higher levels.
+// Timer interrupt raises a softirq once earliest timer (or a cascade) is due, softirq
+// advances wheel to current tick collecting all due timers and runs them in one pass.
+// Wheel doesn't need a periodic tick, empty levels are skipped when advancing and
+// scheduler arms timer interrupt for GetNextExpiry (see Scheduler.cpp).
+struct TimerWheel {
+    // register softirq
+    static void Initialize();
+
+    // start wheel of this cpu at current time
+    static void InitializeCpu();
+
+    // run function after at least delay ns on this cpu, rounded up to wheel ticks
+    // a pending timer is moved, Add and Cancel of same timer must not race each other
+    static void Add(Timer* timer, uint64_t delay, TimerFunction function, void* context);
+
+    // returns true if timer was pending, false if it already expired or was never added
+    static bool Cancel(Timer* timer);
+
+    static bool IsPending(const Timer* timer){ return timer->pprev != nullptr; }
+
+    // time (see Clock::NowNs) when wheel of this cpu needs to run next, ~0 if it's empty
+    // can be earlier than earliest timer when a higher level needs to be cascaded
+    static uint64_t GetNextExpiry();
+
+    // called from timer interrupt, raises softirq and returns true if something is due
+    static bool OnTimerInterrupt(uint64_t now);
+
+    // show per cpu counters
+    static void ShowStatistics();
+
+private:
+    struct Base {
+        SpinLock lock;
+        uint64_t nextTick; // first tick that hasn't been processed yet
+        uint64_t bitmaps[TIMER_WHEEL_LEVELS]; // non empty slots of each level
+        Timer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+        Timer* expired; // collected by Advance, run one by one
+        size_t numPending;
+        // statistics
+        uint64_t numAdded;
+        uint64_t numCancelled;
+        uint64_t numExpired;
+        uint64_t numCascaded;
+        uint64_t maxBatch; // most timers run by one softirq
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    // link into slot for it's expiry tick, relative to nextTick, base must be locked
+    static void Enqueue(Base& base, Timer* timer);
+
+    // unlink from wherever it is, base must be locked
+    static void Detach(Base& base, Timer* timer);
+
+    // add timers of next slot of higher levels again, tick is a multiple of TIMER_WHEEL_SLOTS
+    static void Cascade(Base& base, uint64_t tick);
+
+    // process all ticks up to and including given one, due timers go to expired list
+    static void Advance(Base& base, uint64_t tick);
+
+    // softirq
+    static void RunExpired(void* context);
+
+    // earliest tick at which something in given level needs attention, base must be locked
+    static uint64_t GetLevelExpiry(const Base& base, size_t level);
+
+    static inline Base bases[MAX_CPUS] = {};
+};
+
+#endif // TIMERWHEEL_HPP
@@ -0,0 +1,132 @@
+/**
+ *@file Tlb.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief TLB shootdown across cpus sharing kernel page tables
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Tlb.hpp"
+#include "APIC.hpp"
+#include "IRQ.hpp"
+#include "SMP.hpp"
+#include "PerCpu.hpp"
+#include "CPU.hpp"
+
+// register ipi handler
+void Tlb::Initialize(){
+    lock.SetName("tlb");
+    RegisterIrqHandler(APIC_TLB_SHOOTDOWN_VECTOR, ShootdownHandler, nullptr);
+}
+
+// flush pages on this cpu, kernel pages aren't global so reloading cr3 flushes everything
+void Tlb::Flush(const uint64_t* vaddrs, size_t count){
+    if(count > TLB_SHOOTDOWN_MAX_PAGES){
+        asm volatile("mov %0, %%cr3"
+                     :
+                     : "r"(ReadCR3())
+                     : "memory");
+        return;
+    }
+
+    for(size_t i = 0; i < count; i++){
+        InvalidatePage(vaddrs[i]);
+    }
+}
+
+// flush here, then everywhere else
+void Tlb::Shootdown(const uint64_t* vaddrs, size_t count){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    Flush(vaddrs, count);
+
+    // without apic there's no way to reach other cpus, but then they aren't running either
+    if(!APIC::IsEnabled() || (GetNumOnlineCpus() == 1)){
+        RestoreInterrupts(rflags);
+        return;
+    }
+
+    // cpu doing another shootdown may be waiting for us
+    LockIrqSave(lock);
+
+    size_t self = GetCurrentCpuIndex();
+    uint64_t targets = 0;
+    for(size_t cpu = 0; cpu < MAX_CPUS; cpu++){
+        if((cpu != self) && IsCpuOnline(cpu)){
+            targets |= uint64_t(1) << cpu;
+        }
+    }
+
+    pages = vaddrs;
+    numPages = count;
+    __atomic_store_n(&pendingMask, targets, __ATOMIC_RELEASE);
+
+    for(uint64_t mask = targets; mask != 0; mask &= mask - 1){
+        size_t cpu = size_t(__builtin_ctzll(mask));
+        APIC::SendIPI(GetCpuData(cpu)->apicID, APIC_TLB_SHOOTDOWN_VECTOR);
+    }
+
+    while(__atomic_load_n(&pendingMask, __ATOMIC_ACQUIRE) != 0){
+        asm volatile("pause");
+    }
+
+    numShootdowns++;
+    lock.UnlockIrqRestore(rflags);
+}
+
+// do our part of shootdown in progress
+void Tlb::FlushPending(){
+    uint64_t self = uint64_t(1) << GetCurrentCpuIndex();
+    if(!(__atomic_load_n(&pendingMask, __ATOMIC_ACQUIRE) & self)){
+        return;
+    }
+
+    Flush(pages, numPages);
+    __atomic_fetch_and(&pendingMask, ~self, __ATOMIC_RELEASE);
+}
+
+// spin with interrupts disabled, but keep answering shootdowns
+uint64_t Tlb::LockIrqSave(SpinLock& spinLock){
+    uint64_t rflags = SaveAndDisableInterrupts();
+    while(!spinLock.TryLock()){
+        FlushPending();
+        asm volatile("pause");
+    }
+
+    return rflags;
+}
+
+// ipi of a shootdown that was already answered while spinning on a lock finds nothing to do
+bool Tlb::ShootdownHandler(InterruptContext* frame, void* context){
+    (void)frame;
+    (void)context;
+    FlushPending();
+    return true;
+}
@@ -0,0 +1,94 @@
+/**
+ *@file Tlb.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief TLB shootdown across cpus sharing kernel page tables
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TLB_HPP
+#define TLB_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "SpinLock.hpp"
+
+// shootdowns of more pages than this flush whole tlb instead
+#define TLB_SHOOTDOWN_MAX_PAGES 32
+
+struct InterruptContext;
+
+// All cpus run on kernel's page tables, so when a mapping is removed or made more
+// restrictive, other cpus may still have the old one cached in their tlb. Shootdown
+// flushes given pages on this cpu, sends an ipi to every other online cpu and waits
+// until each of them has flushed them too. Only after that the old frame can be
+// reused or it's contents trusted to stay the same.
+//
+// A cpu waiting for a lock with interrupts disabled can't take the ipi, so a lock
+// held across a shootdown must be taken with Tlb::LockIrqSave, which keeps
+// answering shootdowns while it spins.
+struct Tlb {
+    // register shootdown ipi handler
+    static void Initialize();
+
+    // invalidate pages on all online cpus, returns once every cpu did it
+    static void Shootdown(const uint64_t* vaddrs, size_t count);
+    static void Shootdown(uint64_t vaddr){ Shootdown(&vaddr, 1); }
+
+    // flush pages of shootdown in progress if this cpu hasn't done it yet
+    static void FlushPending();
+
+    // disable interrupts and take lock, answering shootdowns while waiting for it
+    // returns rflags for SpinLock::UnlockIrqRestore
+    static uint64_t LockIrqSave(SpinLock& lock);
+
+    // number of shootdowns that had to interrupt other cpus
+    static uint64_t GetNumShootdowns(){ return numShootdowns; }
+
+private:
+    // invalidate pages on this cpu
+    static void Flush(const uint64_t* vaddrs, size_t count);
+
+    // shootdown ipi
+    static bool ShootdownHandler(InterruptContext* frame, void* context);
+
+    // one shootdown at a time
+    static inline SpinLock lock = {};
+    // pages of shootdown in progress, written before pendingMask
+    static inline const uint64_t* pages = nullptr;
+    static inline size_t numPages = 0;
+    // bit n is set until cpu n flushed pages above
+    static inline uint64_t pendingMask = 0;
+
+    static inline uint64_t numShootdowns = 0;
+};
+
+#endif // TLB_HPP
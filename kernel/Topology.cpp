@@ -0,0 +1,172 @@
+/**
+ *@file Topology.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Cpu topology (smt, package, numa node) from CPUID and ACPI
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Topology.hpp"
+#include "ACPI.hpp"
+#include "CPU.hpp"
+#include "Printf.hpp"
+
+// cpuid leaf 1 bits
+#define CPUID_1_EDX_HTT (uint32_t(1) << 28) // ebx[23:16] is valid
+
+// cpuid leaf 0xb level types
+#define CPUID_TOPOLOGY_LEVEL_INVALID 0
+#define CPUID_TOPOLOGY_LEVEL_SMT 1
+
+// apic id and bit widths of this cpu
+void Topology::ReadCPUID(uint32_t& apicID, uint32_t& smtShift, uint32_t& packageShift){
+    uint32_t eax, ebx, ecx, edx;
+    smtShift = 0;
+    packageShift = 0;
+
+    CPUID(0, 0, eax, ebx, ecx, edx);
+    uint32_t maxLeaf = eax;
+
+    // each subleaf describes one level, shift of last one gives package id
+    if(maxLeaf >= 0xb){
+        CPUID(0xb, 0, eax, ebx, ecx, edx);
+        if(ebx != 0){
+            for(uint32_t level = 0; level < TOPOLOGY_MAX_CPUID_LEVELS; level++){
+                CPUID(0xb, level, eax, ebx, ecx, edx);
+                uint32_t type = (ecx >> 8) & 0xff;
+                if(type == CPUID_TOPOLOGY_LEVEL_INVALID){
+                    break;
+                }
+
+                if(type == CPUID_TOPOLOGY_LEVEL_SMT){
+                    smtShift = eax & 0x1f;
+                }
+                packageShift = eax & 0x1f;
+                apicID = edx;
+            }
+            return;
+        }
+    }
+
+    // older cpus only tell number of logical processors in a package
+    // smt siblings can't be told apart from cores, each is treated as a core
+    CPUID(1, 0, eax, ebx, ecx, edx);
+    apicID = ebx >> 24;
+
+    uint32_t count = (edx & CPUID_1_EDX_HTT) ? ((ebx >> 16) & 0xff) : 1;
+    if(count > 1){
+        packageShift = 32 - __builtin_clz(count - 1);
+    }
+}
+
+// lookup in srat entries
+uint32_t Topology::FindNode(uint32_t apicID){
+    for(size_t i = 0; i < numAffinities; i++){
+        if(affinities[i].apicID == apicID){
+            return affinities[i].node;
+        }
+    }
+
+    return 0;
+}
+
+// boot cpu
+void Topology::Initialize(){
+    SRATHeader* srat = reinterpret_cast<SRATHeader*>(FindSDT("SRAT"));
+    if(srat == nullptr){
+        Printf("[!] SRAT not found, all cpus are in one numa node\n");
+        InitializeCpu();
+        return;
+    }
+
+    uint64_t entry = reinterpret_cast<uint64_t>(srat + 1);
+    uint64_t end = reinterpret_cast<uint64_t>(srat) + srat->length;
+    while((entry < end) && (numAffinities < APIC_MAX_LOCAL_APICS)){
+        SRATEntryHeader* header = reinterpret_cast<SRATEntryHeader*>(entry);
+        if(header->length == 0) break;
+
+        switch(header->type){
+        case SRAT_ENTRY_PROCESSOR_AFFINITY: {
+            SRATProcessorAffinity* affinity = reinterpret_cast<SRATProcessorAffinity*>(header);
+            if(affinity->flags & SRAT_AFFINITY_ENABLED){
+                uint32_t node = affinity->proximityDomainLow |
+                                (uint32_t(affinity->proximityDomainHigh[0]) << 8) |
+                                (uint32_t(affinity->proximityDomainHigh[1]) << 16) |
+                                (uint32_t(affinity->proximityDomainHigh[2]) << 24);
+                affinities[numAffinities++] = {affinity->apicID, node};
+            }
+            break;
+        }
+        case SRAT_ENTRY_X2APIC_AFFINITY: {
+            SRATX2APICAffinity* affinity = reinterpret_cast<SRATX2APICAffinity*>(header);
+            if(affinity->flags & SRAT_AFFINITY_ENABLED){
+                affinities[numAffinities++] = {affinity->x2APICID, affinity->proximityDomain};
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        entry += header->length;
+    }
+
+    Printf("[+] SRAT : %lu processor affinities\n", numAffinities);
+    InitializeCpu();
+}
+
+// every cpu fills it's own entry
+void Topology::InitializeCpu(){
+    uint32_t apicID = 0, smtShift = 0, packageShift = 0;
+    ReadCPUID(apicID, smtShift, packageShift);
+
+    size_t index = GetCurrentCpuIndex();
+    CpuTopology& topology = cpus[index];
+    topology.apicID = apicID;
+    topology.core = apicID >> smtShift;
+    topology.package = apicID >> packageShift;
+    topology.node = FindNode(apicID);
+
+    Printf("[+] CPU %lu : package %u, core %u, node %u\n",
+           index, topology.package, topology.core, topology.node);
+}
+
+// compare from nearest level
+TopologyLevel Topology::GetLevel(size_t a, size_t b){
+    const CpuTopology& x = cpus[a];
+    const CpuTopology& y = cpus[b];
+
+    if(x.package == y.package){
+        return (x.core == y.core) ? TOPOLOGY_SAME_CORE : TOPOLOGY_SAME_PACKAGE;
+    }
+
+    return (x.node == y.node) ? TOPOLOGY_SAME_NODE : TOPOLOGY_REMOTE;
+}
@@ -0,0 +1,101 @@
+/**
+ *@file Topology.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Cpu topology (smt, package, numa node) from CPUID and ACPI
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef TOPOLOGY_HPP
+#define TOPOLOGY_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "PerCpu.hpp"
+#include "APIC.hpp"
+
+// max number of subleaves of cpuid leaf 0xb that are looked at
+#define TOPOLOGY_MAX_CPUID_LEVELS 8
+
+// how close two cpus are, nearer ones share more caches
+enum TopologyLevel : uint8_t {
+    TOPOLOGY_SAME_CORE = 0, // smt siblings
+    TOPOLOGY_SAME_PACKAGE = 1, // share last level cache
+    TOPOLOGY_SAME_NODE = 2, // share memory controller
+    TOPOLOGY_REMOTE = 3,
+    TOPOLOGY_NUM_LEVELS = 4
+};
+
+// where a cpu sits
+struct CpuTopology {
+    uint32_t apicID;
+    uint32_t core; // apic id without smt bits
+    uint32_t package; // apic id without smt and core bits
+    uint32_t node; // srat proximity domain, 0 if there's no srat
+};
+
+// MADT lists the processors, but package and core of each are encoded in bits of
+// it's apic id and only cpuid (leaf 0xb, or leaf 1 on older cpus) tells how many
+// bits each level takes. Numa node of each processor comes from SRAT.
+// Every cpu reads it's own cpuid, so each one fills in it's own entry.
+struct Topology {
+    // parse srat and setup boot cpu's entry
+    static void Initialize();
+
+    // fill in entry of cpu executing this
+    static void InitializeCpu();
+
+    // topology of cpu with given index
+    static const CpuTopology& Get(size_t cpu){ return cpus[cpu]; }
+
+    // how close two cpus are
+    static TopologyLevel GetLevel(size_t a, size_t b);
+
+private:
+    // apic id of this cpu and number of apic id bits used by smt and by smt + cores
+    static void ReadCPUID(uint32_t& apicID, uint32_t& smtShift, uint32_t& packageShift);
+
+    // proximity domain of processor with given apic id
+    static uint32_t FindNode(uint32_t apicID);
+
+    static inline CpuTopology cpus[MAX_CPUS] = {};
+
+    // processor affinities from srat
+    struct Affinity {
+        uint32_t apicID;
+        uint32_t node;
+    };
+
+    static inline Affinity affinities[APIC_MAX_LOCAL_APICS] = {};
+    static inline size_t numAffinities = 0;
+};
+
+#endif // TOPOLOGY_HPP
@@ -43,7 +43,7 @@ Bitmap::Bitmap(size_t size, uint8_t* buffer)
 // set bit at given index
 void Bitmap::SetBit(size_t idx){
     // check if given index is in range of bitmap size
-    if(size < (idx / 8))
+    if(size <= (idx / 8))
         return;
 
     // index of byte that contains the bit for given index
@@ -58,7 +58,7 @@ void Bitmap::SetBit(size_t idx){
 // unset bit at given index
 void Bitmap::UnsetBit(size_t idx){
     // check if given index is in range of bitmap size
-    if(size < (idx / 8))
+    if(size <= (idx / 8))
         return;
 
     // index of byte that contains the bit for given index
@@ -73,7 +73,7 @@ void Bitmap::UnsetBit(size_t idx){
 // if idx is out of range then false is returned
 bool Bitmap::operator[](uint64_t idx){
     // check if index is in range
-    if(size < (idx / 8))
+    if(size <= (idx / 8))
         return false;
 
     // index of byte that contains the bit for given index
@@ -83,3 +83,28 @@ bool Bitmap::operator[](uint64_t idx){
 
     return (buffer[buf_idx] >> bit_offset) & 0x1;
 }
+
+// find range of unset bits
+size_t Bitmap::FindUnsetRange(size_t count, size_t start){
+    size_t numBits = size * 8;
+    size_t runStart = start;
+    size_t runLength = 0;
+
+    for(size_t idx = start; idx < numBits; idx++){
+        // skip full bytes at once when we are at a byte boundary
+        if((runLength == 0) && (idx % 8 == 0) && (buffer[idx / 8] == 0xff)){
+            idx += 7;
+            continue;
+        }
+
+        if((*this)[idx]){
+            runLength = 0;
+        }else{
+            if(runLength == 0) runStart = idx;
+            runLength++;
+            if(runLength == count) return runStart;
+        }
+    }
+
+    return numBits;
+}
@@ -59,6 +59,10 @@ struct Bitmap{
     // Set value of bit to false at given index
     void UnsetBit(size_t idx);
 
+    // Find first index at or after start, from where count consecutive bits are unset.
+    // Returns number of bits in bitmap (size * 8) if no such range exists.
+    size_t FindUnsetRange(size_t count, size_t start);
+
     // size of buffer and not the number of booleans required
     size_t size;
     uint8_t *buffer;
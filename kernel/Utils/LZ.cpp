@@ -0,0 +1,230 @@
+/**
+ *@file LZ.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Fast LZ77 style codec (LZ4 like block format) used for compressing pages
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "LZ.hpp"
+#include "String.hpp"
+
+// number of bits used for hash table index
+#define LZ_HASH_BITS 10
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+
+// a match cannot start in last 12 bytes
+// and last 5 bytes are always literals
+#define LZ_MFLIMIT 12
+#define LZ_LAST_LITERALS 5
+
+// max offset that can be encoded in 2 bytes
+#define LZ_MAX_OFFSET 0xffff
+
+// positions are relative to the start of input
+// pages are never bigger than 64KB so 16 bits are enough
+static uint16_t hashTable[LZ_HASH_SIZE];
+
+// read 4 bytes without caring about alignment
+static inline uint32_t Read32(const uint8_t* p){
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+// knuth's multiplicative hash
+static inline uint32_t Hash(uint32_t sequence){
+    return (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+// write length that didn't fit in the token nibble
+// returns new output position or nullptr if output overflows
+static uint8_t* WriteLength(uint8_t* op, uint8_t* oend, size_t length){
+    while(length >= 255){
+        if(op >= oend) return nullptr;
+        *op++ = 255;
+        length -= 255;
+    }
+
+    if(op >= oend) return nullptr;
+    *op++ = uint8_t(length);
+    return op;
+}
+
+// emit a single sequence (literals + optional match)
+// matchLength is 0 for the last sequence
+static uint8_t* WriteSequence(uint8_t* op, uint8_t* oend, const uint8_t* literals, size_t numLiterals,
+                              size_t offset, size_t matchLength){
+    if(op >= oend) return nullptr;
+    uint8_t* token = op++;
+
+    // literal length
+    if(numLiterals >= 15){
+        *token = 15 << 4;
+        op = WriteLength(op, oend, numLiterals - 15);
+        if(op == nullptr) return nullptr;
+    }else{
+        *token = uint8_t(numLiterals << 4);
+    }
+
+    // copy literals
+    if(op + numLiterals > oend) return nullptr;
+    for(size_t i = 0; i < numLiterals; i++){
+        op[i] = literals[i];
+    }
+    op += numLiterals;
+
+    // last sequence doesn't have a match
+    if(matchLength == 0) return op;
+
+    // match offset
+    if(op + 2 > oend) return nullptr;
+    *op++ = uint8_t(offset & 0xff);
+    *op++ = uint8_t(offset >> 8);
+
+    // match length
+    matchLength -= LZ_MIN_MATCH;
+    if(matchLength >= 15){
+        *token |= 15;
+        op = WriteLength(op, oend, matchLength - 15);
+    }else{
+        *token |= uint8_t(matchLength);
+    }
+
+    return op;
+}
+
+// compress memory
+size_t LZCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity){
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dstCapacity;
+
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    // positions are stored in 16 bits
+    if(srcSize > 0x10000) return 0;
+
+    // stale entries don't matter since every candidate match is verified
+    memset(hashTable, 0, sizeof(hashTable));
+
+    if(srcSize > LZ_MFLIMIT){
+        const size_t matchLimit = srcSize - LZ_LAST_LITERALS;
+        const size_t inputLimit = srcSize - LZ_MFLIMIT;
+
+        while(ip < inputLimit){
+            uint32_t sequence = Read32(src + ip);
+            uint32_t h = Hash(sequence);
+            size_t ref = hashTable[h];
+            hashTable[h] = uint16_t(ip);
+
+            // check if we got a match
+            if((ref < ip) && (ip - ref <= LZ_MAX_OFFSET) && (Read32(src + ref) == sequence)){
+                // extend match as far as possible
+                size_t matchLength = LZ_MIN_MATCH;
+                while((ip + matchLength < matchLimit) && (src[ref + matchLength] == src[ip + matchLength])){
+                    matchLength++;
+                }
+
+                op = WriteSequence(op, oend, src + anchor, ip - anchor, ip - ref, matchLength);
+                if(op == nullptr) return 0;
+
+                ip += matchLength;
+                anchor = ip;
+            }else{
+                ip++;
+            }
+        }
+    }
+
+    // remaining bytes are literals
+    op = WriteSequence(op, oend, src + anchor, srcSize - anchor, 0, 0);
+    if(op == nullptr) return 0;
+
+    return size_t(op - dst);
+}
+
+// read length bytes following a nibble with value 15
+// returns false if input ends before length is complete
+static bool ReadLength(const uint8_t*& ip, const uint8_t* iend, size_t& length){
+    uint8_t b;
+    do {
+        if(ip >= iend) return false;
+        b = *ip++;
+        length += b;
+    } while(b == 255);
+
+    return true;
+}
+
+// decompress memory
+size_t LZDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity){
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dstCapacity;
+
+    while(ip < iend){
+        uint8_t token = *ip++;
+
+        // copy literals
+        size_t numLiterals = token >> 4;
+        if(numLiterals == 15 && !ReadLength(ip, iend, numLiterals)) return 0;
+        if((ip + numLiterals > iend) || (op + numLiterals > oend)) return 0;
+        for(size_t i = 0; i < numLiterals; i++){
+            op[i] = ip[i];
+        }
+        ip += numLiterals;
+        op += numLiterals;
+
+        // last sequence doesn't have a match
+        if(ip == iend) break;
+
+        // get match offset
+        if(ip + 2 > iend) return 0;
+        size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+        if(offset == 0 || offset > size_t(op - dst)) return 0;
+
+        // get match length
+        size_t matchLength = token & 0x0f;
+        if(matchLength == 15 && !ReadLength(ip, iend, matchLength)) return 0;
+        matchLength += LZ_MIN_MATCH;
+        if(op + matchLength > oend) return 0;
+
+        // copy byte by byte since match can overlap with output
+        const uint8_t* match = op - offset;
+        for(size_t i = 0; i < matchLength; i++){
+            op[i] = match[i];
+        }
+        op += matchLength;
+    }
+
+    return size_t(op - dst);
+}
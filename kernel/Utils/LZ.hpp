@@ -0,0 +1,67 @@
+/**
+ *@file LZ.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Fast LZ77 style codec (LZ4 like block format) used for compressing pages
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef UTILS_LZ_HPP
+#define UTILS_LZ_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// Block format is same as that of LZ4 :
+// every sequence starts with a token byte
+// high nibble is number of literals, low nibble is (match length - 4)
+// if any nibble is 15 then more length bytes follow (each adds upto 255)
+// literals are followed by a 2 byte little endian offset of the match
+// last sequence only has literals.
+//
+// The compressor doesn't try hard to find best match, it only
+// checks the last position where same 4 bytes were seen. This makes it fast
+// enough to be used in page reclaim path.
+
+// minimum length of a match
+#define LZ_MIN_MATCH 4
+
+// compress srcSize bytes from src into dst
+// returns size of compressed data or 0 if it doesn't fit into dstCapacity
+// NOTE : this is not reentrant, the hash table is a static buffer
+size_t LZCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+// decompress srcSize bytes from src into dst
+// returns decompressed size or 0 if the compressed data is corrupted
+// or does not fit into dstCapacity
+size_t LZDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+#endif // UTILS_LZ_HPP
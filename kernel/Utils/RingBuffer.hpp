@@ -0,0 +1,94 @@
+/**
+ *@file RingBuffer.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Lock free single producer single consumer ring buffer
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef UTILS_RINGBUFFER_HPP
+#define UTILS_RINGBUFFER_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Fixed size ring that can be used without locks between exactly one producer
+// and one consumer (eg: interrupt handler and a reader).
+// Producer only writes tail and consumer only writes head, each of them publishes
+// it's index with release and reads the other's with acquire.
+// Size must be a power of 2, one slot is always left empty to tell full from empty.
+template<typename T, size_t Size>
+struct RingBuffer{
+    static_assert((Size & (Size - 1)) == 0, "RingBuffer size must be a power of 2");
+
+    // add an element, returns false if ring is full
+    // must only be called by producer
+    bool Push(const T& value){
+        size_t tail = __atomic_load_n(&this->tail, __ATOMIC_RELAXED);
+        size_t next = (tail + 1) & (Size - 1);
+        if(next == __atomic_load_n(&head, __ATOMIC_ACQUIRE)){
+            return false;
+        }
+
+        buffer[tail] = value;
+        __atomic_store_n(&this->tail, next, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // remove an element, returns false if ring is empty
+    // must only be called by consumer
+    bool Pop(T& value){
+        size_t head = __atomic_load_n(&this->head, __ATOMIC_RELAXED);
+        if(head == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)){
+            return false;
+        }
+
+        value = buffer[head];
+        __atomic_store_n(&this->head, (head + 1) & (Size - 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // check if there's nothing to read
+    bool IsEmpty(){
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    }
+
+    // number of elements in ring
+    size_t GetCount(){
+        return (__atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_ACQUIRE)) & (Size - 1);
+    }
+
+    T buffer[Size];
+    size_t head;
+    size_t tail;
+};
+
+#endif // UTILS_RINGBUFFER_HPP
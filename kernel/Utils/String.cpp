@@ -35,8 +35,8 @@
 */
 
 #include "String.hpp"
+#include "../PerCpu.hpp"
 
-static char int_to_string_buffer[128];
 
 // get length of string
 size_t strlen(const char* str){
@@ -50,6 +50,9 @@ size_t strlen(const char* str){
 
 // convert uint64_t to string
 const char* itostr(int64_t n){
+    // each cpu converts in it's own buffer
+    char* int_to_string_buffer = GetCurrentCpuData()->intToStringBuffer;
+
     // get size of string
     uint8_t digits = 1;
 
@@ -81,6 +84,9 @@ const char* itostr(int64_t n){
 
 // convert uint64_t to string
 const char* utostr(uint64_t n){
+    // each cpu converts in it's own buffer
+    char* int_to_string_buffer = GetCurrentCpuData()->intToStringBuffer;
+
     // get size of string
     uint8_t digits = 1;
     uint64_t x = n;
@@ -102,6 +108,9 @@ const char* utostr(uint64_t n){
 
 // convert uint64_t to hex string
 const char* utohexstr(uint64_t n){
+    // each cpu converts in it's own buffer
+    char* int_to_string_buffer = GetCurrentCpuData()->intToStringBuffer;
+
     // calculate size of hex string
     uint8_t size = 0;
     uint64_t x = n;
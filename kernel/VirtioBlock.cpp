@@ -0,0 +1,204 @@
+/**
+ *@file VirtioBlock.cpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Driver for legacy virtio block devices (QEMU -drive if=virtio)
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "VirtioBlock.hpp"
+#include "PhysicalMemoryManager.hpp"
+#include "VirtualMemoryManager.hpp"
+#include "PCI.hpp"
+#include "IO.hpp"
+#include "Printf.hpp"
+#include "Utils/String.hpp"
+#include "Bootloader/BootInfo.hpp"
+
+// legacy interface needs descriptor table, available ring and used ring
+// to be physically contiguous with used ring aligned at page boundary.
+// PMM doesn't give contiguous pages so this memory is kept in kernel image,
+// which is loaded contiguously by the bootloader.
+#define VIRTQ_ALIGN PAGE_SIZE
+static uint8_t __attribute__((aligned(VIRTQ_ALIGN))) queueMemory[4*PAGE_SIZE];
+
+// used ring starts at first aligned address after descriptors and available ring
+static inline uint64_t GetUsedRingOffset(uint16_t size){
+    uint64_t descriptorsAndAvailable = sizeof(VirtqDescriptor) * size + sizeof(uint16_t) * (3 + size);
+    return (descriptorsAndAvailable + VIRTQ_ALIGN - 1) & ~(VIRTQ_ALIGN - 1);
+}
+
+// get size of memory needed for a queue of given size
+static inline uint64_t GetQueueMemorySize(uint16_t size){
+    return GetUsedRingOffset(size) + sizeof(uint16_t) * 3 + sizeof(VirtqUsedElement) * size;
+}
+
+// convert address of something in kernel image to physical address
+static inline uint64_t KernelToPhysical(uint64_t vaddr){
+    return vaddr - BootInfo::GetKernelVirtualBase() + BootInfo::GetKernelPhysicalBase();
+}
+
+// stop compiler from reordering memory accesses around ring updates
+// x86 doesn't reorder stores with other stores so this is enough
+static inline void CompilerBarrier(){
+    asm volatile("" ::: "memory");
+}
+
+// initialize device
+bool VirtioBlock::Initialize(){
+    PCIDevice device;
+    if(!FindPCIDevice(VIRTIO_VENDOR_ID, VIRTIO_BLOCK_DEVICE_ID, device)){
+        return false;
+    }
+
+    if(!device.IsIOBAR(0)){
+        Printf("[-] Virtio block device doesn't have legacy I/O BAR\n");
+        return false;
+    }
+
+    ioBase = uint16_t(device.GetBAR(0));
+    device.EnableCommand(PCI_COMMAND_IO_SPACE | PCI_COMMAND_BUS_MASTER);
+
+    // reset and tell device that we know how to drive it
+    PortWriteByte(ioBase + VIRTIO_REG_DEVICE_STATUS, 0);
+    PortWriteByte(ioBase + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    PortWriteByte(ioBase + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    // we don't need any optional feature
+    PortWriteDword(ioBase + VIRTIO_REG_GUEST_FEATURES, 0);
+
+    // setup request queue (queue 0)
+    PortWriteWord(ioBase + VIRTIO_REG_QUEUE_SELECT, 0);
+    queueSize = PortReadWord(ioBase + VIRTIO_REG_QUEUE_SIZE);
+    if((queueSize == 0) || (queueSize > VIRTIO_MAX_QUEUE_SIZE) ||
+       (GetQueueMemorySize(queueSize) > sizeof(queueMemory))){
+        Printf("[-] Unsupported virtio queue size : %u\n", queueSize);
+        PortWriteByte(ioBase + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_FAILED);
+        return false;
+    }
+
+    memset(queueMemory, 0, sizeof(queueMemory));
+    uint64_t queueBase = reinterpret_cast<uint64_t>(queueMemory);
+    descriptors = reinterpret_cast<volatile VirtqDescriptor*>(queueBase);
+    available = reinterpret_cast<volatile VirtqAvailable*>(queueBase + sizeof(VirtqDescriptor) * queueSize);
+    used = reinterpret_cast<volatile VirtqUsed*>(queueBase + GetUsedRingOffset(queueSize));
+    lastUsedIdx = 0;
+
+    // legacy interface takes page frame number of queue
+    PortWriteDword(ioBase + VIRTIO_REG_QUEUE_ADDRESS, uint32_t(KernelToPhysical(queueBase) / PAGE_SIZE));
+
+    // memory for request header and status
+    requestPage = PhysicalMemoryManager::AllocatePage();
+
+    // capacity is the first field in device configuration
+    capacity = uint64_t(PortReadDword(ioBase + VIRTIO_REG_DEVICE_CONFIG)) |
+        (uint64_t(PortReadDword(ioBase + VIRTIO_REG_DEVICE_CONFIG + 4)) << 32);
+
+    PortWriteByte(ioBase + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+    isPresent = true;
+
+    Printf("[+] Virtio block device : %lu KB, queue size %u\n", capacity * VIRTIO_BLK_SECTOR_SIZE / KB, queueSize);
+    return true;
+}
+
+bool VirtioBlock::IsPresent(){ return isPresent; }
+uint64_t VirtioBlock::GetCapacity(){ return capacity; }
+
+// submit request
+bool VirtioBlock::Submit(uint32_t type, uint64_t sector, const uint64_t* pages, size_t n){
+    if(!isPresent || (n == 0) || (n > VIRTIO_BLK_MAX_PAGES) || (n + 2 > queueSize)){
+        return false;
+    }
+
+    if(sector + n * (PAGE_SIZE / VIRTIO_BLK_SECTOR_SIZE) > capacity){
+        return false;
+    }
+
+    // fill request header and status
+    VirtioBlockRequest* request = reinterpret_cast<VirtioBlockRequest*>(requestPage);
+    request->type = type;
+    request->reserved = 0;
+    request->sector = sector;
+
+    volatile uint8_t* status = reinterpret_cast<volatile uint8_t*>(requestPage + sizeof(VirtioBlockRequest));
+    *status = 0xff;
+
+    uint64_t requestPhys = requestPage - MEM_PHYS_OFFSET;
+
+    // chain : header -> data pages -> status
+    // since only one request is in flight, descriptor chain always starts at 0
+    descriptors[0].address = requestPhys;
+    descriptors[0].length = sizeof(VirtioBlockRequest);
+    descriptors[0].flags = VIRTQ_DESC_F_NEXT;
+    descriptors[0].next = 1;
+
+    for(size_t i = 0; i < n; i++){
+        volatile VirtqDescriptor& d = descriptors[i + 1];
+        d.address = pages[i] - MEM_PHYS_OFFSET;
+        d.length = PAGE_SIZE;
+        // device writes to data pages when we read from disk
+        d.flags = VIRTQ_DESC_F_NEXT | ((type == VIRTIO_BLK_T_IN) ? VIRTQ_DESC_F_WRITE : 0);
+        d.next = uint16_t(i + 2);
+    }
+
+    descriptors[n + 1].address = requestPhys + sizeof(VirtioBlockRequest);
+    descriptors[n + 1].length = 1;
+    descriptors[n + 1].flags = VIRTQ_DESC_F_WRITE;
+    descriptors[n + 1].next = 0;
+
+    // make chain available to device
+    available->ring[available->idx % queueSize] = 0;
+    CompilerBarrier();
+    available->idx = available->idx + 1;
+    CompilerBarrier();
+    PortWriteWord(ioBase + VIRTIO_REG_QUEUE_NOTIFY, 0);
+
+    // wait for completion
+    while(used->idx == lastUsedIdx){
+        asm volatile("pause");
+    }
+    lastUsedIdx++;
+
+    // reading isr status acknowledges the interrupt
+    PortReadByte(ioBase + VIRTIO_REG_ISR_STATUS);
+
+    return *status == 0;
+}
+
+// read pages
+bool VirtioBlock::ReadPages(uint64_t sector, const uint64_t* pages, size_t n){
+    return Submit(VIRTIO_BLK_T_IN, sector, pages, n);
+}
+
+// write pages
+bool VirtioBlock::WritePages(uint64_t sector, const uint64_t* pages, size_t n){
+    return Submit(VIRTIO_BLK_T_OUT, sector, pages, n);
+}
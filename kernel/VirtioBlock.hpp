@@ -0,0 +1,160 @@
+/**
+ *@file VirtioBlock.hpp
+ *@author Siddharth Mishra (brightprogrammer)
+ *@date 10/19/2026
+ *@brief Driver for legacy virtio block devices (QEMU -drive if=virtio)
+ *@copyright BSD 3-Clause License
+
+ Copyright (c) 2022, Siddharth Mishra
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef VIRTIOBLOCK_HPP
+#define VIRTIOBLOCK_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// legacy (transitional) virtio block device
+#define VIRTIO_VENDOR_ID 0x1af4
+#define VIRTIO_BLOCK_DEVICE_ID 0x1001
+
+// legacy virtio registers (offsets in I/O BAR0)
+#define VIRTIO_REG_DEVICE_FEATURES 0x00
+#define VIRTIO_REG_GUEST_FEATURES 0x04
+#define VIRTIO_REG_QUEUE_ADDRESS 0x08
+#define VIRTIO_REG_QUEUE_SIZE 0x0c
+#define VIRTIO_REG_QUEUE_SELECT 0x0e
+#define VIRTIO_REG_QUEUE_NOTIFY 0x10
+#define VIRTIO_REG_DEVICE_STATUS 0x12
+#define VIRTIO_REG_ISR_STATUS 0x13
+// device specific configuration starts here (when MSI-X is disabled)
+#define VIRTIO_REG_DEVICE_CONFIG 0x14
+
+// device status bits
+#define VIRTIO_STATUS_ACKNOWLEDGE 1
+#define VIRTIO_STATUS_DRIVER 2
+#define VIRTIO_STATUS_DRIVER_OK 4
+#define VIRTIO_STATUS_FAILED 128
+
+// virtqueue descriptor flags
+#define VIRTQ_DESC_F_NEXT 1
+#define VIRTQ_DESC_F_WRITE 2
+
+// block request types
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+
+// size of a sector on virtio block device
+#define VIRTIO_BLK_SECTOR_SIZE 512
+
+// max queue size this driver can handle
+// memory for queue is statically allocated
+#define VIRTIO_MAX_QUEUE_SIZE 256
+
+// max pages that can be transferred in a single request
+#define VIRTIO_BLK_MAX_PAGES 32
+
+// virtqueue descriptor
+struct VirtqDescriptor{
+    uint64_t address;
+    uint32_t length;
+    uint16_t flags;
+    uint16_t next;
+} __attribute__((packed));
+
+// ring of descriptors made available to device
+struct VirtqAvailable{
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];
+} __attribute__((packed));
+
+// element of used ring
+struct VirtqUsedElement{
+    uint32_t id;
+    uint32_t length;
+} __attribute__((packed));
+
+// ring of descriptors device is done with
+struct VirtqUsed{
+    uint16_t flags;
+    uint16_t idx;
+    VirtqUsedElement ring[];
+} __attribute__((packed));
+
+// header of each block request
+struct VirtioBlockRequest{
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} __attribute__((packed));
+
+// Only a single device with a single request queue is supported.
+// Requests are synchronous, driver waits for device to complete the
+// request by polling the used ring. This keeps it usable from page fault path.
+struct VirtioBlock{
+    // find and initialize first virtio block device
+    // returns false if device is not present
+    static bool Initialize();
+
+    // check if device is present and initialized
+    static bool IsPresent();
+
+    // capacity of device in sectors
+    static uint64_t GetCapacity();
+
+    // read n pages starting at given sector
+    // pages contains virtual addresses (with higher half offset) of pages
+    static bool ReadPages(uint64_t sector, const uint64_t* pages, size_t n);
+
+    // write n pages starting at given sector
+    static bool WritePages(uint64_t sector, const uint64_t* pages, size_t n);
+private:
+    // submit request and wait for it to complete
+    static bool Submit(uint32_t type, uint64_t sector, const uint64_t* pages, size_t n);
+
+    static inline bool isPresent = false;
+
+    // base of I/O BAR
+    static inline uint16_t ioBase = 0;
+    // capacity in sectors
+    static inline uint64_t capacity = 0;
+
+    // virtqueue
+    static inline uint16_t queueSize = 0;
+    static inline volatile VirtqDescriptor* descriptors = nullptr;
+    static inline volatile VirtqAvailable* available = nullptr;
+    static inline volatile VirtqUsed* used = nullptr;
+    static inline uint16_t lastUsedIdx = 0;
+
+    // request header and status byte are kept in one page
+    static inline uint64_t requestPage = 0;
+};
+
+#endif // VIRTIOBLOCK_HPP
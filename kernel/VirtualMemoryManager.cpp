@@ -38,10 +38,33 @@
 #include "PhysicalMemoryManager.hpp"
 #include "Utils/String.hpp"
 #include "Printf.hpp"
+#include "Swap.hpp"
+#include "SamePageMerging.hpp"
+#include "CPU.hpp"
+#include "Tlb.hpp"
 
 #include "Bootloader/BootInfo.hpp"
 
 #define PAGE_PHYSICAL_ADDRESS_MASK 0x000ffffffffff000
+// swap entry can use all bits except present, flags and nx bit
+#define PAGE_SWAP_ENTRY_MASK 0x7ffffffffffff000
+
+// defined in linker script, all of these are 2MiB aligned except data end
+extern "C" uint8_t KernelTextStart[], KernelTextEnd[];
+extern "C" uint8_t KernelRodataStart[], KernelRodataEnd[];
+extern "C" uint8_t KernelDataStart[], KernelDataEnd[];
+
+// default vmm, global constructors are never run so only a pointer is kept here
+// and the object itself lives on kernel entry's stack which is never reused
+static VirtualMemoryManager* DefaultVirtualMemoryManager = nullptr;
+
+void SetDefaultVirtualMemoryManager(VirtualMemoryManager& vmm){
+    DefaultVirtualMemoryManager = &vmm;
+}
+
+VirtualMemoryManager& GetDefaultVirtualMemoryManager(){
+    return *DefaultVirtualMemoryManager;
+}
 
 // turn on given flags
 void Page::SetFlags(uint64_t flags){
@@ -70,10 +93,77 @@ void Page::SetAddress(uint64_t address){
     value |= (address << 12) & PAGE_PHYSICAL_ADDRESS_MASK;
 }
 
+// check if page is swapped out
+bool Page::IsSwapped(){
+    return !GetFlags(MAP_PRESENT) && GetFlags(MAP_SWAPPED);
+}
+
+// get swap entry
+uint64_t Page::GetSwapEntry(){
+    return (value & PAGE_SWAP_ENTRY_MASK) >> 12;
+}
+
+// store swap entry in place of address
+void Page::SetSwapEntry(uint64_t entry){
+    value &= ~(PAGE_SWAP_ENTRY_MASK | MAP_PRESENT);
+    value |= ((entry << 12) & PAGE_SWAP_ENTRY_MASK) | MAP_SWAPPED;
+}
+
+// remove swap entry
+void Page::ClearSwapEntry(){
+    value &= ~(PAGE_SWAP_ENTRY_MASK | MAP_SWAPPED);
+}
+
+// enable no execute bit in page tables if cpu supports it
+// returns false if not supported
+static bool EnableNoExecute(){
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(0x80000000, 0, eax, ebx, ecx, edx);
+    if(eax < 0x80000001){
+        return false;
+    }
+
+    CPUID(0x80000001, 0, eax, ebx, ecx, edx);
+    if(!(edx & CPUID_EXT_EDX_NO_EXECUTE)){
+        return false;
+    }
+
+    WriteMSR(MSR_EFER, ReadMSR(MSR_EFER) | EFER_NO_EXECUTE_ENABLE);
+    return true;
+}
+
+// cpu can do 5 level paging but bootloader left it in 4 level mode
+static void ReportMissingLA57(){
+    uint32_t eax, ebx, ecx, edx;
+    CPUID(0, 0, eax, ebx, ecx, edx);
+    if(eax < 7){
+        return;
+    }
+
+    CPUID(7, 0, eax, ebx, ecx, edx);
+    if(!(ecx & CPUID_7_ECX_LA57)){
+        return;
+    }
+
+#ifdef ENABLE_5_LEVEL_PAGING
+    Printf("[!] CPU supports 5 level paging but bootloader didn't enable it\n");
+#else
+    Printf("[!] CPU supports 5 level paging, build has ENABLE_5_LEVEL_PAGING turned off\n");
+#endif
+}
+
 VirtualMemoryManager::VirtualMemoryManager(){
+    // paging mode is decided by bootloader and can't be changed from long mode
+    // so new page tables must have same number of levels as the current ones
+    pagingLevels = (ReadCR4() & CR4_LA57) ? 5 : 4;
+    pageTableLock.SetName("page tables");
+
     // create's page table root entry
     CreatePageMap();
 
+    // nx bit must be enabled before any page using it is loaded
+    uint64_t noExecute = EnableNoExecute() ? uint64_t(MAP_NO_EXECUTE) : 0;
+
     MemMapEntry* memmap = BootInfo::GetMemmap();
     uint64_t memmapCount = BootInfo::GetMemmapCount();
 
@@ -90,15 +180,17 @@ VirtualMemoryManager::VirtualMemoryManager(){
                 uint64_t vaddr = MEM_PHYS_OFFSET + paddr;
                 MapMemory(vaddr, paddr, MAP_PRESENT | MAP_READ_WRITE);
             }
-        }else{
-            for(size_t p = 0; p < memmap[i].length; p += PAGE_SIZE){
-                uint64_t paddr = memmap[i].base + p;
-                uint64_t vaddr = KERNEL_VIRT_BASE + p;
-                MapMemory(vaddr, paddr, MAP_PRESENT | MAP_READ_WRITE);
-            }
         }
     }
 
+    // kernel image is mapped section by section, each with it's own permissions
+    MapKernelRange(reinterpret_cast<uint64_t>(KernelTextStart), reinterpret_cast<uint64_t>(KernelTextEnd),
+                   MAP_PRESENT);
+    MapKernelRange(reinterpret_cast<uint64_t>(KernelRodataStart), reinterpret_cast<uint64_t>(KernelRodataEnd),
+                   MAP_PRESENT | noExecute);
+    MapKernelRange(reinterpret_cast<uint64_t>(KernelDataStart), reinterpret_cast<uint64_t>(KernelDataEnd),
+                   MAP_PRESENT | MAP_READ_WRITE | noExecute);
+
     // uint64_t krnlPhysBase = BootInfo::GetKernelPhysicalBase();
     // for (uintptr_t p = 0; p < 2*GB; p += PAGE_SIZE){
     //     uint64_t paddr = krnlPhysBase + p;
@@ -108,18 +200,46 @@ VirtualMemoryManager::VirtualMemoryManager(){
 
     // load page table into cr3 register
     LoadPageTable();
+
+    Printf("[+] Using %u level paging, direct map at %lx\n", pagingLevels, MEM_PHYS_OFFSET);
+    if(pagingLevels == 4){
+        ReportMissingLA57();
+    }
+
+    // make kernel respect read only pages too, copy on write depends on this
+    WriteCR0(ReadCR0() | CR0_WRITE_PROTECT);
+}
+
+// map part of kernel image
+void VirtualMemoryManager::MapKernelRange(uint64_t start, uint64_t end, uint64_t flags){
+    uint64_t physBase = BootInfo::GetKernelPhysicalBase();
+    uint64_t virtBase = BootInfo::GetKernelVirtualBase();
+
+    uint64_t vaddr = start;
+    while(vaddr < end){
+        uint64_t paddr = vaddr - virtBase + physBase;
+
+        // a large page can be used only if it doesn't go past the section
+        if((vaddr % LARGE_PAGE_SIZE == 0) && (paddr % LARGE_PAGE_SIZE == 0) && (end - vaddr >= LARGE_PAGE_SIZE)){
+            MapLargePage(vaddr, paddr, flags);
+            vaddr += LARGE_PAGE_SIZE;
+        }else{
+            MapMemory(vaddr, paddr, flags);
+            vaddr += PAGE_SIZE;
+        }
+    }
 }
 
 // this will create the root node of the page map tree
 void VirtualMemoryManager::CreatePageMap(){
-    if(pml4 == nullptr){
+    if(pageMapRoot == nullptr){
         // create new page map
-        uint64_t pml4VirtualAddress = PhysicalMemoryManager::AllocatePage();
-        pml4PhysicalAddress = pml4VirtualAddress - MEM_PHYS_OFFSET;
-        pml4 = reinterpret_cast<PageTable*>(pml4VirtualAddress);
+        uint64_t rootVirtualAddress = PhysicalMemoryManager::AllocatePage();
+        pageMapRootPhysicalAddress = rootVirtualAddress - MEM_PHYS_OFFSET;
+        pageMapRoot = reinterpret_cast<PageTable*>(rootVirtualAddress);
 
         // and set all elements to 0
-        memset(pml4, 0, PAGE_SIZE);
+        memset(pageMapRoot, 0, PAGE_SIZE);
     }else{
         Printf("[!] Attempt to recreate prexisting root level page map!\n");
     }
@@ -129,7 +249,7 @@ void VirtualMemoryManager::LoadPageTable(){
     // load the page map table in cr3 register
     asm volatile("mov %0, %%cr3"
                  :
-                 : "r" (pml4PhysicalAddress)); // map takes
+                 : "r" (pageMapRootPhysicalAddress)); // map takes
 }
 
 // get next level of paging
@@ -151,7 +271,9 @@ PageTable* VirtualMemoryManager::GetNextLevel(PageTable* pageTable, uint64_t ent
         memset(reinterpret_cast<void*>(pt), 0, PAGE_SIZE);
 
         // shift by 12 biits to align it to 0x1000 boundary
+        // lookups without lock may see this entry as soon as it's present, so that's set last
         pte->SetAddress(paddr >> 12);
+        __atomic_signal_fence(__ATOMIC_RELEASE);
         pte->SetFlags(MAP_PRESENT | MAP_READ_WRITE);
     }else{
         uint64_t paddr = pte->GetAddress() << 12;
@@ -163,68 +285,173 @@ PageTable* VirtualMemoryManager::GetNextLevel(PageTable* pageTable, uint64_t ent
 }
 
 // map given physical memory to virtual memory wiht given flags
+// allocating a level may have to reclaim memory, which does tlb shootdowns
+// so lock is taken in a way that keeps answering them
 void VirtualMemoryManager::MapMemory(uint64_t virtualAddress, uint64_t physicalAddress, uint64_t flags){
+    uint64_t rflags = Tlb::LockIrqSave(pageTableLock);
+
     // get page table entry
-    Page* pte = GetPage(virtualAddress, true);
-    if(pte == nullptr) return;
+    Page* pte = WalkToPage(virtualAddress, true);
+    if(pte != nullptr){
+        // map physical address 4kb aligned
+        pte->SetAddress(physicalAddress >> 12);
+        pte->SetFlags(flags);
+    }
 
-    // map physical address 4kb aligned
-    pte->SetAddress(physicalAddress >> 12);
-    pte->SetFlags(flags);
+    pageTableLock.UnlockIrqRestore(rflags);
 }
 
-// get's you a single page corresponding to the given virtual address:w
-Page* VirtualMemoryManager::GetPage(uint64_t vaddr, bool allocate){
-    // cache this value
-    uint64_t virtualAddr = vaddr;
-
-    // get page index
-    vaddr >>= 12;
-    uint64_t pageIndex = vaddr & 0x1ff; // 0x1ff = 511 or 512 - 1
+// map a 2mb page
+void VirtualMemoryManager::MapLargePage(uint64_t virtualAddress, uint64_t physicalAddress, uint64_t flags){
+    uint64_t rflags = Tlb::LockIrqSave(pageTableLock);
 
-    // find table index
-    vaddr >>= 9;
-    uint64_t pml1Index = vaddr & 0x1ff;
+    PageTable* pml2 = GetPageDirectory(virtualAddress, true);
+    if(pml2 != nullptr){
+        // page directory entry points directly to the page
+        Page* pde = &pml2->entries[(virtualAddress >> 21) & 0x1ff];
+        pde->SetAddress(physicalAddress >> 12);
+        pde->SetFlags(flags | MAP_LARGER_PAGES);
+    }
 
-    // find page directory index
-    vaddr >>= 9;
-    uint64_t pml2Index = vaddr & 0x1ff;
+    pageTableLock.UnlockIrqRestore(rflags);
+}
 
+// walk down to page directory
+// number of levels is known at compile time so 4 level walk doesn't pay for 5th level
+template<uint8_t Levels>
+PageTable* VirtualMemoryManager::WalkToPageDirectory(uint64_t vaddr, bool allocate){
     // find page directory pointer index
-    vaddr >>= 9;
-    uint64_t pml3Index = vaddr & 0x1ff;
+    uint64_t pml3Index = (vaddr >> 30) & 0x1ff;
+    // find pml4 index
+    uint64_t pml4Index = (vaddr >> 39) & 0x1ff;
+
+    PageTable* pml4 = pageMapRoot;
+    if constexpr (Levels == 5){
+        // get pml4 from pml5
+        pml4 = GetNextLevel(pageMapRoot, (vaddr >> 48) & 0x1ff, allocate);
+        if(pml4 == nullptr){
+            // it's normal for a lookup to fail, so complain only when allocation fails
+            if(allocate) Printf("[-] PML4 for vaddr(%lx) doesn't exists or failed to allocate\n", vaddr);
+            return nullptr;
+        }
+    }
 
     // get page directory pointer from PML4
-    PageTable* pml3 = GetNextLevel(pml4, pml3Index, allocate);
+    PageTable* pml3 = GetNextLevel(pml4, pml4Index, allocate);
     if(pml3 == nullptr){
-        Printf("[-] PML3 for vaddr(%lx) doesn't exists or failed to allocate\n", virtualAddr);
+        if(allocate) Printf("[-] PML3 for vaddr(%lx) doesn't exists or failed to allocate\n", vaddr);
         return nullptr;
     }
 
     // get page directory from page directory pointer
-    PageTable* pml2 = GetNextLevel(pml3, pml2Index, allocate);
+    PageTable* pml2 = GetNextLevel(pml3, pml3Index, allocate);
     if(pml2 == nullptr){
-        Printf("[-] PML2 for vaddr(%lx) doesn't exists or failed to allocate\n", virtualAddr);
+        if(allocate) Printf("[-] PML2 for vaddr(%lx) doesn't exists or failed to allocate\n", vaddr);
         return nullptr;
     }
 
+    return pml2;
+}
+
+// pick walk for current paging mode
+PageTable* VirtualMemoryManager::GetPageDirectory(uint64_t vaddr, bool allocate){
+    if(pagingLevels == 5){
+        return WalkToPageDirectory<5>(vaddr, allocate);
+    }
+
+    return WalkToPageDirectory<4>(vaddr, allocate);
+}
+
+// get's you a single page corresponding to the given virtual address
+Page* VirtualMemoryManager::GetPage(uint64_t vaddr, bool allocate){
+    if(!allocate){
+        return WalkToPage(vaddr, false);
+    }
+
+    uint64_t rflags = Tlb::LockIrqSave(pageTableLock);
+    Page* page = WalkToPage(vaddr, true);
+    pageTableLock.UnlockIrqRestore(rflags);
+    return page;
+}
+
+// walk down to page table entry
+Page* VirtualMemoryManager::WalkToPage(uint64_t vaddr, bool allocate){
+    // get page index
+    uint64_t pageIndex = (vaddr >> 12) & 0x1ff; // 0x1ff = 511 or 512 - 1
+    // find page directory index
+    uint64_t pml2Index = (vaddr >> 21) & 0x1ff;
+
+    // get page directory
+    PageTable* pml2 = GetPageDirectory(vaddr, allocate);
+    if(pml2 == nullptr){
+        return nullptr;
+    }
+
+    // large page, there's no page table below this
+    Page* pde = &pml2->entries[pml2Index];
+    if(pde->GetFlags(MAP_PRESENT) && pde->GetFlags(MAP_LARGER_PAGES)){
+        return pde;
+    }
 
     // get page table from page directory
-    PageTable* pml1 = GetNextLevel(pml2, pml1Index, allocate);
+    PageTable* pml1 = GetNextLevel(pml2, pml2Index, allocate);
     if(pml1 == nullptr){
-        Printf("[-] PML1 for vaddr(%lx) doesn't exists or failed to allocate\n", virtualAddr);
+        if(allocate) Printf("[-] PML1 for vaddr(%lx) doesn't exists or failed to allocate\n", vaddr);
         return nullptr;
     }
 
-
     // get page from page table
-    Page *pte = &pml1->entries[pageIndex];
-    if(pte == nullptr){
-        Printf("[-] Page Table Entry for vaddr(%lx) doesn't exists or failed to allocate\n", virtualAddr);
-        return nullptr;
+    return &pml1->entries[pageIndex];
+}
+
+// map mmio region
+uint64_t VirtualMemoryManager::MapDeviceMemory(uint64_t physicalAddress, uint64_t size){
+    uint64_t start = physicalAddress & ~uint64_t(PAGE_SIZE - 1);
+    uint64_t end = physicalAddress + size;
+
+    for(uint64_t paddr = start; paddr < end; paddr += PAGE_SIZE){
+        MapMemory(paddr + MEM_PHYS_OFFSET, paddr, MAP_PRESENT | MAP_READ_WRITE | MAP_CACHE_DISABLED | MAP_WRITE_THROUGH);
+        InvalidatePage(paddr + MEM_PHYS_OFFSET);
+    }
+
+    return physicalAddress + MEM_PHYS_OFFSET;
+}
+
+// allocate and map anonymous memory
+void VirtualMemoryManager::AllocateAnonymousMemory(uint64_t vaddr, uint64_t size, uint64_t flags){
+    for(uint64_t p = 0; p < size; p += PAGE_SIZE){
+        if(flags & MAP_READ_WRITE){
+            // reads are served by zero page, first write will allocate
+            uint64_t zeroPage = SamePageMerging::GetZeroPage();
+            MapMemory(vaddr + p, zeroPage - MEM_PHYS_OFFSET, (flags & ~uint64_t(MAP_READ_WRITE)) | MAP_PRESENT | MAP_COPY_ON_WRITE);
+        }else{
+            uint64_t page = PhysicalMemoryManager::AllocatePage();
+            memset(reinterpret_cast<void*>(page), 0, PAGE_SIZE);
+            MapMemory(vaddr + p, page - MEM_PHYS_OFFSET, flags | MAP_PRESENT);
+        }
+        InvalidatePage(vaddr + p);
+
+        // let reclaim path know about this page
+        Swap::TrackPage(vaddr + p);
     }
+}
+
+// stacks are never freed, so a bump pointer is enough
+uint64_t VirtualMemoryManager::AllocateKernelStack(uint64_t size){
+    size = (size + PAGE_SIZE - 1) & ~uint64_t(PAGE_SIZE - 1);
+
+    // leave guard page unmapped
+    uint64_t base = __atomic_fetch_add(&nextKernelStack, size + PAGE_SIZE, __ATOMIC_RELAXED) + PAGE_SIZE;
 
-//     while(true) asm("hlt");
+    // nx bit is reserved if not enabled
+    uint64_t noExecute = (ReadMSR(MSR_EFER) & EFER_NO_EXECUTE_ENABLE) ? uint64_t(MAP_NO_EXECUTE) : 0;
+
+    // stacks are not tracked by swap, they must always be present
+    for(uint64_t p = 0; p < size; p += PAGE_SIZE){
+        uint64_t page = PhysicalMemoryManager::AllocatePage();
+        MapMemory(base + p, page - MEM_PHYS_OFFSET, MAP_PRESENT | MAP_READ_WRITE | noExecute);
+        InvalidatePage(base + p);
+    }
 
-    return pte;
+    return base + size;
 }
@@ -38,9 +38,20 @@
 #define VIRTUALMEMORYMANAGER_HPP
 
 #include <cstdint>
+#include "Bootloader/BootInfo.hpp"
+#include "SpinLock.hpp"
 
-#define MEM_PHYS_OFFSET uint64_t(0xffff800000000000)
+// physical memory is mapped at this offset in higher half
+// this depends on number of paging levels so it's given by bootloader
+#define MEM_PHYS_OFFSET BootInfo::higherHalfOffset
 #define KERNEL_VIRT_BASE uint64_t(0xffffffff80000000)
+// kernel stacks (interrupt stacks, thread stacks) are mapped here
+// each stack has an unmapped guard page below it so an overflow faults instead of corrupting memory
+#define KERNEL_STACK_REGION_BASE uint64_t(0xffffffffc0000000)
+// anonymous memory (see AllocateAnonymousMemory) is mapped here, between kernel image and stacks
+#define ANONYMOUS_MEMORY_BASE uint64_t(0xffffffffa0000000)
+// size of a page mapped directly by page directory entry
+#define LARGE_PAGE_SIZE uint64_t(0x200000)
 
 enum PageFlags {
     MAP_PRESENT = 1 << 0,
@@ -53,7 +64,12 @@ enum PageFlags {
     MAP_CUSTOM0 = 1 << 9,
     MAP_CUSTOM1 = 1 << 10,
     MAP_CUSTOM2 = 1 << 11,
-    MAP_NO_EXECUTE = uint64_t(1) << 63 // only if supported
+    MAP_NO_EXECUTE = uint64_t(1) << 63, // only if supported
+
+    // set in a non present page when page contents are in swap
+    MAP_SWAPPED = MAP_CUSTOM0,
+    // set in a read only page that is shared and must be copied on first write
+    MAP_COPY_ON_WRITE = MAP_CUSTOM1
 };
 
 // page and page directory pointer use the same structure
@@ -69,6 +85,18 @@ struct Page {
     void SetAddress(uint64_t address);
     // get physical address (4kb aligned always)
     uint64_t GetAddress();
+
+    // when a page is swapped out, cpu ignores all bits of a non present page
+    // so we store where the page went in place of physical address
+    // check if this page is swapped out
+    bool IsSwapped();
+    // get swap entry stored in this page
+    uint64_t GetSwapEntry();
+    // mark this page as not present and store given swap entry in it
+    // rest of the flags are kept so that they can be restored on swap in
+    void SetSwapEntry(uint64_t entry);
+    // remove swap entry, after this address can be set again
+    void ClearSwapEntry();
 };
 
 
@@ -79,6 +107,10 @@ struct PageTable {
 
 
 // vmm implementation
+// Page tables are changed under pageTableLock, so cpus mapping at the same time (thread stacks,
+// device memory, anonymous memory) don't allocate the same level twice. It's taken with interrupts
+// disabled since page fault handlers map too. Lookups that don't allocate don't take it, page tables
+// are never freed and a level is linked only after it's filled.
 struct VirtualMemoryManager{
     // create virtual memory manager
     VirtualMemoryManager();
@@ -87,26 +119,75 @@ struct VirtualMemoryManager{
     // after physical and virtual address, you pass flags
     void MapMemory(uint64_t virtualAddress, uint64_t physicalAddress, uint64_t flags);
 
+    // map a 2MiB page, both addresses must be 2MiB aligned
+    void MapLargePage(uint64_t virtualAddress, uint64_t physicalAddress, uint64_t flags);
+
     // create page mapping
     void CreatePageMap();
 
     // get page for given virtual address
     // if allocate is true then required page and page tables
     // will be allocated if not already allocated
+    // if address is mapped by a large page then page directory entry is returned
     Page* GetPage(uint64_t vaddr, bool allocate);
 
     // load this page table in cr3 register
     void LoadPageTable();
+
+    // number of page table levels in use (4 or 5)
+    static uint8_t GetPagingLevels(){ return pagingLevels; }
+
+    // map device registers in direct map region with caching disabled
+    // returns virtual address at which physical address can be accessed
+    uint64_t MapDeviceMemory(uint64_t physicalAddress, uint64_t size);
+
+    // map zeroed pages of anonymous memory at given virtual address
+    // these pages are not backed by anything and can be swapped out
+    // when system runs low on memory
+    // writable pages are mapped to shared zero page and get a frame on first write
+    void AllocateAnonymousMemory(uint64_t vaddr, uint64_t size, uint64_t flags);
+
+    // allocate and map a kernel stack of given size (rounded up to page size)
+    // returns top of stack (stack grows down)
+    uint64_t AllocateKernelStack(uint64_t size);
 private:
 
+    // map kernel image range with given flags, uses large pages wherever alignment allows
+    void MapKernelRange(uint64_t start, uint64_t end, uint64_t flags);
+
+    // GetPage without taking the lock, caller holds it if allocate is true
+    Page* WalkToPage(uint64_t vaddr, bool allocate);
+
     // get's the next level in page table tree
     PageTable* GetNextLevel(PageTable* pageTable, uint64_t entryIndex, bool allocate);
 
-    // root element of the page map tree
-    PageTable* pml4 = nullptr;
+    // get page directory (pml2) that contains given virtual address
+    PageTable* GetPageDirectory(uint64_t vaddr, bool allocate);
+
+    // page table walk from root to page directory for given number of levels
+    template<uint8_t Levels>
+    PageTable* WalkToPageDirectory(uint64_t vaddr, bool allocate);
+
+    // root element of the page map tree (pml4 or pml5)
+    PageTable* pageMapRoot = nullptr;
+
+    // store root physicall address
+    uint64_t pageMapRootPhysicalAddress = 0;
 
-    // store pml4 physicall address
-    uint64_t pml4PhysicalAddress = 0;
+    // held while page tables are changed
+    SpinLock pageTableLock = {};
+
+    // same for all page maps
+    static inline uint8_t pagingLevels = 4;
+
+    // next free address in kernel stack region, shared by all page maps
+    static inline uint64_t nextKernelStack = KERNEL_STACK_REGION_BASE;
 };
 
+// create default virtual memory manager
+void SetDefaultVirtualMemoryManager(VirtualMemoryManager& vmm);
+// get default virtual memory manager
+// this is the one that is currently loaded in cr3
+VirtualMemoryManager& GetDefaultVirtualMemoryManager();
+
 #endif // VIRTUALMEMORYMANAGER_HPP